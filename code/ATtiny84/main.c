@@ -26,6 +26,13 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/power.h>
+#include <avr/sleep.h>
+#if defined(SNES2DB9_ENABLE_CD32) || defined(SNES2DB9_ENABLE_PADDLE) || defined(SNES2DB9_ENABLE_TELEMETRY) || defined(SNES2DB9_ENABLE_HW_CLOCK)
+#include <util/atomic.h>
+#endif
+#if defined(SNES2DB9_ENABLE_MACRO_EEPROM) || defined(SNES2DB9_ENABLE_PROFILES) || defined(SNES2DB9_ENABLE_CLOCK_CALIBRATION)
+#include <avr/eeprom.h>
+#endif
 
 #include "snes2db9.h"
 #include "attiny84-gpio.h"
@@ -33,29 +40,253 @@
 #define NR_200US_TICKS_PER_MS (5)          /**< number of 200µs ticks per ms */
 #define DB9_UPDATE_TASK_CYCLE_IN_MS (16)   /**< number of ms for update of DB9 state */
 #define NR_200US_TICKS_DB9_UPDATE_TASK (NR_200US_TICKS_PER_MS * DB9_UPDATE_TASK_CYCLE_IN_MS)  /**< number of 200µs ticks until DB9 update is triggered */
+#define NR_200US_TICKS_READER_TASK (1)     /**< number of 200µs ticks per SNES reader step */
+#define TIMER0_COUNTS_PER_TICK (100)       /**< counts of the tick timer per 200µs tick, 2µs each */
 #define STARTUP_TIME_IN_MS (3000)          /**< startup duration in ms, SNES input is ignored during startup to avoid flickery signals */
 
+#ifdef SNES2DB9_ENABLE_IDLE_POLL
+#define IDLE_POLL_AFTER_MS (5000)          /**< time without pressed buttons until the SNES gamepad is read less often */
+#define IDLE_POLL_DIVIDER  (4)             /**< idle polling reads every n-th DB9 update cycle, delays the first press by up to (n-1) cycles */
+#endif
+
+#ifdef SNES2DB9_ENABLE_WCET_PROBE
+#define WCET_MARK(id)  GPIOR0 = ( id )     /**< reports a task boundary to the simavr WCET harness, single OUT instruction */
+#else
+#define WCET_MARK(id)                      /**< WCET probe disabled */
+#endif
+#define WCET_READER_BEGIN  0x20            /**< marker: ReaderTask() starts */
+#define WCET_READER_END    0x21            /**< marker: ReaderTask() ends */
+#define WCET_DB9_BEGIN     0x30            /**< marker: DB9UpdateTask() starts */
+#define WCET_DB9_END       0x31            /**< marker: DB9UpdateTask() ends */
+
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+#ifndef SNES2DB9_PROBE_MARKERS
+#define SNES2DB9_PROBE_MARKERS SNES2DB9_PROBE_ALL  /**< markers output on the probe pin, composed of SNES2DB9_PROBE_MASK() bits */
+#endif
+#define PROBE_PULSE_CYCLES (8)             /**< width of a probe pulse and of the pause after it in CPU cycles, 2µs at 4MHz */
+#endif
+
+#ifdef SNES2DB9_ENABLE_CD32
+#define CD32MODE_PIN   UNUSED_B0_PIN       /**< DB9 pin 5 on PB0, CD32 mode line driven low by the host for serial reads */
+#define CD32DATA_PIN   UNUSED_B1_PIN       /**< DB9 pin 9 on PB1, CD32 serial data line, open collector */
+#define READ_CD32MODE  READ_UNUSED_B0      /**< read CD32 mode line */
+#endif
+
+#ifdef SNES2DB9_ENABLE_PADDLE
+#ifdef SNES2DB9_ENABLE_CD32
+#error "paddle and CD32 emulation share DB9 pin 9 and cannot be combined"
+#endif
+#define POT_PIN        UNUSED_B1_PIN       /**< DB9 pin 9 on PB1, paddle pot line, open collector with external pullup */
+#define READ_POT       READ_UNUSED_B1      /**< read paddle pot line */
+#define TIMER1_TICKS_PER_US (2)            /**< Timer1 runs at 4MHz / 8, 0.5µs per tick */
+#define PADDLE_MIN_DELAY_US (600)          /**< pot line delay for the rightmost paddle position, includes the host dump time */
+#define PADDLE_MAX_DELAY_US (16000)        /**< pot line delay for the leftmost paddle position */
+#endif
+
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+#ifdef SNES2DB9_ENABLE_PADDLE
+#error "the hardware SNES clock moves the tick to Timer1 which times the paddle pot line"
+#endif
+#define CLOCK_TIMER_TOP    (23)            /**< Timer0 counts per CLK period minus 1, 48µs at 2µs per count */
+#define CLOCK_TIMER_FALL   (7)             /**< Timer0 count of the falling CLK edge, CLK is high for 16µs and low for 32µs */
+#define LATCH_PULSE_CYCLES (48)            /**< width of the LATCH pulse in CPU cycles, 12µs at 4MHz */
+#define TICK_TIMER_COUNT   ( ( uint8_t ) TCNT1 )  /**< count of the tick timer within the current tick */
+#define TICK_TIMER_VECT    TIM1_COMPA_vect        /**< compare interrupt of the tick timer */
+#else
+#define TICK_TIMER_COUNT   TCNT0           /**< count of the tick timer within the current tick */
+#define TICK_TIMER_VECT    TIM0_COMPA_vect /**< compare interrupt of the tick timer */
+#endif
+
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+#ifdef SNES2DB9_ENABLE_CD32
+#error "CD32 emulation uses PB0 and PB1, telemetry cannot be combined"
+#endif
+#ifdef SNES2DB9_TELEMETRY_ON_B1
+#ifdef SNES2DB9_ENABLE_PADDLE
+#error "paddle emulation uses PB1, select telemetry on PB0"
+#endif
+#define TELEMETRY_TX_PIN   UNUSED_B1_PIN   /**< telemetry TX line on PB1 */
+#else
+#define TELEMETRY_TX_PIN   UNUSED_B0_PIN   /**< telemetry TX line on PB0 */
+#endif
+#define TELEMETRY_STATUS_STARTUP  0x01     /**< telemetry status: startup delay active, DB9 output suppressed */
+#define TELEMETRY_STATUS_MACRO    1        /**< telemetry status: bit position of the SNESMacroMode, 2 bits */
+#define TELEMETRY_STATUS_PROFILE  4        /**< telemetry status: bit position of the selected profile, 2 bits */
+#endif
+
+#ifdef SNES2DB9_ENABLE_MACRO_EEPROM
+#ifndef SNES2DB9_ENABLE_MACRO
+#define SNES2DB9_ENABLE_MACRO
+#endif
+#define MACRO_EEPROM_ADDRESS (0)           /**< EEPROM address of the stored macro, uses SNESMACRO_STORAGE_SIZE bytes */
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+#define PROFILE_EEPROM_ADDRESS (256)       /**< EEPROM address of the mapping profiles, uses SNESPROFILE_STORAGE_SIZE bytes */
+#if SNESPROFILE_COUNT != 4
+#error "profile chords are defined for 4 profiles"
+#endif
+#if ( PROFILE_EEPROM_ADDRESS + SNESPROFILE_STORAGE_SIZE ) > 512
+#error "mapping profiles exceed the EEPROM"
+#endif
+#if defined(SNES2DB9_ENABLE_MACRO_EEPROM) && ( ( MACRO_EEPROM_ADDRESS + SNESMACRO_STORAGE_SIZE ) > PROFILE_EEPROM_ADDRESS )
+#error "stored macro overlaps the mapping profiles"
+#endif
+#endif
+#ifdef SNES2DB9_ENABLE_CLOCK_CALIBRATION
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+#error "clock calibration applies to the software SNES reader"
+#endif
+#define CALIBRATION_EEPROM_ADDRESS (240)   /**< EEPROM address of the calibrated CLK half period, uses SNESREADER_STORAGE_SIZE bytes */
+#define CALIBRATION_BUTTON  SNES_BTNMASK_Start  /**< button held at the end of the startup delay to calibrate the CLK timing */
+#define CALIBRATION_READS   (8)            /**< readings per probed half period */
+#define CPU_CYCLES_PER_US   (4)            /**< CPU cycles per µs at 4MHz */
+#define READER_WAIT_LIMIT_US (24)          /**< busy wait per reader task in µs, keeps tick interrupt and reader task within a tick */
+#if defined(SNES2DB9_ENABLE_MACRO_EEPROM) && ( ( MACRO_EEPROM_ADDRESS + SNESMACRO_STORAGE_SIZE ) > CALIBRATION_EEPROM_ADDRESS )
+#error "stored macro overlaps the CLK calibration"
+#endif
+#if defined(SNES2DB9_ENABLE_PROFILES) && ( ( CALIBRATION_EEPROM_ADDRESS + SNESREADER_STORAGE_SIZE ) > PROFILE_EEPROM_ADDRESS )
+#error "CLK calibration overlaps the mapping profiles"
+#endif
+#endif
+#if defined(SNES2DB9_ENABLE_MACRO) || defined(SNES2DB9_ENABLE_PROFILES)
+#define COMMAND_LEAD_BUTTON  SNES_BTNMASK_Select  /**< lead button for command chords, SNES input is hidden from the mapper while held */
+
+/**
+ * @brief   commands entered as chords with the lead button, bit number in SNESChord_GetFired()
+ */
+enum Command
+{
+#ifdef SNES2DB9_ENABLE_MACRO
+	CMD_MACRO_RECORD,                        /**< start or stop recording */
+	CMD_MACRO_PLAY,                          /**< play once or stop playback */
+	CMD_MACRO_LOOP,                          /**< play repeatedly or stop playback */
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+	CMD_PROFILE_FIRST,                       /**< select profile 1, followed by the further profiles */
+	CMD_PROFILE_LAST = CMD_PROFILE_FIRST + SNESPROFILE_COUNT - 1,  /**< select the last profile */
+#endif
+	NR_COMMANDS                              /**< number of commands */
+};
+#endif
+
 /**
- * @brief   readiness flags for timed tasks
- * @details Flags do
- *          - count forward from associated timer tick for given timing
- *          - reset to 0 on execution of associated task from main loop
+ * @brief   index of the timed tasks in the scheduler table, in order of priority
  */
-typedef struct
+enum TaskIndex
 {
-	volatile uint8_t reader_update_ready;    /**< reader updates occur with 200µs timer increments */
-	volatile uint8_t db9_update_ready;       /**< DB9 state update occurs with given interval in ms derived from 200µs timer */
-} TaskFlags;
+	TASK_READER,                             /**< reader updates occur with 200µs timer increments */
+	TASK_DB9_UPDATE,                         /**< DB9 state update occurs with given interval in ms derived from 200µs timer */
+	NR_TASKS                                 /**< number of tasks */
+};
 
 
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+static SNESTimerReader TimerReader;          /**< SNES gamepad reader instance, sampling the DATA pin in the Timer0 compare interrupt */
+static SNESSnapshotSeq ReadingSequence;      /**< number of the last reading taken over by the ReaderTask() */
+#else
 static SNESReader Reader;                    /**< SNES gamepad reader instance, services the SNES CLOCK, LATCH pins and reads the DATA pin */
+#endif
 static SNESMapper Mapper;                    /**< SNES mapper instance, translates SNES gamepad button presses to DB9 joystick signals */
 static uint16_t   SNESGamepadState;          /**< internal SNES gamepad state used by the application, bitcoded */
 static uint8_t    DB9State;                  /**< internal DB9 joystick state outputed via the DB9 pins, bitcoded */
 static uint16_t   startup_time_in_ms;        /**< startup time in ms, suppresses button presses during this period */
+#ifdef SNES2DB9_ENABLE_IDLE_POLL
+static uint16_t   idle_time_in_ms;           /**< time without pressed buttons in ms, saturates at IDLE_POLL_AFTER_MS */
+static uint8_t    idle_poll_cycles;          /**< DB9 update cycles since the last reading during idle polling */
+#endif
+#ifdef SNES2DB9_ENABLE_CD32
+static CD32Pad    Pad;                       /**< CD32 pad instance, serves the host clock from the pin change interrupts */
+#endif
+#ifdef SNES2DB9_ENABLE_PADDLE
+static SNESPaddle Paddle;                    /**< paddle instance, integrates the paddle position from the SNES pad */
+static volatile uint16_t PotDelayTicks;      /**< pot line delay in Timer1 ticks, precomputed for the pot line interrupts */
+#endif
+#ifdef SNES2DB9_ENABLE_MACRO
+static SNESMacro  Macro;                     /**< macro instance, records and plays back the SNES gamepad state */
+#endif
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+static SNESTelemetry Telemetry;              /**< telemetry instance, the frame is shifted out by the timer interrupt */
+#endif
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+static uint8_t    ProbeDB9State;             /**< DB9 state at the last output marker */
+#endif
+#ifdef SNES2DB9_ENABLE_CLOCK_CALIBRATION
+
+/** CLK half periods in µs probed by the calibration, slowest first */
+static const uint8_t CalibrationHalfPeriods[] = { 48, 24, 12, 6 };
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+static SNESProfiles Profiles;                /**< mapping profiles in EEPROM, the selected one configures the mapper */
+
+/** default mapping profiles, written to erased EEPROM */
+static const SNESProfile DefaultProfiles[SNESPROFILE_COUNT] =
+{
+	/* fire B, autofire Y, jump A: */
+	{ { SNES_BTNMASK_B, SNES_BTNMASK_Y, SNES_BTNMASK_A }, DB9_UPDATE_TASK_CYCLE_IN_MS },
+	/* fire B or A, no autofire and jump: */
+	{ { SNES_BTNMASK_B | SNES_BTNMASK_A, 0, 0 }, 0 },
+	/* fire B, slow autofire Y, jump A: */
+	{ { SNES_BTNMASK_B, SNES_BTNMASK_Y, SNES_BTNMASK_A }, AUTOFIRE_CYCLETIME_IN_MS },
+	/* fire Y, autofire B, jump X and shoulder buttons: */
+	{ { SNES_BTNMASK_Y, SNES_BTNMASK_B, SNES_BTNMASK_X | SNES_BTNMASK_L | SNES_BTNMASK_R }, DB9_UPDATE_TASK_CYCLE_IN_MS },
+};
+
+#endif
+#ifdef COMMAND_LEAD_BUTTON
+static SNESChord  Chord;                     /**< chord detector instance, recognizes the commands entered with the lead button */
+
+/** chords of the commands, pressed together with the lead button */
+static const SNESChordDef CommandChords[NR_COMMANDS] =
+{
+#ifdef SNES2DB9_ENABLE_MACRO
+	[CMD_MACRO_RECORD] = { SNES_BTNMASK_L, 0 },
+	[CMD_MACRO_PLAY] = { SNES_BTNMASK_R, 0 },
+	[CMD_MACRO_LOOP] = { SNES_BTNMASK_X, 0 },
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+	[CMD_PROFILE_FIRST + 0] = { SNES_BTNMASK_Up, 0 },
+	[CMD_PROFILE_FIRST + 1] = { SNES_BTNMASK_Right, 0 },
+	[CMD_PROFILE_FIRST + 2] = { SNES_BTNMASK_Down, 0 },
+	[CMD_PROFILE_FIRST + 3] = { SNES_BTNMASK_Left, 0 },
+#endif
+};
+#endif
 
 
-static TaskFlags TaskReadiness = { 0, 0 };   /**< readiness state of tasks */
+static void ReaderTask ( void );
+static void DB9UpdateTask ( void );
+
+static SNESScheduler Scheduler;              /**< scheduler instance, dispatches the timed tasks from the main loop */
+
+/** timed tasks, period and phase offset in 200µs ticks */
+static SNESTask Tasks[NR_TASKS] =
+{
+	[TASK_READER] = { ReaderTask, NR_200US_TICKS_READER_TASK, 0 },
+	[TASK_DB9_UPDATE] = { DB9UpdateTask, NR_200US_TICKS_DB9_UPDATE_TASK, 0 },
+};
+
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+/**
+ * @brief     outputs a latency probe marker on UNUSED_A0 as burst of pulses
+ * @details   Markers not selected by SNES2DB9_PROBE_MARKERS are removed at compile time.
+ * @param[in] marker according to SNES2DB9_PROBE_xxx, number of pulses
+ */
+static inline void ProbeMark ( uint8_t marker )
+{
+	uint8_t pulses;
+
+	if ( ( SNES2DB9_PROBE_MARKERS & SNES2DB9_PROBE_MASK ( marker ) ) != 0 )
+	{
+		for ( pulses = marker; pulses > 0; pulses-- )
+		{
+			SET_UNUSED_A0;
+			__builtin_avr_delay_cycles ( PROBE_PULSE_CYCLES );
+			CLEAR_UNUSED_A0;
+			__builtin_avr_delay_cycles ( PROBE_PULSE_CYCLES );
+		}
+	}
+}
+#endif
 
 /**
  * @brief hardware abstraction layer function to set ATtiny84 pins to a given state from SNES2DB9 core software
@@ -93,6 +324,15 @@ static void SetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
 			CLEAR_BIT ( PORTA, pin_mask[pin] );
 		}
 	}
+
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+
+	if ( ( pin == SNES_LATCH ) && ( state == SNES2DB9_PIN_HIGH ) )
+	{
+		ProbeMark ( SNES2DB9_PROBE_LATCH );
+	}
+
+#endif
 }
 
 /**
@@ -116,6 +356,29 @@ static SNES2DB9_Pinstate ReadPin ( SNES2DB9_Pin pin )
 }
 
 
+#ifdef SNES2DB9_ENABLE_TIMING_STATS
+/**
+ * @brief   reads a timestamp with tick timer resolution for the timing instrumentation
+ * @details The tick counter is read again to detect a tick interrupt between both reads.
+ * @return  timestamp in tick timer counts modulo 256 ticks
+ */
+static uint16_t ReadTimestamp ( void )
+{
+	uint8_t ticks;
+	uint8_t counts;
+
+	do
+	{
+		ticks = SNESScheduler_GetTicks ( &Scheduler );
+		counts = TICK_TIMER_COUNT;
+	}
+	while ( ticks != SNESScheduler_GetTicks ( &Scheduler ) );
+
+	return ( uint16_t ) ( ( ticks * TIMER0_COUNTS_PER_TICK ) + counts );
+}
+#endif
+
+#ifndef SNES2DB9_ENABLE_HW_CLOCK
 /**
  * @brief initialize TIMER0 of ATTiny84 to ~200µs ticks with internal oscillator
  */
@@ -136,24 +399,433 @@ static void InitTimer0 ( void )
 	TIMSK0 |= ( 1 << OCIE0A );
 	sei();
 }
+#else
+/**
+ * @brief initialize TIMER1 of ATTiny84 to ~200µs ticks, Timer0 is reserved for the SNES clock
+ */
+static void InitTimer1 ( void )
+{
+	cli();
+	TCCR1A = 0;
+	TCCR1B = 0;
+	TCNT1 = 0;
+	// 5000 Hz (4000000/((99+1)*8))
+	OCR1A = 99;
+	// CTC with TOP OCR1A, prescaler 8
+	TCCR1B = ( 1 << WGM12 ) | ( 1 << CS11 );
+	// Output Compare Match A Interrupt Enable
+	TIMSK1 |= ( 1 << OCIE1A );
+	sei();
+}
+
+/**
+ * @brief   prepares TIMER0 of ATTiny84 to generate the SNES CLK on OC0B (PA7)
+ * @details Fast PWM with TOP OCR0A, OC0B is set at BOTTOM and cleared at compare match B.
+ *          The timer stays stopped until a reading is started.
+ */
+static void InitClockTimer ( void )
+{
+	TCCR0A = 0;
+	TCCR0B = 0;
+	OCR0A = CLOCK_TIMER_TOP;
+	OCR0B = CLOCK_TIMER_FALL;
+}
+
+/**
+ * @brief   starts a SNES reading with a LATCH pulse and the CLK timer
+ * @details The LATCH pulse is timed in CPU cycles with interrupts disabled. OC0B is forced high
+ *          while LATCH is high, the shift register of the gamepad ignores CLK during the parallel load.
+ */
+static void StartClockTimer ( void )
+{
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+	ProbeMark ( SNES2DB9_PROBE_LATCH );
+#endif
+	ATOMIC_BLOCK ( ATOMIC_RESTORESTATE )
+	{
+		TCCR0B = 0;
+		SET_LATCH;
+		SNESTimerReader_BeginRead ( &TimerReader );
+		/* OC0B can only be forced in a non PWM mode: */
+		TCCR0A = ( 1 << COM0B1 ) | ( 1 << COM0B0 );
+		TCCR0B = ( 1 << FOC0B );
+		TCCR0A = ( 1 << COM0B1 ) | ( 1 << WGM01 ) | ( 1 << WGM00 );
+		TCNT0 = 0;
+		__builtin_avr_delay_cycles ( LATCH_PULSE_CYCLES );
+		CLEAR_LATCH;
+		TIFR0 = ( 1 << OCF0B );
+		TIMSK0 |= ( 1 << OCIE0B );
+		// Fast PWM with TOP OCR0A, prescaler 8
+		TCCR0B = ( 1 << WGM02 ) | ( 1 << CS01 );
+	}
+}
+
+/**
+ * @brief   interrupt service routine at the falling SNES CLK edges
+ * @details DATA is stable since the rising edge at BOTTOM. After the last bit OC0B is disconnected,
+ *          CLK returns to the high level of its port pin.
+ */
+ISR ( TIM0_COMPB_vect )
+{
+	if ( SNESTimerReader_Sample ( &TimerReader, ( READ_DATA == 0 ) ? SNES2DB9_PIN_LOW : SNES2DB9_PIN_HIGH ) == true )
+	{
+		TCCR0B = 0;
+		TCCR0A = 0;
+		TIMSK0 &= ( uint8_t ) ~( 1 << OCIE0B );
+	}
+}
+#endif
+
+/**
+ * @brief   switches off the unused peripherals and selects the sleep mode of the main loop
+ * @details Timer1 is kept for the paddle emulation and the tick of the hardware SNES clock.
+ *          Idle sleep keeps the timers and the pin change interrupts running.
+ */
+static void InitPower ( void )
+{
+	/* the ADC is disabled before its clock is stopped: */
+	ADCSRA &= ( uint8_t ) ~( 1 << ADEN );
+	ACSR |= ( 1 << ACD );
+	power_adc_disable();
+	power_usi_disable();
+#if !defined(SNES2DB9_ENABLE_PADDLE) && !defined(SNES2DB9_ENABLE_HW_CLOCK)
+	power_timer1_disable();
+#endif
+	set_sleep_mode ( SLEEP_MODE_IDLE );
+}
+
+/**
+ * @brief   enters idle sleep until the next interrupt if the scheduler has nothing to do
+ * @details The check is done with interrupts disabled, sei() takes effect after the sleep instruction,
+ *          so a tick cannot slip in between check and sleep and delay its tasks.
+ */
+static void IdleSleep ( void )
+{
+	cli();
+
+	if ( SNESScheduler_IsIdle ( &Scheduler ) == true )
+	{
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+
+	sei();
+}
 
 /**
  * @brief   interrupt service routine to process 200µs updates
- * @details Tasks are scheduled for execution from the main loop via the task readiness flags.
- *          Flags are primed when the associated task is due.
+ * @details Tasks are released and executed from the main loop by the scheduler, only the tick is counted here.
+ *          The telemetry TX line is updated first so its bit edges keep a constant latency to the timer.
+ */
+ISR ( TICK_TIMER_VECT )
+{
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+
+	if ( SNESTelemetry_Update ( &Telemetry ) == SNES2DB9_PIN_LOW )
+	{
+		CLEAR_BIT ( PORTB, TELEMETRY_TX_PIN );
+	}
+	else
+	{
+		SET_BIT ( PORTB, TELEMETRY_TX_PIN );
+	}
+
+#endif
+	SNESScheduler_Tick ( &Scheduler );
+}
+
+#ifdef SNES2DB9_ENABLE_CD32
+/**
+ * @brief     updates the CD32 serial data pin, open collector
+ * @param[in] state as returned by CD32Pad_Load() or CD32Pad_Clock()
+ */
+static inline void SetCD32Data ( SNES2DB9_Pinstate state )
+{
+	if ( state == SNES2DB9_PIN_LOW )
+	{
+		SET_BIT ( DDRB, CD32DATA_PIN );
+	}
+	else
+	{
+		CLEAR_BIT ( DDRB, CD32DATA_PIN );
+	}
+}
+
+/**
+ * @brief   configures the CD32 mode and clock lines as pin change interrupt sources
+ * @details The mode line uses the internal pullup so an unconnected pin 5 selects regular joystick mode.
+ */
+static void InitCD32 ( void )
+{
+	CLEAR_BIT ( DDRB, CD32MODE_PIN );
+	SET_BIT ( PORTB, CD32MODE_PIN );
+	CLEAR_BIT ( DDRB, CD32DATA_PIN );
+	CLEAR_BIT ( PORTB, CD32DATA_PIN );
+	PCMSK1 |= CD32MODE_PIN;     /* PCINT8 */
+	PCMSK0 |= DB9FIRE_PIN;      /* PCINT1 */
+	GIMSK |= ( 1 << PCIE1 ) | ( 1 << PCIE0 );
+}
+
+/**
+ * @brief   interrupt service routine for the CD32 mode line
+ * @details While the mode line is low, DB9 pin 6 is the host clock and must not be driven.
+ *          Once the mode line returns high, pin 6 shows the fire button of the last DB9 update again.
+ */
+ISR ( PCINT1_vect )
+{
+	if ( READ_CD32MODE == 0 )
+	{
+		CLEAR_BIT ( DDRA, DB9FIRE_PIN );
+		SetCD32Data ( CD32Pad_Load ( &Pad ) );
+	}
+	else
+	{
+		SetCD32Data ( SNES2DB9_PIN_HIGHZ );
+
+		/* open collector like DB9_SetPins(), released stays high-Z: */
+		if ( ( DB9State & DB9_BTNMASK_Fire ) != 0 )
+		{
+			CLEAR_BIT ( PORTA, DB9FIRE_PIN );
+			SET_BIT ( DDRA, DB9FIRE_PIN );
+		}
+	}
+}
+
+/**
+ * @brief   interrupt service routine for the CD32 clock line
+ * @details The precomputed image is shifted on each rising edge, no mapping is done here.
+ */
+ISR ( PCINT0_vect )
+{
+	static uint8_t last_clock = DB9FIRE_PIN;
+	uint8_t clock = READ_DB9FIRE;
+
+	if ( ( clock != 0 ) && ( last_clock == 0 ) && ( READ_CD32MODE == 0 ) )
+	{
+		SetCD32Data ( CD32Pad_Clock ( &Pad ) );
+	}
+
+	last_clock = clock;
+}
+#endif
+
+#ifdef SNES2DB9_ENABLE_PADDLE
+/**
+ * @brief   configures the pot line as pin change interrupt source and Timer1 for delay measurement
+ * @details Timer1 runs freely with prescaler 8, the delay is timed with compare match A.
  */
-ISR ( TIM0_COMPA_vect )
+static void InitPaddle ( void )
 {
-	static uint16_t ticks_to_db9_update = 0;
-	TaskReadiness.reader_update_ready++;
-	ticks_to_db9_update ++;
+	CLEAR_BIT ( DDRB, POT_PIN );
+	CLEAR_BIT ( PORTB, POT_PIN );
+	TCCR1A = 0;
+	TCCR1B = ( 1 << CS11 );
+	PCMSK1 |= POT_PIN;          /* PCINT9 */
+	GIMSK |= ( 1 << PCIE1 );
+}
+
+/**
+ * @brief   interrupt service routine for the pot line
+ * @details The host starts a measurement cycle by dumping the pot line to ground.
+ *          The line is then held low until the precomputed delay has passed.
+ */
+ISR ( PCINT1_vect )
+{
+	if ( ( READ_POT == 0 ) && ( ( TIMSK1 & ( 1 << OCIE1A ) ) == 0 ) )
+	{
+		SET_BIT ( DDRB, POT_PIN );
+		OCR1A = TCNT1 + PotDelayTicks;
+		TIFR1 = ( 1 << OCF1A );
+		TIMSK1 |= ( 1 << OCIE1A );
+	}
+}
+
+/**
+ * @brief   interrupt service routine to end the pot line delay
+ * @details The external pullup charges the host capacitor once the line is released.
+ */
+ISR ( TIM1_COMPA_vect )
+{
+	CLEAR_BIT ( DDRB, POT_PIN );
+	TIMSK1 &= ( uint8_t ) ~( 1 << OCIE1A );
+}
+#endif
+
+#if defined(SNES2DB9_ENABLE_MACRO_EEPROM) || defined(SNES2DB9_ENABLE_PROFILES) || defined(SNES2DB9_ENABLE_CLOCK_CALIBRATION)
+/**
+ * @brief     hardware abstraction layer function to write the ATtiny84 EEPROM, unchanged bytes are not written
+ * @param[in] address to write
+ * @param[in] value to write
+ */
+static void WriteEEPROMByte ( uint16_t address, uint8_t value )
+{
+	eeprom_update_byte ( ( uint8_t * ) ( uintptr_t ) address, value );
+}
+
+/**
+ * @brief     hardware abstraction layer function to read the ATtiny84 EEPROM
+ * @param[in] address to read
+ * @returns   value stored
+ */
+static uint8_t ReadEEPROMByte ( uint16_t address )
+{
+	return eeprom_read_byte ( ( const uint8_t * ) ( uintptr_t ) address );
+}
+#endif
+
+#ifdef SNES2DB9_ENABLE_CLOCK_CALIBRATION
+/**
+ * @brief     hardware abstraction layer function to busy wait, the loop overhead adds to the wait
+ * @param[in] microseconds to wait at least
+ */
+static void DelayMicroseconds ( uint8_t microseconds )
+{
+	while ( microseconds > 0 )
+	{
+		__builtin_avr_delay_cycles ( CPU_CYCLES_PER_US );
+		microseconds--;
+	}
+}
+
+/**
+ * @brief     selects the CLK timing at the end of the startup delay
+ * @details   The startup readings use one reader step per tick, which every gamepad keeps up with.
+ *            If the calibration button is held, the fastest reliable timing is determined and stored,
+ *            otherwise the stored timing is used. The calibration readings busy wait once, within the startup delay.
+ * @param[in] snes_pin_mask is the SNES gamepad state read during the startup delay
+ */
+static void SelectClockTiming ( uint16_t snes_pin_mask )
+{
+	if ( snes_pin_mask == CALIBRATION_BUTTON )
+	{
+		( void ) SNESReader_Calibrate ( &Reader, snes_pin_mask, CalibrationHalfPeriods, sizeof ( CalibrationHalfPeriods ), CALIBRATION_READS );
+		SNESReader_SaveHalfPeriod ( &Reader, WriteEEPROMByte, CALIBRATION_EEPROM_ADDRESS );
+	}
+	else
+	{
+		( void ) SNESReader_LoadHalfPeriod ( &Reader, ReadEEPROMByte, CALIBRATION_EEPROM_ADDRESS, CalibrationHalfPeriods, sizeof ( CalibrationHalfPeriods ) );
+	}
+}
+#endif
+
+#ifdef COMMAND_LEAD_BUTTON
+/**
+ * @brief     handles the commands entered with the lead button
+ * @param[in] snes_pin_mask is the SNES gamepad state
+ * @returns   SNES gamepad state to process, without the buttons used for command entry
+ */
+static uint16_t CommandTask ( uint16_t snes_pin_mask )
+{
+	uint8_t fired;
+#ifdef SNES2DB9_ENABLE_PROFILES
+	uint8_t index;
+#endif
+	snes_pin_mask = SNESChord_Update ( &Chord, snes_pin_mask, DB9_UPDATE_TASK_CYCLE_IN_MS );
+	fired = SNESChord_GetFired ( &Chord );
+#ifdef SNES2DB9_ENABLE_MACRO
 
-	if ( ticks_to_db9_update >= NR_200US_TICKS_DB9_UPDATE_TASK )
+	if ( ( fired & ( 1u << CMD_MACRO_RECORD ) ) != 0 )
 	{
-		ticks_to_db9_update = 0;
-		TaskReadiness.db9_update_ready ++;
+		if ( SNESMacro_GetMode ( &Macro ) == SNESMACRO_RECORDING )
+		{
+			SNESMacro_Stop ( &Macro );
+#ifdef SNES2DB9_ENABLE_MACRO_EEPROM
+			/* written by DB9UpdateTask() one byte per cycle: */
+			SNESMacro_StartSave ( &Macro );
+#endif
+		}
+		else
+		{
+			SNESMacro_StartRecording ( &Macro, snes_pin_mask );
+		}
 	}
+	else if ( ( fired & ( ( 1u << CMD_MACRO_PLAY ) | ( 1u << CMD_MACRO_LOOP ) ) ) != 0 )
+	{
+		if ( SNESMacro_GetMode ( &Macro ) == SNESMACRO_PLAYBACK )
+		{
+			SNESMacro_Stop ( &Macro );
+		}
+		else
+		{
+			( void ) SNESMacro_StartPlayback ( &Macro, ( fired & ( 1u << CMD_MACRO_LOOP ) ) != 0 );
+		}
+	}
+
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+
+	for ( index = 0; index < SNESPROFILE_COUNT; index++ )
+	{
+		if ( ( fired & ( 1u << ( CMD_PROFILE_FIRST + index ) ) ) != 0 )
+		{
+			( void ) SNESProfiles_Select ( &Profiles, index, &Mapper );
+		}
+	}
+
+#endif
+	return snes_pin_mask;
 }
+#endif
+
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+/**
+ * @brief   queues a telemetry frame with the current state once the previous frame has been sent
+ */
+static void TelemetryTask ( void )
+{
+	SNESTelemetryData data;
+
+	if ( SNESTelemetry_IsBusy ( &Telemetry ) == true )
+	{
+		return;
+	}
+
+	data.snes_state = SNESGamepadState;
+	data.db9_state = DB9State;
+	data.status = ( startup_time_in_ms <= STARTUP_TIME_IN_MS ) ? TELEMETRY_STATUS_STARTUP : 0;
+#ifdef SNES2DB9_ENABLE_MACRO
+	data.status |= ( uint8_t ) ( SNESMacro_GetMode ( &Macro ) << TELEMETRY_STATUS_MACRO );
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+	data.status |= ( uint8_t ) ( SNESProfiles_GetSelected ( &Profiles ) << TELEMETRY_STATUS_PROFILE );
+#endif
+	SNESScheduler_GetStats ( &Scheduler, &data.timing );
+
+	ATOMIC_BLOCK ( ATOMIC_RESTORESTATE )
+	{
+		( void ) SNESTelemetry_Send ( &Telemetry, &data );
+	}
+}
+#endif
+
+#ifdef SNES2DB9_ENABLE_IDLE_POLL
+/**
+ * @brief     decides if a new SNES reading is started, readings are reduced once no button has been pressed for a while
+ * @param[in] snes_pin_mask is the SNES gamepad state as read
+ * @returns   true if a reading is due
+ */
+static bool IdlePollDue ( uint16_t snes_pin_mask )
+{
+	if ( snes_pin_mask != 0 )
+	{
+		idle_time_in_ms = 0;
+	}
+	else if ( idle_time_in_ms < IDLE_POLL_AFTER_MS )
+	{
+		idle_time_in_ms += DB9_UPDATE_TASK_CYCLE_IN_MS;
+	}
+
+	if ( ( idle_time_in_ms < IDLE_POLL_AFTER_MS ) || ( ++idle_poll_cycles >= IDLE_POLL_DIVIDER ) )
+	{
+		idle_poll_cycles = 0;
+		return true;
+	}
+
+	return false;
+}
+#endif
 
 /**
  * @brief   inits the SNES2DB9 application and the data instances
@@ -168,11 +840,55 @@ static void InitAppl ( void )
 	button_config.autofire_mask = SNES_BTNMASK_Y;
 	SNESMapper_Init ( &Mapper, &button_config );
 	SNESMapper_SetAutofireDuration ( &Mapper, DB9_UPDATE_TASK_CYCLE_IN_MS );
+#ifdef SNES2DB9_ENABLE_PROFILES
+	/* the selected profile overrides the configuration above: */
+	SNESProfiles_Init ( &Profiles, WriteEEPROMByte, ReadEEPROMByte, PROFILE_EEPROM_ADDRESS, DefaultProfiles );
+	( void ) SNESProfiles_Select ( &Profiles, SNESProfiles_GetSelected ( &Profiles ), &Mapper );
+#endif
 	/* initialize reader instance */
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+	SNESTimerReader_Init ( &TimerReader );
+	ReadingSequence = 0;
+	SetPin ( SNES_CLK, SNES2DB9_PIN_HIGH );
+	SetPin ( SNES_LATCH, SNES2DB9_PIN_LOW );
+	InitClockTimer();
+#else
 	SNESReader_Init ( &Reader, SetPin, ReadPin );
+#endif
+#ifdef SNES2DB9_ENABLE_CLOCK_CALIBRATION
+	SNESReader_SetDelayFunc ( &Reader, DelayMicroseconds );
+	SNESReader_SetWaitLimit ( &Reader, READER_WAIT_LIMIT_US );
+#endif
 	SNESGamepadState = 0;
 	/* initialize DB9 handler instance */
 	DB9State = 0;
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+	SNESTelemetry_Init ( &Telemetry );
+	SET_BIT ( PORTB, TELEMETRY_TX_PIN );
+	SET_BIT ( DDRB, TELEMETRY_TX_PIN );
+#endif
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+	ProbeDB9State = 0;
+	CLEAR_UNUSED_A0;
+	UNUSED_A0_AS_OUTPUT;
+#endif
+#ifdef SNES2DB9_ENABLE_CD32
+	CD32Pad_Init ( &Pad );
+	InitCD32();
+#endif
+#ifdef SNES2DB9_ENABLE_PADDLE
+	SNESPaddle_Init ( &Paddle );
+	PotDelayTicks = SNESPaddle_GetDelay ( &Paddle, PADDLE_MIN_DELAY_US * TIMER1_TICKS_PER_US, PADDLE_MAX_DELAY_US * TIMER1_TICKS_PER_US );
+	InitPaddle();
+#endif
+#ifdef COMMAND_LEAD_BUTTON
+	SNESChord_Init ( &Chord, COMMAND_LEAD_BUTTON, CommandChords, NR_COMMANDS );
+#endif
+#ifdef SNES2DB9_ENABLE_MACRO_EEPROM
+	( void ) SNESMacro_Load ( &Macro, ReadEEPROMByte, MACRO_EEPROM_ADDRESS );
+#elif defined(SNES2DB9_ENABLE_MACRO)
+	SNESMacro_Init ( &Macro );
+#endif
 }
 
 /**
@@ -181,7 +897,48 @@ static void InitAppl ( void )
  */
 static void ReaderTask ( void )
 {
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+	SNESSnapshotSeq sequence;
+	WCET_MARK ( WCET_READER_BEGIN );
+	/* the reading itself runs in the Timer0 compare interrupt: */
+	sequence = SNESTimerReader_GetState ( &TimerReader, &SNESGamepadState );
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+
+	if ( sequence != ReadingSequence )
+	{
+		ProbeMark ( SNES2DB9_PROBE_UPDATE );
+	}
+
+#endif
+	ReadingSequence = sequence;
+#else
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+	bool was_idle = SNESReader_IsIdle ( &Reader );
+#endif
+	WCET_MARK ( WCET_READER_BEGIN );
 	SNESGamepadState = SNESReader_Update ( &Reader );
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+
+	if ( ( was_idle == false ) && ( SNESReader_IsIdle ( &Reader ) == true ) )
+	{
+		ProbeMark ( SNES2DB9_PROBE_UPDATE );
+	}
+
+#endif
+#endif
+	WCET_MARK ( WCET_READER_END );
+}
+
+/**
+ * @brief   requests the next SNES reading
+ */
+static void BeginRead ( void )
+{
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+	StartClockTimer();
+#else
+	SNESReader_BeginRead ( &Reader );
+#endif
 }
 
 /**
@@ -190,19 +947,99 @@ static void ReaderTask ( void )
  */
 static void DB9UpdateTask ( void )
 {
+#ifdef SNES2DB9_ENABLE_IDLE_POLL
+	bool poll = IdlePollDue ( SNESGamepadState );
+#endif
+	WCET_MARK ( WCET_DB9_BEGIN );
+
 	/* handle startup time delay to avoid DB9 flicker on plugin of device: */
 	if ( startup_time_in_ms <= STARTUP_TIME_IN_MS )
 	{
 		startup_time_in_ms += DB9_UPDATE_TASK_CYCLE_IN_MS;
 		DB9State = 0;
+#ifdef SNES2DB9_ENABLE_CLOCK_CALIBRATION
+
+		if ( startup_time_in_ms > STARTUP_TIME_IN_MS )
+		{
+			SelectClockTiming ( SNESGamepadState );
+		}
+
+#endif
 	}
 	else
 	{
+#ifdef COMMAND_LEAD_BUTTON
+		SNESGamepadState = CommandTask ( SNESGamepadState );
+#endif
+#ifdef SNES2DB9_ENABLE_PROFILES
+
+		/* a changed selection reaches the journal one byte per cycle: */
+		if ( eeprom_is_ready() )
+		{
+			( void ) SNESProfiles_WriteStep ( &Profiles );
+		}
+
+#endif
+#ifdef SNES2DB9_ENABLE_MACRO
+#ifdef SNES2DB9_ENABLE_MACRO_EEPROM
+
+		/* never wait for the EEPROM, a byte takes 3.4ms to program: */
+		if ( ( SNESMacro_GetMode ( &Macro ) == SNESMACRO_SAVING ) && eeprom_is_ready() )
+		{
+			( void ) SNESMacro_SaveStep ( &Macro, WriteEEPROMByte, MACRO_EEPROM_ADDRESS );
+		}
+
+#endif
+		SNESGamepadState = SNESMacro_Update ( &Macro, SNESGamepadState );
+#endif
 		DB9State = SNESMapper_Update ( &Mapper, SNESGamepadState, DB9_UPDATE_TASK_CYCLE_IN_MS );
 	}
 
+#ifdef SNES2DB9_ENABLE_CD32
+	CD32Pad_Update ( &Pad, ( startup_time_in_ms > STARTUP_TIME_IN_MS ) ? SNESGamepadState : 0 );
+
+	/* pin 6 belongs to the host clock during serial reads, DB9State keeps the fire button for the mode line interrupt: */
+	ATOMIC_BLOCK ( ATOMIC_RESTORESTATE )
+	{
+		DB9_SetPins ( ( READ_CD32MODE == 0 ) ? ( uint8_t ) ( DB9State & ~DB9_BTNMASK_Fire ) : DB9State, SetPin );
+	}
+#elif defined(SNES2DB9_ENABLE_PADDLE)
+	/* paddle fire button is on the "Right" pin, directions drive the paddle: */
+	DB9State = ( ( DB9State & DB9_BTNMASK_Fire ) != 0 ) ? DB9_BTNMASK_Right : 0;
+	( void ) SNESPaddle_Update ( &Paddle, SNESGamepadState, DB9_UPDATE_TASK_CYCLE_IN_MS );
+
+	ATOMIC_BLOCK ( ATOMIC_RESTORESTATE )
+	{
+		PotDelayTicks = SNESPaddle_GetDelay ( &Paddle, PADDLE_MIN_DELAY_US * TIMER1_TICKS_PER_US, PADDLE_MAX_DELAY_US * TIMER1_TICKS_PER_US );
+	}
+
 	DB9_SetPins ( DB9State, SetPin );
-	SNESReader_BeginRead ( &Reader );
+#else
+	DB9_SetPins ( DB9State, SetPin );
+#endif
+#ifdef SNES2DB9_ENABLE_LATENCY_PROBE
+
+	if ( DB9State != ProbeDB9State )
+	{
+		ProbeDB9State = DB9State;
+		ProbeMark ( SNES2DB9_PROBE_OUTPUT );
+	}
+
+#endif
+#ifdef SNES2DB9_ENABLE_TELEMETRY
+	TelemetryTask();
+#endif
+#ifdef SNES2DB9_ENABLE_IDLE_POLL
+
+	if ( poll == true )
+	{
+		BeginRead();
+	}
+
+#else
+	BeginRead();
+#endif
+	WCET_MARK ( WCET_DB9_END );
 }
 
 /**
@@ -214,22 +1051,40 @@ int main ( void )
 	// configure internal clock to 4 instead of 1Mhz by changing the prescaler
 	clock_prescale_set ( clock_div_2 );
 	InitPorts();
+	InitPower();
 	InitAppl();
+	SNESScheduler_Init ( &Scheduler, Tasks, NR_TASKS );
+#ifdef SNES2DB9_ENABLE_HW_CLOCK
+	InitTimer1();
+#else
 	InitTimer0();
+#endif
 
 	for ( ;; )
 	{
-		if ( TaskReadiness.reader_update_ready )
+#ifdef SNES2DB9_ENABLE_TIMING_STATS
+		uint16_t start = ReadTimestamp();
+
+		if ( SNESScheduler_Dispatch ( &Scheduler ) )
+		{
+			int16_t duration = ( int16_t ) ( ReadTimestamp() - start );
+
+			/* the timestamp wraps after 256 ticks: */
+			SNESScheduler_ReportIteration ( &Scheduler, ( uint16_t ) ( ( duration < 0 ) ? ( duration + ( 256 * TIMER0_COUNTS_PER_TICK ) ) : duration ) );
+		}
+		else
 		{
-			ReaderTask();
-			TaskReadiness.reader_update_ready = 0;
+			IdleSleep();
 		}
 
-		if ( TaskReadiness.db9_update_ready )
+#else
+
+		if ( SNESScheduler_Dispatch ( &Scheduler ) == false )
 		{
-			DB9UpdateTask();
-			TaskReadiness.db9_update_ready = 0;
+			IdleSleep();
 		}
+
+#endif
 	}
 
 	return 0;
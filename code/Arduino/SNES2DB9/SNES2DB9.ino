@@ -14,63 +14,113 @@
 
 #include "snes2db9.h"
 
-static SNESReader reader;           /**< SNES reader instance */
+#define TICKS_PER_MS           5   /**< number of 200 µS ticks per ms */
+#define DB9_UPDATE_CYCLE_IN_MS 16  /**< DB9 update and SNES reading interval in ms (60Hz) */
+#define TICKS_PER_READ         (TICKS_PER_MS * DB9_UPDATE_CYCLE_IN_MS)  /**< ticks between two SNES readings */
+#define READER_STEPS           33  /**< reader steps from the latch pulse to the completed reading */
+#define SERIAL_DEBUG           0   /**< 1 prints SNES and DB9 state changes at 115200 baud */
+#define DEBUG_CYCLE_IN_MS      100 /**< interval of the serial debug output in ms */
+
+static SNESReader reader;           /**< SNES reader instance, stepped by the Timer 1 interrupt */
+static SNESSnapshot readings;       /**< completed SNES readings, published by the Timer 1 interrupt */
 static SNESMapper mapper;           /**< SNES mapper instance */
-static uint32_t previousMillis = 0; /**< keep track of milliseconds passed */
-static uint16_t currentSNES = 0;    /**< SNES pad state as read */
+static uint8_t read_countdown;      /**< ticks until the next SNES reading starts */
+static uint8_t currentDB9 = 0;      /**< DB9 state as output */
+
+static void db9_task ( void );
+#if SERIAL_DEBUG
+static void debug_task ( void );
+#endif
 
+static SNESScheduler scheduler;     /**< scheduler instance, ticked by Timer 1 every 200 µS */
 
-static volatile uint8_t _200micros = 0;  /**< internal state of 200 µS ticks (updated by Timer 1) */
+/**
+	@brief   timed tasks in order of priority, period and phase offset in 200 µS ticks
+	@details The DB9 update is released by the tick completing a SNES reading: the first reading starts
+	         in tick 1 and publishes in tick READER_STEPS. Readings and tasks count the same ticks, so their
+	         phase never drifts.
+*/
+static SNESTask tasks[] =
+{
+    { db9_task, TICKS_PER_READ, READER_STEPS },
+#if SERIAL_DEBUG
+    { debug_task, TICKS_PER_MS * DEBUG_CYCLE_IN_MS, 0 },
+#endif
+};
 
 /**
-	@brief Arduino pin mapping to SNES2DB9 mapping
+	@brief direct register access to an ATmega328P pin
 */
-static uint8_t pin_id[] =
+struct PinDef
 {
-    [SNES_LATCH] = 3,
-    [SNES_CLK] = 4,
-    [SNES_DATA] = 5,
-    [DB9_UP] = 7,
-    [DB9_DOWN] = 8,
-    [DB9_LEFT] = 9,
-    [DB9_RIGHT] = 10,
-    [DB9_FIRE] = 12
+    volatile uint8_t * ddr;   /**< data direction register */
+    volatile uint8_t * port;  /**< output register */
+    volatile uint8_t * in;    /**< input register */
+    uint8_t            mask;  /**< bitmask of the pin */
 };
 
+/**
+	@brief   ATmega328P pin mapping to SNES2DB9 mapping, Arduino Nano pin in the comments
+	@details Replaces pinMode()/digitalWrite()/digitalRead() which look the pin up at runtime for every edge.
+*/
+static const PinDef pin_def[] =
+{
+    [SNES_LATCH] = { &DDRD, &PORTD, &PIND, _BV(PD3) },  /* D3 */
+    [SNES_CLK]   = { &DDRD, &PORTD, &PIND, _BV(PD4) },  /* D4 */
+    [SNES_DATA]  = { &DDRD, &PORTD, &PIND, _BV(PD5) },  /* D5 */
+    [DB9_UP]     = { &DDRD, &PORTD, &PIND, _BV(PD7) },  /* D7 */
+    [DB9_DOWN]   = { &DDRB, &PORTB, &PINB, _BV(PB0) },  /* D8 */
+    [DB9_LEFT]   = { &DDRB, &PORTB, &PINB, _BV(PB1) },  /* D9 */
+    [DB9_RIGHT]  = { &DDRB, &PORTB, &PINB, _BV(PB2) },  /* D10 */
+    [DB9_FIRE]   = { &DDRB, &PORTB, &PINB, _BV(PB4) }   /* D12 */
+};
+
+#define DB9_MASK_PORTB (_BV(PB0) | _BV(PB1) | _BV(PB2) | _BV(PB4))  /**< DB9 pins on port B */
+#define DB9_MASK_PORTD (_BV(PD7))                                   /**< DB9 pins on port D */
+
+static uint8_t db9_low_b;  /**< DB9 pins on port B to drive low, collected by db9_collect() */
+static uint8_t db9_low_d;  /**< DB9 pins on port D to drive low, collected by db9_collect() */
+
 /**
 	@brief   hardware interaction fucntion to set pin to a given state
-	@details The Arduino pin mapping is used to update the associated Arduino signal.
+	@details The read-modify-write of the port registers is protected as the ports are shared with interrupts.
 */
 void pin_write ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
 {
     if (pin <= DB9_FIRE)
     {
-		if (state == SNES2DB9_PIN_HIGHZ)
+        const PinDef * def = &pin_def[pin];
+        uint8_t sreg = SREG;
+
+        cli();
+        if (state == SNES2DB9_PIN_HIGHZ)
         {
-			pinMode(pin_id[pin], INPUT);
+            *def->ddr &= (uint8_t)~def->mask;
+            *def->port &= (uint8_t)~def->mask;
         }
         else if (state == SNES2DB9_PIN_HIGH)
         {
-			pinMode(pin_id[pin], OUTPUT);
-            digitalWrite(pin_id[pin], 1);
+            *def->port |= def->mask;
+            *def->ddr |= def->mask;
         }
         else
         {
-			pinMode(pin_id[pin], OUTPUT);
-            digitalWrite(pin_id[pin], 0);
+            *def->port &= (uint8_t)~def->mask;
+            *def->ddr |= def->mask;
         }
+        SREG = sreg;
     }
 }
 
 /**
 	@brief   hardware interaction fucntion to read pin state
-	@details The Arduino pin mapping is used to read the associated Arduino signal and convert to SNES2DB9 realm.
+	@details The input register is read directly and converted to SNES2DB9 realm.
 */
 SNES2DB9_Pinstate pin_read ( SNES2DB9_Pin pin )
 {
     if (pin <= DB9_FIRE)
     {
-        return (SNES2DB9_Pinstate)digitalRead(pin_id[pin]);
+        return ((*pin_def[pin].in & pin_def[pin].mask) != 0) ? SNES2DB9_PIN_HIGH : SNES2DB9_PIN_LOW;
     }
     else
     {
@@ -78,9 +128,118 @@ SNES2DB9_Pinstate pin_read ( SNES2DB9_Pin pin )
     }
 }
 
+/**
+	@brief   collects the DB9 pins to drive low instead of setting them one by one
+	@details Released pins are left floating like with pin_write().
+*/
+static void db9_collect ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+    if (state == SNES2DB9_PIN_LOW)
+    {
+        if (pin_def[pin].port == &PORTB)
+        {
+            db9_low_b |= pin_def[pin].mask;
+        }
+        else
+        {
+            db9_low_d |= pin_def[pin].mask;
+        }
+    }
+}
+
+/**
+	@brief   updates all DB9 pins with one write of the data direction register per port
+	@details The output registers of the DB9 pins stay low, a pin is pressed by switching it to output.
+*/
+static void db9_write ( uint8_t db9_btnmask )
+{
+    uint8_t sreg;
+
+    db9_low_b = 0;
+    db9_low_d = 0;
+    DB9_SetPins(db9_btnmask, db9_collect);
+
+    sreg = SREG;
+    cli();
+    DDRB = (uint8_t)((DDRB & (uint8_t)~DB9_MASK_PORTB) | db9_low_b);
+    DDRD = (uint8_t)((DDRD & (uint8_t)~DB9_MASK_PORTD) | db9_low_d);
+    SREG = sreg;
+}
+
+/**
+	@brief   generate pulse pattern and update SNES reader state on timer tick
+	@details The reader is stepped here instead of from loop(), so neither a slow DB9 update
+	         nor a blocking serial output can stretch the SNES pulses.
+*/
 ISR(TIMER1_COMPA_vect) {
-    _200micros++;
+    SNESSnapshotData reading;
+    bool was_idle;
+
+    if (--read_countdown == 0)
+    {
+        read_countdown = TICKS_PER_READ;
+        SNESReader_BeginRead(&reader);
+    }
+
+    was_idle = SNESReader_IsIdle(&reader);
+    reading.snes_state = SNESReader_Update(&reader);
+
+    if ((was_idle == false) && (SNESReader_IsIdle(&reader) == true))
+    {
+        reading.db9_state = 0;
+        SNESSnapshot_Publish(&readings, &reading);
+    }
+
+    SNESScheduler_Tick(&scheduler);
+}
+
+/**
+	@brief update DB9 pins from the latest SNES reading
+*/
+static void db9_task ( void )
+{
+    SNESSnapshotData reading;
+
+    (void)SNESSnapshot_Read(&readings, &reading);
+    currentDB9 = SNESMapper_Update(&mapper, reading.snes_state, DB9_UPDATE_CYCLE_IN_MS);
+
+    db9_write(currentDB9);
+}
+
+#if SERIAL_DEBUG
+/**
+	@brief   print SNES and DB9 state changes
+	@details A line is only printed if it fits into the transmit buffer, so loop() never blocks in Serial.
+	         Skipped lines are counted and the change is printed with the next cycle.
+*/
+static void debug_task ( void )
+{
+    static uint16_t printedSNES = 0;
+    static uint8_t printedDB9 = 0;
+    static uint16_t skipped = 0;
+    SNESSnapshotData reading;
+    char line[40];
+    int len;
+
+    (void)SNESSnapshot_Read(&readings, &reading);
+
+    if ((reading.snes_state != printedSNES) || (currentDB9 != printedDB9))
+    {
+        len = snprintf(line, sizeof(line), "SNES %04X DB9 %02X skipped %u\n", reading.snes_state, currentDB9, skipped);
+
+        if (Serial.availableForWrite() >= len)
+        {
+            Serial.write((const uint8_t *)line, len);
+            printedSNES = reading.snes_state;
+            printedDB9 = currentDB9;
+        }
+        else
+        {
+            skipped++;
+        }
+    }
 }
+#endif
 
 void setupTimer1() {
     noInterrupts();
@@ -104,18 +263,17 @@ void setup()
 {
     SNESMapperButtonMasks button_config;
     
-    /* setup pin states */
-    for (uint8_t pin_idx = 0; pin_idx < sizeof(pin_id); pin_idx ++)
-    {
-        pinMode(pin_id[pin_idx], OUTPUT);
-    }
-    pinMode(pin_id[SNES_DATA], INPUT);
+    /* setup pin states, DB9 pins released: */
+    pin_write(SNES_DATA, SNES2DB9_PIN_HIGHZ);
+    PORTB &= (uint8_t)~DB9_MASK_PORTB;
+    PORTD &= (uint8_t)~DB9_MASK_PORTD;
+    db9_write(0);
 
 
-    /* initialize reader instance */
+    /* initialize reader instance, the first reading starts with the first tick: */
     SNESReader_Init(&reader, pin_write, pin_read);
-
-    SNESReader_BeginRead(&reader);
+    SNESSnapshot_Init(&readings);
+    read_countdown = 1;
 
     /* initialize mapper instance */
 
@@ -125,31 +283,17 @@ void setup()
     
     SNESMapper_Init(&mapper, &button_config);
 
+#if SERIAL_DEBUG
+    Serial.begin(115200);
+#endif
+
     /* prepare timer interrupt for SNES polling cycle: */
+    SNESScheduler_Init(&scheduler, tasks, sizeof(tasks) / sizeof(tasks[0]));
     setupTimer1();
 
 }
 
 void loop()
 {
-    // generate pulse pattern and update SNES reader state on timer tick
-
-    if (_200micros != 0)
-    {
-        currentSNES = SNESReader_Update(&reader);
-        _200micros = 0;
-    }
-
-    // schedule SNES reading in intervalls of 16ms (60Hz)
-    if (millis() - previousMillis >= 16)
-    {
-        uint8_t db9_btnmask = SNESMapper_Update(&mapper, currentSNES, 16);
-
-        DB9_SetPins(db9_btnmask, pin_write);
-
-        SNESReader_BeginRead(&reader);
-
-        previousMillis += 16;
-    }
+    SNESScheduler_Dispatch(&scheduler);
 }
-
@@ -0,0 +1 @@
+../../common/snes2db9_snapshot.c
\ No newline at end of file
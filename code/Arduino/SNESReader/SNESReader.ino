@@ -9,13 +9,22 @@
     @file    SNESReader.ino
     @brief   implements SNESReader handling on Arduino Nano
     @details This is used for wave pattern verification.
+             With DIAGNOSTIC_STREAM the pad is read back to back at the protocol rate instead and each
+             reading is sent as binary frame at 1 Mbaud for the stream_decode host tool.
 
 */
 
 #include "snes2db9.h"
 
+#define DIAGNOSTIC_STREAM      0        /**< 1 streams timestamped readings at 1 Mbaud instead of the slow wave pattern */
+#define STREAM_BAUD            1000000  /**< baud rate of the diagnostic stream */
+#define STREAM_HALF_PERIOD_US  6        /**< CLK half period of the diagnostic stream, as on the SNES */
+
 static SNESReader reader;           /**< SNES reader instance */
 static uint32_t previousMillis = 0; /**< keep track of milliseconds passed */
+#if DIAGNOSTIC_STREAM
+static uint8_t sequence = 0;        /**< sequence number of the next frame, counts dropped frames too */
+#endif
 
 /**
     @brief Arduino pin mapping to SNES2DB9 mapping
@@ -70,9 +79,83 @@ SNES2DB9_Pinstate pin_read ( SNES2DB9_Pin pin )
     return SNES2DB9_PIN_LOW;
 }
 
+#if DIAGNOSTIC_STREAM
+/**
+    @brief   hardware interaction function to set pin to a given state for the diagnostic stream
+    @details LATCH (D3) and CLK (D4) are written through the port register, digitalWrite() would stretch the pulses.
+*/
+void stream_pin_write ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+    uint8_t mask = (pin == SNES_LATCH) ? _BV(PD3) : ((pin == SNES_CLK) ? _BV(PD4) : 0);
+
+    if (state == SNES2DB9_PIN_HIGH)
+    {
+        PORTD |= mask;
+    }
+    else
+    {
+        PORTD &= (uint8_t)~mask;
+    }
+}
+
+/**
+    @brief   hardware interaction function to read the DATA pin (D13) for the diagnostic stream
+*/
+SNES2DB9_Pinstate stream_pin_read ( SNES2DB9_Pin pin )
+{
+    (void)pin;
+    return ((PINB & _BV(PB5)) != 0) ? SNES2DB9_PIN_HIGH : SNES2DB9_PIN_LOW;
+}
+
+/**
+    @brief   busy wait between the reader steps
+*/
+void stream_delay ( uint8_t microseconds )
+{
+    delayMicroseconds(microseconds);
+}
+
+/**
+    @brief   sends a reading as diagnostic stream frame
+    @details The frame is dropped if it does not fit into the transmit buffer, so the reading is never
+             delayed by the UART. The host tool detects the gap through the sequence number.
+*/
+static void stream_send ( uint32_t timestamp, uint16_t state )
+{
+    uint8_t frame[SNESSTREAM_FRAME_SIZE];
+
+    frame[0] = SNESSTREAM_SYNC;
+    frame[1] = sequence++;
+    frame[2] = (uint8_t)timestamp;
+    frame[3] = (uint8_t)(timestamp >> 8);
+    frame[4] = (uint8_t)(timestamp >> 16);
+    frame[5] = (uint8_t)(timestamp >> 24);
+    frame[6] = (uint8_t)state;
+    frame[7] = (uint8_t)(state >> 8);
+    frame[8] = SNESTelemetry_Crc8(&frame[1], SNESSTREAM_FRAME_SIZE - 2);
+
+    if (Serial.availableForWrite() >= (int)SNESSTREAM_FRAME_SIZE)
+    {
+        Serial.write(frame, SNESSTREAM_FRAME_SIZE);
+    }
+}
+#endif
+
 
 void setup()
 {
+#if DIAGNOSTIC_STREAM
+    pinMode(pin_id[SNES_LATCH], OUTPUT);
+    pinMode(pin_id[SNES_CLK], OUTPUT);
+    pinMode(pin_id[SNES_DATA], INPUT);
+
+    /* each SNESReader_Update() performs a complete reading: */
+    SNESReader_Init(&reader, stream_pin_write, stream_pin_read);
+    SNESReader_SetDelayFunc(&reader, stream_delay);
+    SNESReader_SetHalfPeriod(&reader, STREAM_HALF_PERIOD_US);
+
+    Serial.begin(STREAM_BAUD);
+#else
     /* setup pin states */
     for (uint8_t pin_idx = 0; pin_idx < sizeof(pin_id); pin_idx ++)
     {
@@ -88,10 +171,17 @@ void setup()
     SNESReader_Init(&reader, pin_write, pin_read);
 
     SNESReader_BeginRead(&reader);
+#endif
 }
 
 void loop()
 {
+#if DIAGNOSTIC_STREAM
+    uint32_t timestamp = micros();
+
+    SNESReader_BeginRead(&reader);
+    stream_send(timestamp, SNESReader_Update(&reader));
+#else
     // generate pulse pattern and update SNES reader state
     delay(1);
     SNESReader_Update(&reader);
@@ -103,5 +193,5 @@ void loop()
 
         SNESReader_BeginRead(&reader);
     }
+#endif
 }
-
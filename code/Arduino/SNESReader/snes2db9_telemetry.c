@@ -0,0 +1 @@
+../../common/snes2db9_telemetry.c
\ No newline at end of file
@@ -46,6 +46,10 @@ extern "C"
 #define SNES_BTNMASK_R       0x0010  /**< internal bitmask used for SNES button readings */
 /** @} */
 
+#define SNES_TRAILER_MASK    0x000F  /**< reading bits following button R, always released on a standard SNES gamepad */
+#define SNESREADER_STORAGE_SIZE 2u   /**< bytes used by SNESReader_SaveHalfPeriod() */
+#define SNESREADER_WAIT_UNLIMITED 0xFFFFu  /**< busy wait limit of SNESReader_SetWaitLimit() for complete readings in a single update */
+
 /**
  * @addtogroup DB9_BTNMASK_xxx
  * @{
@@ -59,6 +63,72 @@ extern "C"
 
 #define AUTOFIRE_CYCLETIME_IN_MS 100 /**< default autofire cycletime in ms */
 
+/**
+ * @addtogroup CD32_BTNMASK_xxx
+ * @{
+ */
+#define CD32_BTNMASK_Blue     0x0001  /**< CD32 serial image bit, shifted out 1st */
+#define CD32_BTNMASK_Red      0x0002  /**< CD32 serial image bit, shifted out 2nd */
+#define CD32_BTNMASK_Yellow   0x0004  /**< CD32 serial image bit, shifted out 3rd */
+#define CD32_BTNMASK_Green    0x0008  /**< CD32 serial image bit, shifted out 4th */
+#define CD32_BTNMASK_Forward  0x0010  /**< CD32 serial image bit, shifted out 5th (right shoulder) */
+#define CD32_BTNMASK_Reverse  0x0020  /**< CD32 serial image bit, shifted out 6th (left shoulder) */
+#define CD32_BTNMASK_Play     0x0040  /**< CD32 serial image bit, shifted out 7th */
+#define CD32_IMAGE_TRAILER    0xFF00  /**< pad identification: 8th bit released, 9th bit and all following pulled low */
+/** @} */
+
+#define PADDLE_POSITION_MAX   0xFF00u  /**< rightmost paddle position in 8.8 fixed point */
+#define PADDLE_SPEED_MIN      16u      /**< paddle speed on first movement in 1/256 positions per ms */
+#define PADDLE_SPEED_MAX      128u     /**< paddle speed reached by holding a direction in 1/256 positions per ms */
+#define PADDLE_ACCELERATION   1u       /**< paddle speed increase in 1/256 positions per ms for every ms a direction is held */
+
+#ifndef SNESMACRO_BUFFER_SIZE
+#define SNESMACRO_BUFFER_SIZE 128u     /**< macro event buffer in bytes, one byte per button toggle, at most 254 */
+#endif
+#define SNESMACRO_STORAGE_SIZE ( SNESMACRO_BUFFER_SIZE + 3u )  /**< bytes used by SNESMacro_Save() */
+
+#ifndef SNESPROFILE_COUNT
+#define SNESPROFILE_COUNT          4u  /**< number of mapping profiles in non-volatile storage */
+#endif
+#ifndef SNESPROFILE_JOURNAL_SLOTS
+#define SNESPROFILE_JOURNAL_SLOTS 32u  /**< number of journal entries the profile selection is spread across, at most 254 */
+#endif
+#define SNESPROFILE_RECORD_SIZE    9u  /**< bytes per stored profile including checksum */
+#define SNESPROFILE_STORAGE_SIZE   ( ( SNESPROFILE_COUNT * SNESPROFILE_RECORD_SIZE ) + ( 2u * SNESPROFILE_JOURNAL_SLOTS ) )  /**< bytes used by SNESProfiles */
+
+#define SNESCHORD_MAX         8u       /**< maximum number of chords per SNESChord instance, one bit each in the fired mask */
+
+#define SNESTELEMETRY_SYNC       0xA5u  /**< first byte of a telemetry frame */
+#define SNESTELEMETRY_FRAME_SIZE 12u    /**< bytes per telemetry frame including sync byte and CRC */
+#define SNESTELEMETRY_BITS_PER_BYTE 10u /**< UART bit times per byte, 8N1 */
+
+#define SNESSTREAM_SYNC          0x5Au  /**< first byte of a diagnostic stream frame of the SNESReader sketch */
+#define SNESSTREAM_FRAME_SIZE    9u     /**< bytes per diagnostic stream frame: sync, sequence, timestamp in µs (4), SNES state (2), CRC-8 */
+
+#define SNESTIMERREADER_BITS     16u    /**< bits of a SNES reading, one sample per falling CLK edge */
+
+/**
+ * @brief   memory barrier for data shared with interrupts or threads
+ * @details On AVR a compiler barrier is sufficient as there is a single core without reordering.
+ */
+#if defined(__AVR__)
+#define SNES2DB9_BARRIER()  __asm__ __volatile__ ( "" ::: "memory" )
+#else
+#define SNES2DB9_BARRIER()  __atomic_thread_fence ( __ATOMIC_SEQ_CST )
+#endif
+
+/**
+ * @addtogroup SNES2DB9_PROBE_xxx
+ * @brief   latency probe markers, a marker is output as burst of as many pulses as its value
+ * @{
+ */
+#define SNES2DB9_PROBE_LATCH   1u      /**< LATCH pulse of a reading started */
+#define SNES2DB9_PROBE_UPDATE  2u      /**< reading completed, SNESReader result updated */
+#define SNES2DB9_PROBE_OUTPUT  3u      /**< DB9 pin state changed */
+#define SNES2DB9_PROBE_MASK(marker)  ( 1u << ( marker ) )  /**< bit of a marker in a marker selection mask */
+#define SNES2DB9_PROBE_ALL     ( SNES2DB9_PROBE_MASK ( SNES2DB9_PROBE_LATCH ) | SNES2DB9_PROBE_MASK ( SNES2DB9_PROBE_UPDATE ) | SNES2DB9_PROBE_MASK ( SNES2DB9_PROBE_OUTPUT ) )  /**< selection of all markers */
+/** @} */
+
 /**
  * @brief   possible pin states to control SNES gamepad reading and DB9 output signals
  * @details The pinstates are used by the hardware abstraction routines to be implemented by the calling application.
@@ -104,6 +174,32 @@ typedef void ( *SNES2DB9_SetPinFunc ) ( SNES2DB9_Pin pin, SNES2DB9_Pinstate stat
  */
 typedef SNES2DB9_Pinstate ( *SNES2DB9_ReadPinFunc ) ( SNES2DB9_Pin pin );
 
+/**
+ * @brief     prototype for hardware abstraction to write a byte to non-volatile storage such as EEPROM
+ * @details   Implementations should skip the write if the stored value is unchanged to reduce wear.
+ * @param[in] address to write
+ * @param[in] value to write
+ */
+typedef void ( *SNES2DB9_WriteByteFunc ) ( uint16_t address, uint8_t value );
+
+/**
+ * @brief     prototype for hardware abstraction to read a byte from non-volatile storage such as EEPROM
+ * @param[in] address to read
+ * @returns   value stored
+ */
+typedef uint8_t ( *SNES2DB9_ReadByteFunc ) ( uint16_t address );
+
+/**
+ * @brief     prototype for hardware abstraction to busy wait
+ * @param[in] microseconds to wait at least
+ */
+typedef void ( *SNES2DB9_DelayFunc ) ( uint8_t microseconds );
+
+/**
+ * @brief   prototype for a task dispatched by SNESScheduler
+ */
+typedef void ( *SNES2DB9_TaskFunc ) ( void );
+
 /**
  * @brief   implements object to read the SNES gamepad
  * @details All members hall be considered private. Access should be routed through the SNESReader_... functions
@@ -111,10 +207,14 @@ typedef SNES2DB9_Pinstate ( *SNES2DB9_ReadPinFunc ) ( SNES2DB9_Pin pin );
 struct SNESReader
 {
     SNES2DB9_SetPinFunc  setpin;    /**< function pointer to hardware access function to set pin states */
-    SNES2DB9_ReadPinFunc getpin;    /**< function pointer to hardware access function to read pin states */
-    uint16_t             shiftreg;  /**< internal shift register to accumulate SNES button states read */
-    uint16_t             result;    /**< last complete SNES reading, bitcoded according to SNES_BTNMASK_xxx */
-    uint8_t              state;     /**< internal state */
+    SNES2DB9_ReadPinFunc getpin;       /**< function pointer to hardware access function to read pin states */
+    SNES2DB9_DelayFunc   delay;        /**< function pointer to hardware access function to busy wait, NULL if not available */
+    uint16_t             shiftreg;     /**< internal shift register to accumulate SNES button states read */
+    uint16_t             result;       /**< last complete SNES reading, bitcoded according to SNES_BTNMASK_xxx */
+    uint8_t              state;        /**< internal state */
+    uint16_t             wait_limit;   /**< busy wait per update in µs */
+    uint8_t              half_period;  /**< half period of CLK in µs between the steps of an update, 0 for one step per update */
+    uint8_t              steps;        /**< steps per update, derived from half_period and wait_limit */
 };
 
 typedef struct SNESReader SNESReader;
@@ -149,6 +249,272 @@ struct SNESMapper
 
 typedef struct SNESMapper SNESMapper;
 
+/**
+ * @brief   describes a mapping profile
+ * @see     SNESProfiles
+ */
+struct SNESProfile
+{
+    struct SNESMapperButtonMasks button_masks;               /**< SNES button mapping configuration */
+    uint16_t                     autofire_cycletime_millis;  /**< autofire toggle cycle time in ms, 0 disables autofire */
+};
+
+typedef struct SNESProfile SNESProfile;
+
+/**
+ * @brief   implements object to keep SNESPROFILE_COUNT mapping profiles and the selected profile in non-volatile storage
+ * @details The storage starts with the profile records, each with a checksum.
+ *          The selection follows as a journal of SNESPROFILE_JOURNAL_SLOTS entries written round robin
+ *          so each selection change wears a different location.
+ *          An entry consists of a sequence number and the profile index, the newest entry is found by the gap in the sequence.
+ *          All members shall be considered private. Access should be routed through the SNESProfiles_... functions
+ */
+struct SNESProfiles
+{
+    SNES2DB9_WriteByteFunc writefunc;       /**< hardware abstraction layer function to write a byte */
+    SNES2DB9_ReadByteFunc  readfunc;        /**< hardware abstraction layer function to read a byte */
+    uint16_t               address;         /**< address of the first byte in non-volatile storage */
+    uint8_t                selected;        /**< index of the selected profile */
+    uint8_t                journal_slot;    /**< journal entry holding the selection, or receiving it while pending */
+    uint8_t                journal_seq;     /**< sequence number of that journal entry */
+    bool                   journal_valid;   /**< the journal holds at least one entry, or its first entry is pending */
+    uint8_t                journal_pending; /**< bytes of the journal entry still to write, see SNESProfiles_WriteStep() */
+};
+
+typedef struct SNESProfiles SNESProfiles;
+
+/**
+ * @brief   defines a chord recognized by SNESChord
+ * @see     SNESChord
+ */
+struct SNESChordDef
+{
+    uint16_t button_mask;   /**< SNES buttons to hold together with the lead buttons, all other buttons must be released */
+    uint16_t hold_millis;   /**< duration the chord must be held before it fires, 0 fires on the first update */
+};
+
+typedef struct SNESChordDef SNESChordDef;
+
+/**
+ * @brief   implements object to recognize button chords for on-device commands
+ * @details A command is entered by holding the lead buttons, e.g. Select, and a chord of further buttons.
+ *          While the lead buttons are held, all pressed buttons are withheld from the output
+ *          and stay withheld until they are released, so no chord button leaks into the mapper.
+ *          Only the chords exactly matching the held buttons are checked, each chord fires once per hold.
+ *          All members shall be considered private. Access should be routed through the SNESChord_... functions
+ */
+struct SNESChord
+{
+    const SNESChordDef * chords;       /**< chord definitions */
+    uint8_t              nr_chords;    /**< number of chord definitions */
+    uint16_t             lead_mask;    /**< SNES buttons starting a command */
+    uint16_t             combo;        /**< buttons held besides the lead buttons */
+    uint16_t             held_millis;  /**< duration the combo is held unchanged, saturating */
+    uint16_t             suppressed;   /**< buttons withheld from the output until released */
+    uint8_t              done;         /**< chords fired during the current hold, one bit per chord */
+    uint8_t              fired;        /**< chords fired in the last update, one bit per chord */
+};
+
+typedef struct SNESChord SNESChord;
+
+/**
+ * @brief   describes a periodic task of SNESScheduler
+ * @details The application initializes func, period_ticks and offset_ticks, the remaining members are private.
+ * @see     SNESScheduler
+ */
+struct SNESTask
+{
+    SNES2DB9_TaskFunc func;          /**< task function */
+    uint16_t          period_ticks;  /**< task is released every period_ticks ticks */
+    uint16_t          offset_ticks;  /**< first release after offset_ticks ticks, 0 for a full period, spreads tasks with the same period */
+    uint16_t          countdown;     /**< ticks until the next release */
+    uint16_t          pending;       /**< releases not yet executed, saturating */
+    uint8_t           overruns;      /**< releases while the previous one was still pending, saturating */
+};
+
+typedef struct SNESTask SNESTask;
+
+/**
+ * @brief   timing instrumentation counters of SNESScheduler
+ * @see     SNESScheduler_GetStats
+ */
+struct SNESSchedulerStats
+{
+    uint16_t missed_ticks;   /**< ticks not processed before the following tick, i.e. task releases delayed by a busy main loop, saturating */
+    uint8_t  max_backlog;    /**< maximum number of ticks processed by a single SNESScheduler_Dispatch() call, saturating */
+    uint16_t max_iteration;  /**< longest main loop iteration reported with SNESScheduler_ReportIteration(), in timer counts */
+};
+
+typedef struct SNESSchedulerStats SNESSchedulerStats;
+
+/**
+ * @brief   implements a table driven cooperative scheduler for periodic tasks
+ * @details A timer interrupt calls SNESScheduler_Tick(), the main loop calls SNESScheduler_Dispatch().
+ *          Ticks are counted, not flagged, so a slow dispatch loop does not lose releases.
+ *          The task table order defines the priority, the first task has the highest priority.
+ *          All members shall be considered private. Access should be routed through the SNESScheduler_... functions
+ */
+struct SNESScheduler
+{
+    SNESTask *         tasks;        /**< task table */
+    uint8_t            nr_tasks;     /**< number of tasks in the table */
+    volatile uint16_t  ticks;        /**< tick counter, only written by SNESScheduler_Tick() */
+    uint16_t           ticks_seen;   /**< tick counter value processed by SNESScheduler_Dispatch() */
+    SNESSchedulerStats stats;        /**< timing instrumentation counters */
+};
+
+typedef struct SNESScheduler SNESScheduler;
+
+/**
+ * @brief   sequence counter of SNESSnapshot, must be read and written with a single access on the target
+ */
+#if defined(__AVR__)
+typedef uint8_t SNESSnapshotSeq;
+#else
+typedef uint32_t SNESSnapshotSeq;
+#endif
+
+/**
+ * @brief   state passed from the reader to the mapper and output stages
+ * @see     SNESSnapshot
+ */
+struct SNESSnapshotData
+{
+    uint16_t snes_state;  /**< SNES gamepad state bitcoded according to SNES_BTNMASK_xxx */
+    uint8_t  db9_state;   /**< DB9 joystick state bitcoded according to DB9_BTNMASK_xxx */
+};
+
+typedef struct SNESSnapshotData SNESSnapshotData;
+
+/**
+ * @brief   implements a lock free double buffered handoff of SNESSnapshotData between interrupt and task context
+ * @details A single writer publishes into the buffer not currently readable and then advances the sequence counter.
+ *          Readers copy the readable buffer and retry if the counter changed meanwhile, so no reader ever sees a
+ *          torn state and interrupts are never disabled. A reader in interrupt context never retries.
+ *          All members shall be considered private. Access should be routed through the SNESSnapshot_... functions
+ */
+struct SNESSnapshot
+{
+    volatile SNESSnapshotData buffer[2];  /**< buffer[sequence & 1] is readable, the other one is written */
+    volatile SNESSnapshotSeq  sequence;   /**< number of publications */
+};
+
+typedef struct SNESSnapshot SNESSnapshot;
+
+/**
+ * @brief   implements object to read the SNES gamepad with a CLK waveform generated by a hardware timer
+ * @details The timer drives CLK through its compare output pin, SNESTimerReader_Sample() is called from the
+ *          compare interrupt at every falling CLK edge and shifts in the DATA bit which is stable since the
+ *          preceding rising edge. The completed reading is handed to the task context through a SNESSnapshot.
+ *          All members shall be considered private. Access should be routed through the SNESTimerReader_... functions
+ */
+struct SNESTimerReader
+{
+    SNESSnapshot     snapshot;  /**< completed readings, published from the interrupt */
+    uint16_t         shiftreg;  /**< internal shift register to accumulate SNES button states read */
+    volatile uint8_t bit;       /**< number of bits sampled, SNESTIMERREADER_BITS if idle */
+};
+
+typedef struct SNESTimerReader SNESTimerReader;
+
+/**
+ * @brief   state reported by a telemetry frame
+ * @see     SNESTelemetry_Encode
+ */
+struct SNESTelemetryData
+{
+    uint16_t           snes_state;  /**< SNES gamepad state bitcoded according to SNES_BTNMASK_xxx */
+    uint8_t            db9_state;   /**< DB9 joystick state bitcoded according to DB9_BTNMASK_xxx */
+    uint8_t            status;      /**< application defined status bits */
+    SNESSchedulerStats timing;      /**< scheduler instrumentation counters */
+};
+
+typedef struct SNESTelemetryData SNESTelemetryData;
+
+/**
+ * @brief   implements a transmit only software UART sending telemetry frames
+ * @details The frame is queued with SNESTelemetry_Send() from the main loop and shifted out with one
+ *          SNESTelemetry_Update() call per bit time, 8N1 with LSB first, usually from the timer interrupt.
+ *          All members shall be considered private. Access should be routed through the SNESTelemetry_... functions
+ */
+struct SNESTelemetry
+{
+    uint8_t          frame[SNESTELEMETRY_FRAME_SIZE];  /**< frame under transmission */
+    volatile uint8_t length;                           /**< bytes of the frame under transmission, 0 if idle */
+    uint8_t          index;                            /**< byte under transmission */
+    uint8_t          bit;                              /**< bit time of the byte, 0 is the start bit, 9 the stop bit */
+    uint8_t          sequence;                         /**< sequence number of the next frame */
+};
+
+typedef struct SNESTelemetry SNESTelemetry;
+
+/**
+ * @brief   implements object to emulate the serial button protocol of an Amiga CD32 gamepad
+ * @details The serial image is built once per SNES reading with CD32Pad_Update().
+ *          The host clock edges are served from interrupt context through CD32Pad_Load() and CD32Pad_Clock()
+ *          which only shift the precomputed image.
+ *          All members shall be considered private. Access should be routed through the CD32Pad_... functions
+ */
+struct CD32Pad
+{
+    uint16_t          image;     /**< serial button image bitcoded according to CD32_BTNMASK_xxx (active high), LSB is shifted out first */
+    volatile uint16_t shiftreg;  /**< shift register serviced by the host clock, bit 0 is the level currently presented */
+};
+
+typedef struct CD32Pad CD32Pad;
+
+/**
+ * @brief   implements object to emulate an analogue paddle from the SNES directional pad
+ * @details SNES Left/Right move the paddle with acceleration while held, L slows down and R speeds up the movement.
+ *          All members shall be considered private. Access should be routed through the SNESPaddle_... functions
+ */
+struct SNESPaddle
+{
+    uint16_t position;  /**< paddle position in 8.8 fixed point, 0 is leftmost, PADDLE_POSITION_MAX is rightmost */
+    uint16_t speed;     /**< current movement speed in 1/256 positions per ms */
+};
+
+typedef struct SNESPaddle SNESPaddle;
+
+/**
+ * @brief operating modes of SNESMacro
+ */
+enum SNESMacroMode
+{
+	SNESMACRO_IDLE,       /**< input is passed through */
+	SNESMACRO_RECORDING,  /**< input is passed through and recorded */
+	SNESMACRO_PLAYBACK,   /**< recorded input replaces the live input */
+	SNESMACRO_SAVING      /**< input is passed through, the recording is written by SNESMacro_SaveStep() */
+};
+
+typedef enum SNESMacroMode SNESMacroMode;  /**< see enum SNESMacroMode */
+
+/**
+ * @brief   implements object to record SNES gamepad input and play it back with frame accuracy
+ * @details Each button toggle is stored in one byte: high nibble is the number of frames (0..14) since the previous event,
+ *          low nibble the SNES_BTNMASK_xxx bit number of the button, 0 for a pure wait.
+ *          High nibble 15 is a long wait of (low nibble + 1) * 15 frames.
+ *          The buffer is a ring, when full the oldest events are folded into the start state.
+ *          All members shall be considered private. Access should be routed through the SNESMacro_... functions
+ */
+struct SNESMacro
+{
+    uint8_t  events[SNESMACRO_BUFFER_SIZE];  /**< recorded events in ring buffer order */
+    uint8_t  head;                           /**< index of the oldest event */
+    uint8_t  count;                          /**< number of recorded events */
+    uint16_t start_state;                    /**< SNES state at the start of the recording */
+    uint16_t state;                          /**< last recorded or currently played SNES state */
+    uint8_t  frames;                         /**< recording: frames since the last event */
+    uint8_t  cursor;                         /**< playback: number of events processed */
+    uint8_t  wait;                           /**< playback: frames to wait before the next event */
+    bool     loaded;                         /**< playback: wait has been loaded from the next event */
+    bool     loop;                           /**< playback restarts at the end */
+    uint8_t  mode;                           /**< operating mode according to SNESMacroMode */
+    uint16_t save_step;                      /**< saving: next byte to write, see SNESMacro_SaveStep() */
+};
+
+typedef struct SNESMacro SNESMacro;
+
 /**
  * @brief          initializes SNESReader instance
  * @details        The caller has to assign hardware abstraction functions for hardware access.
@@ -161,7 +527,8 @@ void     SNESReader_Init ( SNESReader * self, SNES2DB9_SetPinFunc setfunc, SNES2
 
 /**
  * @brief          updates SNESReader internal state until complete reading has been obtained
- * @details        - The callrate determines duration of SNES hardware control pulses.
+ * @details        - The callrate determines duration of SNES hardware control pulses, unless a half period is
+ *                   selected which separates the steps of one update.
  *                 - Once a complete reading has been obtained, the update a new reading must be requested through SNESReader_BeginRead()
  * @see            SNESReader_BeginRead
  * @param[in, out] self points to instance of SNESReader
@@ -175,6 +542,94 @@ uint16_t SNESReader_Update ( SNESReader * self );
  */
 void     SNESReader_BeginRead ( SNESReader * self );
 
+/**
+ * @brief          checks if the reader has completed the requested reading
+ * @details        The transition to idle happens in the SNESReader_Update() call publishing the new result.
+ * @param[in]      self points to instance of SNESReader
+ * @returns        true if no reading is in progress
+ */
+bool     SNESReader_IsIdle ( const SNESReader * self );
+
+/**
+ * @brief          assigns the busy wait function required for a half period
+ * @param[in, out] self points to instance of SNESReader
+ * @param[in]      delayfunc points to hardware abstraction function to busy wait
+ */
+void     SNESReader_SetDelayFunc ( SNESReader * self, SNES2DB9_DelayFunc delayfunc );
+
+/**
+ * @brief          selects the CLK timing
+ * @details        With a half period of 0, the default, each SNESReader_Update() call performs one step and the
+ *                 callrate determines the pulse widths. Otherwise each SNESReader_Update() call performs as many
+ *                 steps as fit into the busy wait limit, separated by busy waits of half_period_us, the complete
+ *                 reading with the default limit.
+ * @see            SNESReader_SetWaitLimit
+ * @param[in, out] self points to instance of SNESReader
+ * @param[in]      half_period_us of CLK in µs, 0 for one step per update
+ */
+void     SNESReader_SetHalfPeriod ( SNESReader * self, uint8_t half_period_us );
+
+/**
+ * @brief          limits the busy wait per SNESReader_Update() call
+ * @details        A reading then spans several updates if the half period requires, the callrate separates
+ *                 the steps of consecutive updates. A half period exceeding the limit yields one step per update.
+ * @param[in, out] self points to instance of SNESReader
+ * @param[in]      wait_us busy wait in µs, SNESREADER_WAIT_UNLIMITED for complete readings in a single update
+ */
+void     SNESReader_SetWaitLimit ( SNESReader * self, uint16_t wait_us );
+
+/**
+ * @brief      returns the CLK timing
+ * @param[in]  self points to instance of SNESReader
+ * @returns    half period of CLK in µs, 0 for one step per update
+ */
+uint8_t  SNESReader_GetHalfPeriod ( const SNESReader * self );
+
+/**
+ * @brief      checks a reading against the trailer bits of a standard SNES gamepad
+ * @param[in]  reading bitcoded according to SNES_BTNMASK_xxx
+ * @returns    true if all bits of SNES_TRAILER_MASK are released
+ */
+bool     SNESReader_IsValid ( uint16_t reading );
+
+/**
+ * @brief          determines the fastest CLK timing the connected gamepad is read reliably with
+ * @details        The half periods are probed in the given order, slowest first, until one fails. Each reading is
+ *                 completed within the call regardless of the busy wait limit. A half period
+ *                 passes if all of its readings are valid and equal the expected state, which is obtained by the caller
+ *                 with a known good timing. A held button makes missed CLK edges visible, as its bit moves.
+ *                 The fastest passing half period is selected, 0 if none passes.
+ * @param[in, out] self points to instance of SNESReader, idle and with a busy wait function assigned
+ * @param[in]      expected SNES gamepad state bitcoded according to SNES_BTNMASK_xxx
+ * @param[in]      half_periods_us to probe in µs, slowest first
+ * @param[in]      count of half periods
+ * @param[in]      reads per half period
+ * @returns        selected half period in µs, 0 if none passed
+ */
+uint8_t  SNESReader_Calibrate ( SNESReader * self, uint16_t expected, const uint8_t * half_periods_us, uint8_t count, uint8_t reads );
+
+/**
+ * @brief     stores the CLK timing in non-volatile storage
+ * @details   SNESREADER_STORAGE_SIZE bytes are used starting from address.
+ * @param[in] self points to instance of SNESReader
+ * @param[in] writefunc points to hardware abstraction function to write a byte
+ * @param[in] address of the first byte
+ */
+void     SNESReader_SaveHalfPeriod ( const SNESReader * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address );
+
+/**
+ * @brief          loads the CLK timing from non-volatile storage
+ * @details        The timing is left unchanged if the stored data is invalid, e.g. erased EEPROM, or the stored
+ *                 half period is neither 0 nor one of the probed ones. A half period requires a busy wait function assigned.
+ * @param[in, out] self points to instance of SNESReader
+ * @param[in]      readfunc points to hardware abstraction function to read a byte
+ * @param[in]      address of the first byte
+ * @param[in]      half_periods_us accepted in µs, as probed by SNESReader_Calibrate()
+ * @param[in]      count of half periods
+ * @returns        true if a timing has been loaded
+ */
+bool     SNESReader_LoadHalfPeriod ( SNESReader * self, SNES2DB9_ReadByteFunc readfunc, uint16_t address, const uint8_t * half_periods_us, uint8_t count );
+
 /**
  * @brief          initializes SNESMapper instance
  * @details        - The caller has to assign SNES button masks for subsequent operation.
@@ -194,7 +649,8 @@ void     SNESMapper_SetAutofireDuration ( SNESMapper * self, uint16_t autofire_c
 
 /**
  * @brief          updates DB9 pin state configuration from given SNES button inputs
- * @details        Autofire behaviour is computed during the update.
+ * @details        Autofire behaviour is computed during the update. The autofire phase follows the accumulated time:
+ *                 it toggles once per complete cycle time, also if a single update spans several cycles.
  * @param[in, out] self points to instance of SNESMapper
  * @param[in]      snes_pin_mask describes the current SNES button state as a  bitmask composed of SNES_BTNMASK_xxx (active high)
  * @param[in]      millis_passed is the number of ms passed since last call to SNESMapper_Update
@@ -211,6 +667,414 @@ uint8_t  SNESMapper_Update ( SNESMapper * self, uint16_t snes_pin_mask, uint16_t
  */
 void DB9_SetPins ( uint8_t state, SNES2DB9_SetPinFunc setfunc );
 
+/**
+ * @brief          initializes CD32Pad instance
+ * @details        The serial image is initialized to no buttons pressed.
+ * @param[in, out] self points to instance of CD32Pad
+ */
+void     CD32Pad_Init ( CD32Pad * self );
+
+/**
+ * @brief          builds the serial button image from given SNES button inputs
+ * @details        Call once per complete SNES reading. The image is picked up by the next CD32Pad_Load().
+ *                 SNES B/A/Y/X map to Red/Blue/Green/Yellow, R/L to Forward/Reverse and Start to Play.
+ * @param[in, out] self points to instance of CD32Pad
+ * @param[in]      snes_pin_mask describes the current SNES button state as a bitmask composed of SNES_BTNMASK_xxx (active high)
+ */
+void     CD32Pad_Update ( CD32Pad * self, uint16_t snes_pin_mask );
+
+/**
+ * @brief          loads the serial image into the shift register
+ * @details        To be called from interrupt context when the host pulls the mode line low.
+ * @param[in, out] self points to instance of CD32Pad
+ * @returns        pin state to present on the serial data line for the first button
+ */
+SNES2DB9_Pinstate CD32Pad_Load ( CD32Pad * self );
+
+/**
+ * @brief          shifts the serial image by one button
+ * @details        To be called from interrupt context on each rising host clock edge while the mode line is low.
+ *                 Once the image is exhausted, the data line stays pulled low.
+ * @param[in, out] self points to instance of CD32Pad
+ * @returns        pin state to present on the serial data line for the next button
+ */
+SNES2DB9_Pinstate CD32Pad_Clock ( CD32Pad * self );
+
+/**
+ * @brief          initializes SNESPaddle instance
+ * @details        The paddle starts centered.
+ * @param[in, out] self points to instance of SNESPaddle
+ */
+void     SNESPaddle_Init ( SNESPaddle * self );
+
+/**
+ * @brief          integrates the paddle position from given SNES button inputs
+ * @param[in, out] self points to instance of SNESPaddle
+ * @param[in]      snes_pin_mask describes the current SNES button state as a bitmask composed of SNES_BTNMASK_xxx (active high)
+ * @param[in]      millis_passed is the number of ms passed since last call to SNESPaddle_Update
+ * @returns        paddle position from 0 (leftmost) to 255 (rightmost)
+ */
+uint8_t  SNESPaddle_Update ( SNESPaddle * self, uint16_t snes_pin_mask, uint16_t millis_passed );
+
+/**
+ * @brief          converts the paddle position into a pot line delay
+ * @details        The rightmost position yields the shortest delay, corresponding to the lowest pot resistance.
+ *                 Units of the delay are defined by the caller, e.g. timer ticks.
+ * @param[in]      self points to instance of SNESPaddle
+ * @param[in]      min_delay is the delay for the rightmost position
+ * @param[in]      max_delay is the delay for the leftmost position
+ * @returns        delay interpolated between max_delay and min_delay
+ */
+uint16_t SNESPaddle_GetDelay ( const SNESPaddle * self, uint16_t min_delay, uint16_t max_delay );
+
+/**
+ * @brief          initializes SNESMacro instance
+ * @details        The macro is empty and idle.
+ * @param[in, out] self points to instance of SNESMacro
+ */
+void     SNESMacro_Init ( SNESMacro * self );
+
+/**
+ * @brief          starts a new recording, the previous recording is discarded
+ * @details        Ignored while saving.
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      snes_pin_mask is the current SNES button state, becomes the start state
+ */
+void     SNESMacro_StartRecording ( SNESMacro * self, uint16_t snes_pin_mask );
+
+/**
+ * @brief          starts playback of the recording
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      loop restarts playback at the end until SNESMacro_Stop() is called
+ * @returns        false if there is no recording to play or a save is running
+ */
+bool     SNESMacro_StartPlayback ( SNESMacro * self, bool loop );
+
+/**
+ * @brief          stops recording or playback
+ * @details        A recording is terminated with the time passed since the last event, so playback keeps the total duration.
+ *                 A running save is not interrupted.
+ * @param[in, out] self points to instance of SNESMacro
+ */
+void     SNESMacro_Stop ( SNESMacro * self );
+
+/**
+ * @brief          processes one frame
+ * @details        Call once per SNES reading / DB9 update, the frame period defines the timing resolution.
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      snes_pin_mask describes the current SNES button state as a bitmask composed of SNES_BTNMASK_xxx (active high)
+ * @returns        SNES button state to map, the live input unless a playback is running
+ */
+uint16_t SNESMacro_Update ( SNESMacro * self, uint16_t snes_pin_mask );
+
+/**
+ * @brief     returns the operating mode
+ * @param[in] self points to instance of SNESMacro
+ * @returns   mode according to SNESMacroMode
+ */
+SNESMacroMode SNESMacro_GetMode ( const SNESMacro * self );
+
+/**
+ * @brief     stores the recording in non-volatile storage
+ * @details   SNESMACRO_STORAGE_SIZE bytes are used starting from address. The count byte is invalidated first and
+ *            written last, so an interrupted save is rejected by SNESMacro_Load().
+ *            Blocks for all bytes, see SNESMacro_StartSave() for saving in the background.
+ * @param[in] self points to instance of SNESMacro
+ * @param[in] writefunc points to hardware abstraction function to write a byte
+ * @param[in] address of the first byte
+ */
+void     SNESMacro_Save ( const SNESMacro * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address );
+
+/**
+ * @brief          starts saving the recording in the background
+ * @details        A recording is stopped first, a playback is ended. Until the save has completed the mode is
+ *                 SNESMACRO_SAVING and the input is passed through.
+ * @param[in, out] self points to instance of SNESMacro
+ */
+void     SNESMacro_StartSave ( SNESMacro * self );
+
+/**
+ * @brief          writes the next byte of a save started with SNESMacro_StartSave()
+ * @details        Call once per frame when the storage is ready to accept a byte, e.g. eeprom_is_ready().
+ *                 The bytes are written in the order of SNESMacro_Save(), the count byte last commits the save.
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      writefunc points to hardware abstraction function to write a byte
+ * @param[in]      address of the first byte
+ * @returns        true if further bytes are pending, false once the save has completed or none is running
+ */
+bool     SNESMacro_SaveStep ( SNESMacro * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address );
+
+/**
+ * @brief          loads a recording from non-volatile storage
+ * @details        The macro is left empty if the stored data is invalid, e.g. erased EEPROM.
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      readfunc points to hardware abstraction function to read a byte
+ * @param[in]      address of the first byte
+ * @returns        true if a recording has been loaded
+ */
+bool     SNESMacro_Load ( SNESMacro * self, SNES2DB9_ReadByteFunc readfunc, uint16_t address );
+
+/**
+ * @brief          initializes SNESProfiles instance
+ * @details        The selected profile is restored from the journal, profile 0 if there is none.
+ *                 Profile records with an invalid checksum, e.g. erased EEPROM, are overwritten with the given defaults.
+ * @param[in, out] self points to instance of SNESProfiles
+ * @param[in]      writefunc points to hardware abstraction function to write a byte
+ * @param[in]      readfunc points to hardware abstraction function to read a byte
+ * @param[in]      address of the first byte, SNESPROFILE_STORAGE_SIZE bytes are used
+ * @param[in]      defaults points to SNESPROFILE_COUNT default profiles
+ */
+void     SNESProfiles_Init ( SNESProfiles * self, SNES2DB9_WriteByteFunc writefunc, SNES2DB9_ReadByteFunc readfunc,
+                             uint16_t address, const SNESProfile * defaults );
+
+/**
+ * @brief      reads a profile from non-volatile storage
+ * @param[in]  self points to instance of SNESProfiles
+ * @param[in]  index of the profile
+ * @param[out] profile is filled in from storage
+ * @returns    false if the index or the stored record is invalid
+ */
+bool     SNESProfiles_Load ( const SNESProfiles * self, uint8_t index, SNESProfile * profile );
+
+/**
+ * @brief          writes a profile to non-volatile storage
+ * @param[in, out] self points to instance of SNESProfiles
+ * @param[in]      index of the profile
+ * @param[in]      profile to store
+ */
+void     SNESProfiles_Store ( SNESProfiles * self, uint8_t index, const SNESProfile * profile );
+
+/**
+ * @brief          selects a profile and configures the mapper with it
+ * @details        The mapper is reinitialized, SNESMapper_Update() is not affected by the profile handling.
+ *                 A changed selection is queued for the next journal entry, see SNESProfiles_WriteStep().
+ * @param[in, out] self points to instance of SNESProfiles
+ * @param[in]      index of the profile
+ * @param[in, out] mapper points to instance of SNESMapper to configure
+ * @returns        false if the profile cannot be loaded, mapper and selection are unchanged then
+ */
+bool     SNESProfiles_Select ( SNESProfiles * self, uint8_t index, SNESMapper * mapper );
+
+/**
+ * @brief          writes the next byte of a journal entry queued by SNESProfiles_Select()
+ * @details        Call once per frame when the storage is ready to accept a byte, e.g. eeprom_is_ready().
+ *                 The profile index is written first, the sequence number last commits the entry.
+ *                 A selection changed in between is written to the same entry.
+ * @param[in, out] self points to instance of SNESProfiles
+ * @returns        true if further bytes are pending, false once the entry has been written or none is queued
+ */
+bool     SNESProfiles_WriteStep ( SNESProfiles * self );
+
+/**
+ * @brief     returns the index of the selected profile
+ * @param[in] self points to instance of SNESProfiles
+ * @returns   index of the selected profile
+ */
+uint8_t  SNESProfiles_GetSelected ( const SNESProfiles * self );
+/**
+ * @brief          initializes SNESChord instance
+ * @param[in, out] self points to instance of SNESChord
+ * @param[in]      lead_mask are the SNES buttons to hold for command entry
+ * @param[in]      chords points to chord definitions, must remain valid
+ * @param[in]      nr_chords is the number of chord definitions, at most SNESCHORD_MAX
+ */
+void     SNESChord_Init ( SNESChord * self, uint16_t lead_mask, const SNESChordDef * chords, uint8_t nr_chords );
+
+/**
+ * @brief          processes a SNES reading
+ * @param[in, out] self points to instance of SNESChord
+ * @param[in]      snes_pin_mask describes the current SNES button state as a bitmask composed of SNES_BTNMASK_xxx (active high)
+ * @param[in]      millis_passed is the number of ms passed since last call to SNESChord_Update
+ * @returns        SNES button state without the buttons used for command entry
+ */
+uint16_t SNESChord_Update ( SNESChord * self, uint16_t snes_pin_mask, uint16_t millis_passed );
+
+/**
+ * @brief     returns the chords fired by the last SNESChord_Update() call
+ * @param[in] self points to instance of SNESChord
+ * @returns   bitmask with bit n set if chord n has fired
+ */
+uint8_t  SNESChord_GetFired ( const SNESChord * self );
+/**
+ * @brief          initializes SNESScheduler instance
+ * @param[in, out] self points to instance of SNESScheduler
+ * @param[in, out] tasks points to the task table, must remain valid
+ * @param[in]      nr_tasks is the number of tasks in the table
+ */
+void     SNESScheduler_Init ( SNESScheduler * self, SNESTask * tasks, uint8_t nr_tasks );
+
+/**
+ * @brief          advances the scheduler time by one tick
+ * @details        Call from the timer interrupt. Only a 16 bit counter is incremented, up to 65535 ticks (13s at 200us)
+ *                 may pass between calls to SNESScheduler_Dispatch() without loss. No locking is needed, the main loop
+ *                 only reads the counter and repeats the read until two reads agree.
+ * @param[in, out] self points to instance of SNESScheduler
+ */
+static inline void SNESScheduler_Tick ( SNESScheduler * self )
+{
+	self->ticks++;
+}
+
+/**
+ * @brief          releases the tasks due since the last call and executes the pending task with the highest priority
+ * @details        Call repeatedly from the main loop. Each release executes its task once.
+ * @param[in, out] self points to instance of SNESScheduler
+ * @returns        true if a task was executed, false if the scheduler is idle until the next tick
+ */
+bool     SNESScheduler_Dispatch ( SNESScheduler * self );
+
+/**
+ * @brief     returns the overrun counter of a task
+ * @param[in] self points to instance of SNESScheduler
+ * @param[in] index of the task in the table
+ * @returns   number of releases while the previous release was still pending, saturates at 255
+ */
+uint8_t  SNESScheduler_GetOverruns ( const SNESScheduler * self, uint8_t index );
+
+/**
+ * @brief     checks if the scheduler has nothing to do until the next tick
+ * @details   Call with interrupts disabled before entering a sleep mode woken by the tick interrupt,
+ *            otherwise a tick arriving after the check delays its tasks by a full tick.
+ * @param[in] self points to instance of SNESScheduler
+ * @returns   true if no tick is unprocessed and no task is pending
+ */
+bool     SNESScheduler_IsIdle ( const SNESScheduler * self );
+
+/**
+ * @brief     returns the tick counter
+ * @details   Combined with the timer count register, the application can timestamp with sub tick resolution.
+ * @param[in] self points to instance of SNESScheduler
+ * @returns   number of ticks modulo 256
+ */
+uint8_t  SNESScheduler_GetTicks ( const SNESScheduler * self );
+
+/**
+ * @brief          reports the duration of a main loop iteration for the instrumentation counters
+ * @param[in, out] self points to instance of SNESScheduler
+ * @param[in]      timer_counts is the measured duration in timer counts
+ */
+void     SNESScheduler_ReportIteration ( SNESScheduler * self, uint16_t timer_counts );
+
+/**
+ * @brief      returns the timing instrumentation counters
+ * @param[in]  self points to instance of SNESScheduler
+ * @param[out] stats is filled in with the counters
+ */
+void     SNESScheduler_GetStats ( const SNESScheduler * self, SNESSchedulerStats * stats );
+
+/**
+ * @brief          clears the timing instrumentation counters
+ * @param[in, out] self points to instance of SNESScheduler
+ */
+void     SNESScheduler_ResetStats ( SNESScheduler * self );
+
+/**
+ * @brief          initializes SNESSnapshot instance with an all released state
+ * @param[in, out] self points to instance of SNESSnapshot
+ */
+void     SNESSnapshot_Init ( SNESSnapshot * self );
+
+/**
+ * @brief          publishes a new state
+ * @details        Only a single writer is allowed, it must not be interrupted by another writer.
+ * @param[in, out] self points to instance of SNESSnapshot
+ * @param[in]      data to publish
+ */
+void     SNESSnapshot_Publish ( SNESSnapshot * self, const SNESSnapshotData * data );
+
+/**
+ * @brief      reads a consistent copy of the last published state
+ * @param[in]  self points to instance of SNESSnapshot
+ * @param[out] data copy of the state
+ * @returns    sequence number of the copy, changes with every publication
+ */
+SNESSnapshotSeq SNESSnapshot_Read ( const SNESSnapshot * self, SNESSnapshotData * data );
+
+/**
+ * @brief          initializes SNESTimerReader instance, idle with an all released state
+ * @param[in, out] self points to instance of SNESTimerReader
+ */
+void     SNESTimerReader_Init ( SNESTimerReader * self );
+
+/**
+ * @brief          arms the instance for a new reading
+ * @details        Called after the LATCH pulse and before the CLK timer is started.
+ *                 A reading in progress is discarded.
+ * @param[in, out] self points to instance of SNESTimerReader
+ */
+void     SNESTimerReader_BeginRead ( SNESTimerReader * self );
+
+/**
+ * @brief          shifts in the DATA level sampled at a falling CLK edge
+ * @details        To be called from the timer compare interrupt. The last bit publishes the reading.
+ * @param[in, out] self points to instance of SNESTimerReader
+ * @param[in]      data level of the SNES DATA pin, low for a pressed button
+ * @returns        true if the reading is complete and the CLK timer has to be stopped
+ */
+bool     SNESTimerReader_Sample ( SNESTimerReader * self, SNES2DB9_Pinstate data );
+
+/**
+ * @brief      checks if no reading is in progress
+ * @param[in]  self points to instance of SNESTimerReader
+ * @returns    true if idle
+ */
+bool     SNESTimerReader_IsIdle ( const SNESTimerReader * self );
+
+/**
+ * @brief      returns the last completed reading
+ * @param[in]  self points to instance of SNESTimerReader
+ * @param[out] snes_state SNES gamepad state bitcoded according to SNES_BTNMASK_xxx
+ * @returns    number of completed readings, changes with every reading
+ */
+SNESSnapshotSeq SNESTimerReader_GetState ( const SNESTimerReader * self, uint16_t * snes_state );
+
+/**
+ * @brief          initializes SNESTelemetry instance
+ * @param[in, out] self points to instance of SNESTelemetry
+ */
+void     SNESTelemetry_Init ( SNESTelemetry * self );
+
+/**
+ * @brief      computes the CRC-8 (polynomial 0x07, initial value 0) used by telemetry frames
+ * @param[in]  data to check
+ * @param[in]  length of data in bytes
+ * @returns    CRC of the data
+ */
+uint8_t  SNESTelemetry_Crc8 ( const uint8_t * data, uint8_t length );
+
+/**
+ * @brief      serializes a telemetry frame
+ * @details    Layout: sync byte, sequence number, SNES state (2), DB9 state, status, missed ticks (2),
+ *             max backlog, max iteration (2), CRC over all bytes but the sync byte. Words are little endian.
+ * @param[in]  data to serialize
+ * @param[in]  sequence number of the frame
+ * @param[out] frame of SNESTELEMETRY_FRAME_SIZE bytes
+ */
+void     SNESTelemetry_Encode ( const SNESTelemetryData * data, uint8_t sequence, uint8_t * frame );
+
+/**
+ * @brief          queues a telemetry frame for transmission
+ * @details        Must not be interrupted by SNESTelemetry_Update(), call with interrupts disabled when
+ *                 the transmission runs in interrupt context.
+ * @param[in, out] self points to instance of SNESTelemetry
+ * @param[in]      data to send
+ * @returns        true if the frame was queued, false if the previous frame is still being sent
+ */
+bool     SNESTelemetry_Send ( SNESTelemetry * self, const SNESTelemetryData * data );
+
+/**
+ * @brief     checks if a frame is being sent
+ * @param[in] self points to instance of SNESTelemetry
+ * @returns   true if a transmission is in progress
+ */
+bool     SNESTelemetry_IsBusy ( const SNESTelemetry * self );
+
+/**
+ * @brief          advances the transmission by one bit time
+ * @param[in, out] self points to instance of SNESTelemetry
+ * @returns        level to drive on the TX line until the next call, SNES2DB9_PIN_HIGH while idle
+ */
+SNES2DB9_Pinstate SNESTelemetry_Update ( SNESTelemetry * self );
 
 #ifdef __cplusplus
 }
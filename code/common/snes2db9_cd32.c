@@ -0,0 +1,101 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_cd32.c
+ * @brief   implements CD32Pad object
+ * @details The Amiga drives the mode line low and clocks the buttons out serially.
+ *          All mapping work is done once per SNES reading, the clock edges only shift.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+/**
+ * @brief internal mapping of SNES buttons to CD32 serial image bits
+ */
+typedef struct
+{
+	uint16_t snes_mask;  /**< SNES_BTNMASK_xxx to test */
+	uint16_t cd32_mask;  /**< CD32_BTNMASK_xxx to set */
+} CD32Mapping;
+
+/**
+ * @brief fixed SNES to CD32 button assignment
+ */
+static const CD32Mapping Mapping[] =
+{
+	{ SNES_BTNMASK_A,     CD32_BTNMASK_Blue    },
+	{ SNES_BTNMASK_B,     CD32_BTNMASK_Red     },
+	{ SNES_BTNMASK_X,     CD32_BTNMASK_Yellow  },
+	{ SNES_BTNMASK_Y,     CD32_BTNMASK_Green   },
+	{ SNES_BTNMASK_R,     CD32_BTNMASK_Forward },
+	{ SNES_BTNMASK_L,     CD32_BTNMASK_Reverse },
+	{ SNES_BTNMASK_Start, CD32_BTNMASK_Play    },
+};
+
+/**
+ * @brief     internal helper function to decode the current shift register output bit
+ * @details   A set bit pulls the open collector data line low.
+ * @param[in] shiftreg to decode
+ * @returns   pin state to present on the serial data line
+ */
+static SNES2DB9_Pinstate DataLevel ( uint16_t shiftreg )
+{
+	SNES2DB9_Pinstate level = SNES2DB9_PIN_HIGHZ;
+
+	if ( ( shiftreg & 1 ) != 0 )
+	{
+		level = SNES2DB9_PIN_LOW;
+	}
+
+	return level;
+}
+
+void CD32Pad_Init ( CD32Pad * self )
+{
+	assert ( self != NULL );
+	self->image = CD32_IMAGE_TRAILER;
+	self->shiftreg = CD32_IMAGE_TRAILER;
+}
+
+void CD32Pad_Update ( CD32Pad * self, uint16_t snes_pin_mask )
+{
+	uint8_t  idx;
+	uint16_t image = CD32_IMAGE_TRAILER;
+	assert ( self != NULL );
+
+	for ( idx = 0; idx < ( sizeof ( Mapping ) / sizeof ( Mapping[0] ) ); idx++ )
+	{
+		if ( ( snes_pin_mask & Mapping[idx].snes_mask ) != 0 )
+		{
+			image |= Mapping[idx].cd32_mask;
+		}
+	}
+
+	/* only the low byte varies, a torn read by CD32Pad_Load() in interrupt context is harmless: */
+	self->image = image;
+}
+
+SNES2DB9_Pinstate CD32Pad_Load ( CD32Pad * self )
+{
+	assert ( self != NULL );
+	self->shiftreg = self->image;
+	return DataLevel ( self->shiftreg );
+}
+
+SNES2DB9_Pinstate CD32Pad_Clock ( CD32Pad * self )
+{
+	assert ( self != NULL );
+	/* the pad's serial input is tied to ground, shift in pressed levels: */
+	self->shiftreg = ( self->shiftreg >> 1 ) | 0x8000;
+	return DataLevel ( self->shiftreg );
+}
@@ -0,0 +1,96 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_chord.c
+ * @brief   implements SNESChord object
+ * @details The chord detector recognizes on-device commands and withholds the buttons used to enter them.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+#define BUTTON_MASK 0xFFF0u  /**< SNES buttons, the lower bits are the protocol trailer */
+#define NO_COMBO    0xFFFFu  /**< combo while the lead buttons are released, cannot be held as it includes the lead buttons */
+
+void     SNESChord_Init ( SNESChord * self, uint16_t lead_mask, const SNESChordDef * chords, uint8_t nr_chords )
+{
+	assert ( self != NULL );
+	assert ( ( chords != NULL ) || ( nr_chords == 0 ) );
+	assert ( nr_chords <= SNESCHORD_MAX );
+	assert ( lead_mask != 0 );
+	self->chords = chords;
+	self->nr_chords = nr_chords;
+	self->lead_mask = lead_mask & BUTTON_MASK;
+	self->combo = NO_COMBO;
+	self->held_millis = 0;
+	self->suppressed = 0;
+	self->done = 0;
+	self->fired = 0;
+}
+
+uint16_t SNESChord_Update ( SNESChord * self, uint16_t snes_pin_mask, uint16_t millis_passed )
+{
+	uint16_t buttons;
+	uint16_t combo;
+	uint16_t headroom;
+	uint8_t  idx;
+	assert ( self != NULL );
+	buttons = snes_pin_mask & BUTTON_MASK;
+	self->fired = 0;
+	/* released buttons are passed again: */
+	self->suppressed &= buttons;
+
+	if ( ( buttons & self->lead_mask ) == self->lead_mask )
+	{
+		self->suppressed |= buttons;
+		combo = buttons & ( uint16_t ) ~self->lead_mask;
+
+		if ( combo != self->combo )
+		{
+			self->combo = combo;
+			self->held_millis = 0;
+			self->done = 0;
+		}
+		else
+		{
+			headroom = ( uint16_t ) ( UINT16_MAX - millis_passed );
+			self->held_millis = ( self->held_millis > headroom ) ? UINT16_MAX : ( uint16_t ) ( self->held_millis + millis_passed );
+		}
+
+		for ( idx = 0; idx < self->nr_chords; idx++ )
+		{
+			if ( ( self->chords[idx].button_mask == combo ) &&
+			        ( self->chords[idx].hold_millis <= self->held_millis ) &&
+			        ( ( self->done & ( 1u << idx ) ) == 0 )
+			   )
+			{
+				self->done |= ( uint8_t ) ( 1u << idx );
+				self->fired |= ( uint8_t ) ( 1u << idx );
+			}
+		}
+	}
+	else
+	{
+		/* a new command needs the lead buttons pressed again: */
+		self->combo = NO_COMBO;
+		self->held_millis = 0;
+		self->done = 0;
+	}
+
+	return snes_pin_mask & ( uint16_t ) ~self->suppressed;
+}
+
+uint8_t  SNESChord_GetFired ( const SNESChord * self )
+{
+	assert ( self != NULL );
+	return self->fired;
+}
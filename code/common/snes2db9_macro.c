@@ -0,0 +1,353 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_macro.c
+ * @brief   implements SNESMacro object
+ * @details The macro records SNES button toggles with their frame distance and plays them back.
+ *          A frame is one call of SNESMacro_Update(), timing is exact to the frame.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+#define EVENT_MAX_DELAY    14u     /**< largest frame delay of a toggle event */
+#define EVENT_LONG_WAIT    0xF0u   /**< high nibble marking a long wait */
+#define LONG_WAIT_UNIT     15u     /**< frames per unit of a long wait */
+#define LONG_WAIT_MAX      ( 16u * LONG_WAIT_UNIT )  /**< longest wait of a single event */
+#define BUTTON_MASK        0xFFF0u /**< SNES buttons, the lower bits are the protocol trailer */
+#define COUNT_INVALID      0xFFu   /**< count byte of an incomplete save, rejected by SNESMacro_Load() */
+
+#if SNESMACRO_BUFFER_SIZE >= COUNT_INVALID
+#error "SNESMACRO_BUFFER_SIZE must be below the invalid count marker"
+#endif
+
+/**
+ * @brief          appends an event, folds the oldest event into the start state if the buffer is full
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      event to append
+ */
+static void PushEvent ( SNESMacro * self, uint8_t event )
+{
+	if ( self->count == SNESMACRO_BUFFER_SIZE )
+	{
+		uint8_t oldest = self->events[self->head];
+
+		if ( ( ( oldest & EVENT_LONG_WAIT ) != EVENT_LONG_WAIT ) && ( ( oldest & 0x0Fu ) != 0 ) )
+		{
+			self->start_state ^= ( uint16_t ) ( 1u << ( oldest & 0x0Fu ) );
+		}
+
+		self->head = ( uint8_t ) ( ( self->head + 1u ) % SNESMACRO_BUFFER_SIZE );
+		self->count--;
+	}
+
+	self->events[ ( self->head + self->count ) % SNESMACRO_BUFFER_SIZE] = event;
+	self->count++;
+}
+
+/**
+ * @brief          emits long waits until the remaining frame distance fits a toggle event
+ * @param[in, out] self points to instance of SNESMacro
+ */
+static void FlushLongWaits ( SNESMacro * self )
+{
+	while ( self->frames > EVENT_MAX_DELAY )
+	{
+		uint8_t units = ( uint8_t ) ( self->frames / LONG_WAIT_UNIT );
+		units = ( units > 16u ) ? 16u : units;
+		PushEvent ( self, ( uint8_t ) ( EVENT_LONG_WAIT | ( units - 1u ) ) );
+		self->frames = ( uint8_t ) ( self->frames - ( units * LONG_WAIT_UNIT ) );
+	}
+}
+
+/**
+ * @brief          records the changes of one frame
+ * @param[in, out] self points to instance of SNESMacro
+ * @param[in]      snes_pin_mask is the live input
+ */
+static void Record ( SNESMacro * self, uint16_t snes_pin_mask )
+{
+	uint16_t changed = ( uint16_t ) ( ( snes_pin_mask ^ self->state ) & BUTTON_MASK );
+	uint8_t  bit;
+
+	if ( changed != 0 )
+	{
+		FlushLongWaits ( self );
+
+		for ( bit = 4; bit < 16u; bit++ )
+		{
+			if ( ( changed & ( 1u << bit ) ) != 0 )
+			{
+				/* first toggle carries the delay, all further toggles happen in the same frame: */
+				PushEvent ( self, ( uint8_t ) ( ( self->frames << 4 ) | bit ) );
+				self->frames = 0;
+			}
+		}
+
+		self->state ^= changed;
+	}
+
+	self->frames++;
+
+	if ( self->frames == LONG_WAIT_MAX )
+	{
+		FlushLongWaits ( self );
+	}
+}
+
+/**
+ * @brief          plays back the events of one frame
+ * @param[in, out] self points to instance of SNESMacro
+ * @return         true if the frame was played, false if the macro has ended
+ */
+static bool Play ( SNESMacro * self )
+{
+	bool restarted = false;
+
+	for ( ;; )
+	{
+		while ( self->cursor < self->count )
+		{
+			uint8_t event = self->events[ ( self->head + self->cursor ) % SNESMACRO_BUFFER_SIZE];
+
+			if ( self->loaded == false )
+			{
+				self->wait = ( ( event & EVENT_LONG_WAIT ) == EVENT_LONG_WAIT ) ?
+				             ( uint8_t ) ( ( ( event & 0x0Fu ) + 1u ) * LONG_WAIT_UNIT ) : ( uint8_t ) ( event >> 4 );
+				self->loaded = true;
+			}
+
+			if ( self->wait > 0 )
+			{
+				/* this frame is consumed by the wait: */
+				self->wait--;
+				return true;
+			}
+
+			if ( ( ( event & EVENT_LONG_WAIT ) != EVENT_LONG_WAIT ) && ( ( event & 0x0Fu ) != 0 ) )
+			{
+				self->state ^= ( uint16_t ) ( 1u << ( event & 0x0Fu ) );
+			}
+
+			self->cursor++;
+			self->loaded = false;
+		}
+
+		/* all events played, a macro without any wait is only restarted once per frame: */
+		if ( ( self->loop == false ) || restarted )
+		{
+			return self->loop;
+		}
+
+		self->cursor = 0;
+		self->state = self->start_state;
+		restarted = true;
+	}
+}
+
+/**
+ * @brief     writes one byte of the storage layout
+ * @details   Step 0 invalidates the count byte, steps 1 and 2 write the start state, the following steps
+ *            the events. The last step, count + 3, commits the save by writing the count byte.
+ * @param[in] self points to instance of SNESMacro
+ * @param[in] writefunc points to hardware abstraction function to write a byte
+ * @param[in] address of the first byte
+ * @param[in] step to write
+ */
+static void SaveByte ( const SNESMacro * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address, uint16_t step )
+{
+	if ( step == 0 )
+	{
+		writefunc ( address, COUNT_INVALID );
+	}
+	else if ( step == 1u )
+	{
+		writefunc ( address + 1u, ( uint8_t ) self->start_state );
+	}
+	else if ( step == 2u )
+	{
+		writefunc ( address + 2u, ( uint8_t ) ( self->start_state >> 8 ) );
+	}
+	else if ( step < ( self->count + 3u ) )
+	{
+		writefunc ( address + step, self->events[ ( self->head + step - 3u ) % SNESMACRO_BUFFER_SIZE] );
+	}
+	else
+	{
+		writefunc ( address, self->count );
+	}
+}
+
+void SNESMacro_Init ( SNESMacro * self )
+{
+	assert ( self != NULL );
+	memset ( self, 0, sizeof ( *self ) );
+	self->mode = SNESMACRO_IDLE;
+}
+
+void SNESMacro_StartRecording ( SNESMacro * self, uint16_t snes_pin_mask )
+{
+	assert ( self != NULL );
+
+	if ( self->mode == SNESMACRO_SAVING )
+	{
+		return;
+	}
+
+	self->head = 0;
+	self->count = 0;
+	self->frames = 0;
+	self->start_state = snes_pin_mask & BUTTON_MASK;
+	self->state = self->start_state;
+	self->mode = SNESMACRO_RECORDING;
+}
+
+bool SNESMacro_StartPlayback ( SNESMacro * self, bool loop )
+{
+	assert ( self != NULL );
+
+	if ( self->mode == SNESMACRO_RECORDING )
+	{
+		SNESMacro_Stop ( self );
+	}
+
+	if ( ( self->count == 0 ) || ( self->mode == SNESMACRO_SAVING ) )
+	{
+		return false;
+	}
+
+	self->cursor = 0;
+	self->loaded = false;
+	self->loop = loop;
+	self->state = self->start_state;
+	self->mode = SNESMACRO_PLAYBACK;
+	return true;
+}
+
+void SNESMacro_Stop ( SNESMacro * self )
+{
+	assert ( self != NULL );
+
+	if ( self->mode == SNESMACRO_SAVING )
+	{
+		return;
+	}
+
+	if ( ( self->mode == SNESMACRO_RECORDING ) && ( self->count > 0 ) )
+	{
+		/* keep the time since the last toggle as trailing wait: */
+		FlushLongWaits ( self );
+
+		if ( self->frames > 0 )
+		{
+			PushEvent ( self, ( uint8_t ) ( self->frames << 4 ) );
+		}
+	}
+
+	self->mode = SNESMACRO_IDLE;
+}
+
+uint16_t SNESMacro_Update ( SNESMacro * self, uint16_t snes_pin_mask )
+{
+	assert ( self != NULL );
+
+	if ( self->mode == SNESMACRO_RECORDING )
+	{
+		Record ( self, snes_pin_mask );
+	}
+	else if ( self->mode == SNESMACRO_PLAYBACK )
+	{
+		if ( Play ( self ) )
+		{
+			return self->state;
+		}
+
+		/* playback finished, hand back to the live input: */
+		self->mode = SNESMACRO_IDLE;
+	}
+
+	return snes_pin_mask;
+}
+
+SNESMacroMode SNESMacro_GetMode ( const SNESMacro * self )
+{
+	assert ( self != NULL );
+	return ( SNESMacroMode ) self->mode;
+}
+
+void SNESMacro_Save ( const SNESMacro * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address )
+{
+	uint16_t step;
+	assert ( self != NULL );
+	assert ( writefunc != NULL );
+
+	for ( step = 0; step <= ( self->count + 3u ); step++ )
+	{
+		SaveByte ( self, writefunc, address, step );
+	}
+}
+
+void SNESMacro_StartSave ( SNESMacro * self )
+{
+	assert ( self != NULL );
+	SNESMacro_Stop ( self );
+	self->save_step = 0;
+	self->mode = SNESMACRO_SAVING;
+}
+
+bool SNESMacro_SaveStep ( SNESMacro * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address )
+{
+	assert ( self != NULL );
+	assert ( writefunc != NULL );
+
+	if ( self->mode != SNESMACRO_SAVING )
+	{
+		return false;
+	}
+
+	SaveByte ( self, writefunc, address, self->save_step );
+
+	if ( self->save_step == ( self->count + 3u ) )
+	{
+		self->mode = SNESMACRO_IDLE;
+		return false;
+	}
+
+	self->save_step++;
+	return true;
+}
+
+bool SNESMacro_Load ( SNESMacro * self, SNES2DB9_ReadByteFunc readfunc, uint16_t address )
+{
+	uint8_t count;
+	uint8_t idx;
+	assert ( self != NULL );
+	assert ( readfunc != NULL );
+	SNESMacro_Init ( self );
+	count = readfunc ( address );
+
+	if ( count > SNESMACRO_BUFFER_SIZE )
+	{
+		return false;
+	}
+
+	self->start_state = ( uint16_t ) ( readfunc ( address + 1u ) | ( readfunc ( address + 2u ) << 8 ) ) & BUTTON_MASK;
+	self->state = self->start_state;
+
+	for ( idx = 0; idx < count; idx++ )
+	{
+		self->events[idx] = readfunc ( address + 3u + idx );
+	}
+
+	self->count = count;
+	return ( count > 0 );
+}
@@ -21,25 +21,50 @@
 /**
  * @brief          internal helper function to computer autofire state based on callcycle
  * @details        Pin states are not affected. Internal state autofire_active is calculated.
+ *                 The state toggles once per complete cycle time, an update spanning several cycles toggles several times,
+ *                 so the phase always equals ( accumulated ms / cycle time ) & 1.
  * @param[in, out] self points to instance of SNESMapper
  * @param[in]      millis_passed is the number of ms passed since last call to SNESMapper_Update
  */
 static void ComputeAutofireState ( SNESMapper * self, uint16_t millis_passed )
 {
+	uint16_t cycletime;
+	uint16_t to_toggle;
+	uint16_t toggles;
 	assert ( self != NULL );
-	self->millis += millis_passed;
+	cycletime = self->autofire_cycletime_millis;
 
-    if ( self->autofire_cycletime_millis == 0 )
+	if ( cycletime == 0 )
 	{
+		self->millis = 0;
 		self->autofire_active = false;
+		return;
 	}
-	else
+
+	/* millis stays below the cycle time, unless the cycle time has just been shortened: */
+	to_toggle = ( self->millis < cycletime ) ? ( uint16_t ) ( cycletime - self->millis ) : 0u;
+
+	if ( millis_passed < to_toggle )
+	{
+		self->millis = ( uint16_t ) ( self->millis + millis_passed );
+		return;
+	}
+
+	millis_passed = ( uint16_t ) ( millis_passed - to_toggle );
+	toggles = 1u;
+
+	/* division only for updates spanning more than one cycle: */
+	if ( millis_passed >= cycletime )
+	{
+		toggles = ( uint16_t ) ( toggles + ( millis_passed / cycletime ) );
+		millis_passed = ( uint16_t ) ( millis_passed % cycletime );
+	}
+
+	self->millis = millis_passed;
+
+	if ( ( toggles & 1u ) != 0 )
 	{
-		if ( self->millis >= self->autofire_cycletime_millis )
-		{
-			self->millis -= self->autofire_cycletime_millis;
-            self->autofire_active = !self->autofire_active;
-		}
+		self->autofire_active = !self->autofire_active;
 	}
 }
 
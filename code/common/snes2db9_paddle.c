@@ -0,0 +1,80 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_paddle.c
+ * @brief   implements SNESPaddle object
+ * @details The paddle position is integrated from the SNES directional pad with the callrate.
+ *          Timing of the pot line is left to the implementation.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+void SNESPaddle_Init ( SNESPaddle * self )
+{
+	assert ( self != NULL );
+	self->position = ( PADDLE_POSITION_MAX / 2 ) & 0xFF00u;
+	self->speed = PADDLE_SPEED_MIN;
+}
+
+uint8_t SNESPaddle_Update ( SNESPaddle * self, uint16_t snes_pin_mask, uint16_t millis_passed )
+{
+	uint32_t step;
+	bool     left = ( ( snes_pin_mask & SNES_BTNMASK_Left ) != 0 );
+	bool     right = ( ( snes_pin_mask & SNES_BTNMASK_Right ) != 0 );
+	assert ( self != NULL );
+
+	if ( left == right )
+	{
+		/* released or contradicting directions, stop the paddle: */
+		self->speed = PADDLE_SPEED_MIN;
+	}
+	else
+	{
+		step = ( uint32_t ) self->speed * millis_passed;
+
+		if ( ( snes_pin_mask & SNES_BTNMASK_R ) != 0 )
+		{
+			step <<= 2;
+		}
+
+		if ( ( snes_pin_mask & SNES_BTNMASK_L ) != 0 )
+		{
+			step >>= 2;
+		}
+
+		if ( right == true )
+		{
+			step += self->position;
+			self->position = ( step > PADDLE_POSITION_MAX ) ? PADDLE_POSITION_MAX : ( uint16_t ) step;
+		}
+		else
+		{
+			self->position = ( step > self->position ) ? 0 : ( uint16_t ) ( self->position - step );
+		}
+
+		/* accelerate while the direction is held: */
+		step = self->speed + ( ( uint32_t ) PADDLE_ACCELERATION * millis_passed );
+		self->speed = ( step > PADDLE_SPEED_MAX ) ? PADDLE_SPEED_MAX : ( uint16_t ) step;
+	}
+
+	return ( uint8_t ) ( self->position >> 8 );
+}
+
+uint16_t SNESPaddle_GetDelay ( const SNESPaddle * self, uint16_t min_delay, uint16_t max_delay )
+{
+	uint32_t range;
+	assert ( self != NULL );
+	assert ( max_delay >= min_delay );
+	range = ( uint32_t ) ( max_delay - min_delay ) * ( uint8_t ) ( self->position >> 8 );
+	return ( uint16_t ) ( max_delay - ( range / 255u ) );
+}
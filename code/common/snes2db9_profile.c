@@ -0,0 +1,224 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_profile.c
+ * @brief   implements SNESProfiles object
+ * @details Profiles are kept in non-volatile storage, the selection is written to a wear levelling journal.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+#define JOURNAL_SEQ_MODULO 255u   /**< sequence numbers wrap before 0xFF which marks an erased entry */
+#define JOURNAL_ERASED     0xFFu  /**< erased entry */
+#define JOURNAL_IDLE       0u     /**< journal_pending: no entry to write */
+#define JOURNAL_SEQ        1u     /**< journal_pending: sequence number of the entry to write */
+#define JOURNAL_INDEX      2u     /**< journal_pending: profile index and sequence number of the entry to write */
+
+/**
+ * @brief     computes the address of a journal entry
+ * @param[in] self points to instance of SNESProfiles
+ * @param[in] slot of the journal entry
+ * @returns   address of the sequence number, the profile index follows
+ */
+static uint16_t JournalAddress ( const SNESProfiles * self, uint8_t slot )
+{
+	return ( uint16_t ) ( self->address + ( SNESPROFILE_COUNT * SNESPROFILE_RECORD_SIZE ) + ( 2u * slot ) );
+}
+
+/**
+ * @brief          finds the newest journal entry and restores the selection
+ * @param[in, out] self points to instance of SNESProfiles
+ */
+static void ScanJournal ( SNESProfiles * self )
+{
+	uint8_t slot;
+
+	self->selected = 0;
+	self->journal_slot = SNESPROFILE_JOURNAL_SLOTS - 1u;
+	self->journal_seq = JOURNAL_SEQ_MODULO - 1u;
+	self->journal_valid = false;
+	self->journal_pending = JOURNAL_IDLE;
+
+	for ( slot = 0; slot < SNESPROFILE_JOURNAL_SLOTS; slot++ )
+	{
+		uint8_t seq = self->readfunc ( JournalAddress ( self, slot ) );
+		uint8_t next_seq = self->readfunc ( JournalAddress ( self, ( uint8_t ) ( ( slot + 1u ) % SNESPROFILE_JOURNAL_SLOTS ) ) );
+
+		/* the newest entry is not followed by its successor: */
+		if ( ( seq != JOURNAL_ERASED ) && ( next_seq != ( ( seq + 1u ) % JOURNAL_SEQ_MODULO ) ) )
+		{
+			uint8_t index = self->readfunc ( JournalAddress ( self, slot ) + 1u );
+			self->journal_slot = slot;
+			self->journal_seq = seq;
+			self->journal_valid = true;
+			self->selected = ( index < SNESPROFILE_COUNT ) ? index : 0;
+			break;
+		}
+	}
+}
+
+/**
+ * @brief          queues the selection for the journal, see SNESProfiles_WriteStep()
+ * @details        An entry still pending is reused, its profile index is written again.
+ * @param[in, out] self points to instance of SNESProfiles
+ */
+static void QueueJournal ( SNESProfiles * self )
+{
+	if ( self->journal_pending == JOURNAL_IDLE )
+	{
+		self->journal_slot = ( uint8_t ) ( ( self->journal_slot + 1u ) % SNESPROFILE_JOURNAL_SLOTS );
+		self->journal_seq = ( uint8_t ) ( ( self->journal_seq + 1u ) % JOURNAL_SEQ_MODULO );
+	}
+
+	self->journal_pending = JOURNAL_INDEX;
+	self->journal_valid = true;
+}
+
+void     SNESProfiles_Init ( SNESProfiles * self, SNES2DB9_WriteByteFunc writefunc, SNES2DB9_ReadByteFunc readfunc,
+                             uint16_t address, const SNESProfile * defaults )
+{
+	uint8_t     index;
+	SNESProfile profile;
+	assert ( self != NULL );
+	assert ( writefunc != NULL );
+	assert ( readfunc != NULL );
+	assert ( defaults != NULL );
+	self->writefunc = writefunc;
+	self->readfunc = readfunc;
+	self->address = address;
+
+	for ( index = 0; index < SNESPROFILE_COUNT; index++ )
+	{
+		if ( SNESProfiles_Load ( self, index, &profile ) == false )
+		{
+			SNESProfiles_Store ( self, index, &defaults[index] );
+		}
+	}
+
+	ScanJournal ( self );
+}
+
+bool     SNESProfiles_Load ( const SNESProfiles * self, uint8_t index, SNESProfile * profile )
+{
+	uint8_t  data[SNESPROFILE_RECORD_SIZE];
+	uint8_t  sum = 0;
+	uint8_t  idx;
+	uint16_t address;
+	assert ( self != NULL );
+	assert ( profile != NULL );
+
+	if ( index >= SNESPROFILE_COUNT )
+	{
+		return false;
+	}
+
+	address = ( uint16_t ) ( self->address + ( index * SNESPROFILE_RECORD_SIZE ) );
+
+	for ( idx = 0; idx < SNESPROFILE_RECORD_SIZE; idx++ )
+	{
+		data[idx] = self->readfunc ( address + idx );
+		sum = ( uint8_t ) ( sum + data[idx] );
+	}
+
+	/* the checksum byte complements the sum of the record to 0xFF, erased and cleared records fail: */
+	if ( sum != 0xFFu )
+	{
+		return false;
+	}
+
+	profile->button_masks.fire_mask = ( uint16_t ) ( data[0] | ( data[1] << 8 ) );
+	profile->button_masks.autofire_mask = ( uint16_t ) ( data[2] | ( data[3] << 8 ) );
+	profile->button_masks.jump_mask = ( uint16_t ) ( data[4] | ( data[5] << 8 ) );
+	profile->autofire_cycletime_millis = ( uint16_t ) ( data[6] | ( data[7] << 8 ) );
+	return true;
+}
+
+void     SNESProfiles_Store ( SNESProfiles * self, uint8_t index, const SNESProfile * profile )
+{
+	uint8_t  data[SNESPROFILE_RECORD_SIZE];
+	uint8_t  sum = 0;
+	uint8_t  idx;
+	uint16_t address;
+	assert ( self != NULL );
+	assert ( profile != NULL );
+	assert ( index < SNESPROFILE_COUNT );
+	data[0] = ( uint8_t ) profile->button_masks.fire_mask;
+	data[1] = ( uint8_t ) ( profile->button_masks.fire_mask >> 8 );
+	data[2] = ( uint8_t ) profile->button_masks.autofire_mask;
+	data[3] = ( uint8_t ) ( profile->button_masks.autofire_mask >> 8 );
+	data[4] = ( uint8_t ) profile->button_masks.jump_mask;
+	data[5] = ( uint8_t ) ( profile->button_masks.jump_mask >> 8 );
+	data[6] = ( uint8_t ) profile->autofire_cycletime_millis;
+	data[7] = ( uint8_t ) ( profile->autofire_cycletime_millis >> 8 );
+
+	for ( idx = 0; idx < ( SNESPROFILE_RECORD_SIZE - 1u ); idx++ )
+	{
+		sum = ( uint8_t ) ( sum + data[idx] );
+	}
+
+	data[SNESPROFILE_RECORD_SIZE - 1u] = ( uint8_t ) ( 0xFFu - sum );
+	address = ( uint16_t ) ( self->address + ( index * SNESPROFILE_RECORD_SIZE ) );
+
+	for ( idx = 0; idx < SNESPROFILE_RECORD_SIZE; idx++ )
+	{
+		self->writefunc ( address + idx, data[idx] );
+	}
+}
+
+bool     SNESProfiles_Select ( SNESProfiles * self, uint8_t index, SNESMapper * mapper )
+{
+	SNESProfile profile;
+	assert ( self != NULL );
+	assert ( mapper != NULL );
+
+	if ( SNESProfiles_Load ( self, index, &profile ) == false )
+	{
+		return false;
+	}
+
+	SNESMapper_Init ( mapper, &profile.button_masks );
+	SNESMapper_SetAutofireDuration ( mapper, profile.autofire_cycletime_millis );
+
+	if ( ( index != self->selected ) || ( self->journal_valid == false ) )
+	{
+		self->selected = index;
+		QueueJournal ( self );
+	}
+
+	return true;
+}
+
+bool     SNESProfiles_WriteStep ( SNESProfiles * self )
+{
+	assert ( self != NULL );
+
+	/* the profile index is written first, the sequence number commits the entry: */
+	if ( self->journal_pending == JOURNAL_INDEX )
+	{
+		self->writefunc ( JournalAddress ( self, self->journal_slot ) + 1u, self->selected );
+		self->journal_pending = JOURNAL_SEQ;
+	}
+	else if ( self->journal_pending == JOURNAL_SEQ )
+	{
+		self->writefunc ( JournalAddress ( self, self->journal_slot ), self->journal_seq );
+		self->journal_pending = JOURNAL_IDLE;
+	}
+
+	return ( self->journal_pending != JOURNAL_IDLE );
+}
+
+uint8_t  SNESProfiles_GetSelected ( const SNESProfiles * self )
+{
+	assert ( self != NULL );
+	return self->selected;
+}
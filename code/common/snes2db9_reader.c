@@ -8,9 +8,10 @@
  *
  * @file    snes2db9_reader.c
  * @brief   implements SNESReader object
- * @details The cycle time of the controller polling is derived from the callrate.
+ * @details The cycle time of the controller polling is derived from the callrate, or from a busy
+ *          wait between the steps of an update if a half period is selected.
  *
- * @note    Cycles of 16µs or slower should be sufficient
+ * @note    Cycles of 16µs or slower should be sufficient, some clone pads need slower cycles
  *
  */
 
@@ -73,9 +74,13 @@ void SNESReader_Init ( SNESReader * self, SNES2DB9_SetPinFunc setfunc, SNES2DB9_
 	assert ( readfunc != NULL );
 	self->setpin = setfunc;
 	self->getpin = readfunc;
+	self->delay = NULL;
 	self->shiftreg = 0;
 	self->result = 0;
 	self->state = READER_ST_IDLE;
+	self->half_period = 0;
+	self->wait_limit = SNESREADER_WAIT_UNLIMITED;
+	self->steps = 1;
 	/* set pins to default levels: */
 	self->setpin ( SNES_CLK, SNES2DB9_PIN_HIGH );
 	self->setpin ( SNES_LATCH, SNES2DB9_PIN_LOW );
@@ -87,12 +92,18 @@ void SNESReader_BeginRead ( SNESReader * self )
 	self->state = READER_ST_LATCH;
 }
 
-uint16_t SNESReader_Update ( SNESReader * self )
+bool SNESReader_IsIdle ( const SNESReader * self )
 {
 	assert ( self != NULL );
-	assert ( self->setpin != NULL );
-	assert ( self->getpin != NULL );
+	return ( self->state >= READER_ST_IDLE );
+}
 
+/**
+ * @brief          performs one step of the reading
+ * @param[in, out] self points to instance of SNESReader
+ */
+static void Step ( SNESReader * self )
+{
 	/* handle latch and clock command, shift register
 	 * pins are physically updated first in the same order for each
 	 * case to ensure equal runtime.
@@ -146,6 +157,163 @@ uint16_t SNESReader_Update ( SNESReader * self )
 	{
 		self->state++;
 	}
+}
+
+/**
+ * @brief          performs steps of the reading, each but the last is held for a half period
+ * @param[in, out] self points to instance of SNESReader
+ * @param[in]      steps to perform at most
+ */
+static void StepBurst ( SNESReader * self, uint8_t steps )
+{
+	Step ( self );
+	steps--;
+
+	while ( ( steps > 0 ) && ( self->state < READER_ST_IDLE ) )
+	{
+		self->delay ( self->half_period );
+		Step ( self );
+		steps--;
+	}
+}
+
+/**
+ * @brief          derives the steps per update from half period and busy wait limit
+ * @param[in, out] self points to instance of SNESReader
+ */
+static void UpdateSteps ( SNESReader * self )
+{
+	uint16_t steps = 1;
+
+	if ( self->half_period != 0 )
+	{
+		steps += self->wait_limit / self->half_period;
+	}
+
+	self->steps = ( steps > READER_ST_IDLE ) ? READER_ST_IDLE : ( uint8_t ) steps;
+}
 
+uint16_t SNESReader_Update ( SNESReader * self )
+{
+	assert ( self != NULL );
+	assert ( self->setpin != NULL );
+	assert ( self->getpin != NULL );
+	StepBurst ( self, self->steps );
 	return self->result;
 }
+
+void SNESReader_SetDelayFunc ( SNESReader * self, SNES2DB9_DelayFunc delayfunc )
+{
+	assert ( self != NULL );
+	assert ( delayfunc != NULL );
+	self->delay = delayfunc;
+}
+
+void SNESReader_SetHalfPeriod ( SNESReader * self, uint8_t half_period_us )
+{
+	assert ( self != NULL );
+	assert ( ( half_period_us == 0 ) || ( self->delay != NULL ) );
+	self->half_period = half_period_us;
+	UpdateSteps ( self );
+}
+
+void SNESReader_SetWaitLimit ( SNESReader * self, uint16_t wait_us )
+{
+	assert ( self != NULL );
+	self->wait_limit = wait_us;
+	UpdateSteps ( self );
+}
+
+uint8_t SNESReader_GetHalfPeriod ( const SNESReader * self )
+{
+	assert ( self != NULL );
+	return self->half_period;
+}
+
+bool SNESReader_IsValid ( uint16_t reading )
+{
+	return ( ( reading & SNES_TRAILER_MASK ) == 0 );
+}
+
+uint8_t SNESReader_Calibrate ( SNESReader * self, uint16_t expected, const uint8_t * half_periods_us, uint8_t count, uint8_t reads )
+{
+	uint16_t result;
+	uint8_t  selected = 0;
+	uint8_t  idx;
+	uint8_t  read;
+	bool     passed;
+	assert ( self != NULL );
+	assert ( self->delay != NULL );
+	assert ( half_periods_us != NULL );
+	assert ( SNESReader_IsIdle ( self ) == true );
+	/* failed readings must not show up as result: */
+	result = self->result;
+	passed = SNESReader_IsValid ( expected );
+
+	for ( idx = 0; ( idx < count ) && ( passed == true ); idx++ )
+	{
+		assert ( half_periods_us[idx] != 0 );
+		self->half_period = half_periods_us[idx];
+
+		for ( read = 0; ( read < reads ) && ( passed == true ); read++ )
+		{
+			/* complete reading regardless of the busy wait limit: */
+			SNESReader_BeginRead ( self );
+			StepBurst ( self, READER_ST_IDLE );
+			passed = ( self->result == expected );
+		}
+
+		if ( passed == true )
+		{
+			selected = half_periods_us[idx];
+		}
+	}
+
+	self->half_period = selected;
+	UpdateSteps ( self );
+	self->result = result;
+	return selected;
+}
+
+void SNESReader_SaveHalfPeriod ( const SNESReader * self, SNES2DB9_WriteByteFunc writefunc, uint16_t address )
+{
+	assert ( self != NULL );
+	assert ( writefunc != NULL );
+	writefunc ( address, self->half_period );
+	writefunc ( address + 1u, ( uint8_t ) ~self->half_period );
+}
+
+bool SNESReader_LoadHalfPeriod ( SNESReader * self, SNES2DB9_ReadByteFunc readfunc, uint16_t address, const uint8_t * half_periods_us, uint8_t count )
+{
+	uint8_t half_period;
+	uint8_t complement;
+	uint8_t idx;
+	bool    known;
+	assert ( self != NULL );
+	assert ( readfunc != NULL );
+	assert ( half_periods_us != NULL );
+	half_period = readfunc ( address );
+	complement = ( uint8_t ) ~half_period;
+
+	/* the complement detects erased or corrupted storage: */
+	if ( readfunc ( address + 1u ) != complement )
+	{
+		return false;
+	}
+
+	/* a failed calibration stores 0, anything else must have been probed: */
+	known = ( half_period == 0 );
+
+	for ( idx = 0; ( idx < count ) && ( known == false ); idx++ )
+	{
+		known = ( half_period == half_periods_us[idx] );
+	}
+
+	if ( known == false )
+	{
+		return false;
+	}
+
+	SNESReader_SetHalfPeriod ( self, half_period );
+	return true;
+}
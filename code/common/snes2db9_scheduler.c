@@ -0,0 +1,174 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_scheduler.c
+ * @brief   implements SNESScheduler object
+ * @details The scheduler releases periodic tasks from a tick counter and dispatches them by table priority.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+/**
+ * @brief     reads the tick counter consistently
+ * @details   The 16 bit counter is read in two bytes on 8 bit targets. The tick interrupt only increments it,
+ *            so two equal reads cannot be torn.
+ * @param[in] self points to instance of SNESScheduler
+ * @returns   tick counter
+ */
+static uint16_t ReadTicks ( const SNESScheduler * self )
+{
+	uint16_t ticks;
+
+	do
+	{
+		ticks = self->ticks;
+	}
+	while ( ticks != self->ticks );
+
+	return ticks;
+}
+
+void     SNESScheduler_Init ( SNESScheduler * self, SNESTask * tasks, uint8_t nr_tasks )
+{
+	uint8_t idx;
+	assert ( self != NULL );
+	assert ( ( tasks != NULL ) || ( nr_tasks == 0 ) );
+	self->tasks = tasks;
+	self->nr_tasks = nr_tasks;
+	self->ticks = 0;
+	self->ticks_seen = 0;
+	SNESScheduler_ResetStats ( self );
+
+	for ( idx = 0; idx < nr_tasks; idx++ )
+	{
+		assert ( tasks[idx].func != NULL );
+		assert ( tasks[idx].period_ticks != 0 );
+		tasks[idx].countdown = ( tasks[idx].offset_ticks != 0 ) ? tasks[idx].offset_ticks : tasks[idx].period_ticks;
+		tasks[idx].pending = 0;
+		tasks[idx].overruns = 0;
+	}
+}
+
+bool     SNESScheduler_Dispatch ( SNESScheduler * self )
+{
+	uint16_t   elapsed;
+	uint8_t    idx;
+	SNESTask * task;
+	assert ( self != NULL );
+	elapsed = ( uint16_t ) ( ReadTicks ( self ) - self->ticks_seen );
+	self->ticks_seen = ( uint16_t ) ( self->ticks_seen + elapsed );
+
+	if ( elapsed > self->stats.max_backlog )
+	{
+		self->stats.max_backlog = ( elapsed < UINT8_MAX ) ? ( uint8_t ) elapsed : UINT8_MAX;
+	}
+
+	if ( elapsed > 1u )
+	{
+		/* the main loop was busy while further ticks arrived: */
+		self->stats.missed_ticks = ( self->stats.missed_ticks > ( uint16_t ) ( UINT16_MAX - ( elapsed - 1u ) ) ) ?
+		                           UINT16_MAX : ( uint16_t ) ( self->stats.missed_ticks + ( elapsed - 1u ) );
+	}
+
+	while ( elapsed > 0 )
+	{
+		for ( idx = 0, task = self->tasks; idx < self->nr_tasks; idx++, task++ )
+		{
+			if ( --task->countdown == 0 )
+			{
+				task->countdown = task->period_ticks;
+
+				if ( task->pending != 0 )
+				{
+					task->overruns += ( task->overruns < UINT8_MAX ) ? 1u : 0u;
+				}
+
+				task->pending += ( task->pending < UINT16_MAX ) ? 1u : 0u;
+			}
+		}
+
+		elapsed--;
+	}
+
+	for ( idx = 0, task = self->tasks; idx < self->nr_tasks; idx++, task++ )
+	{
+		if ( task->pending != 0 )
+		{
+			task->pending--;
+			task->func();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint8_t  SNESScheduler_GetOverruns ( const SNESScheduler * self, uint8_t index )
+{
+	assert ( self != NULL );
+	assert ( index < self->nr_tasks );
+	return self->tasks[index].overruns;
+}
+
+bool     SNESScheduler_IsIdle ( const SNESScheduler * self )
+{
+	uint8_t idx;
+	assert ( self != NULL );
+
+	if ( ReadTicks ( self ) != self->ticks_seen )
+	{
+		return false;
+	}
+
+	for ( idx = 0; idx < self->nr_tasks; idx++ )
+	{
+		if ( self->tasks[idx].pending != 0 )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint8_t  SNESScheduler_GetTicks ( const SNESScheduler * self )
+{
+	assert ( self != NULL );
+	/* the low byte is read in a single access: */
+	return ( uint8_t ) self->ticks;
+}
+
+void     SNESScheduler_ReportIteration ( SNESScheduler * self, uint16_t timer_counts )
+{
+	assert ( self != NULL );
+
+	if ( timer_counts > self->stats.max_iteration )
+	{
+		self->stats.max_iteration = timer_counts;
+	}
+}
+
+void     SNESScheduler_GetStats ( const SNESScheduler * self, SNESSchedulerStats * stats )
+{
+	assert ( self != NULL );
+	assert ( stats != NULL );
+	*stats = self->stats;
+}
+
+void     SNESScheduler_ResetStats ( SNESScheduler * self )
+{
+	assert ( self != NULL );
+	self->stats.missed_ticks = 0;
+	self->stats.max_backlog = 0;
+	self->stats.max_iteration = 0;
+}
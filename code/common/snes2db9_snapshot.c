@@ -0,0 +1,66 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_snapshot.c
+ * @brief   implements SNESSnapshot object
+ * @details The 16 bit SNES state cannot be read or written atomically on the 8 bit AVR.
+ *          The writer fills the buffer readers do not use, the sequence counter switches buffers.
+ *          A reader overlapping a publication sees a changed counter and copies again.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+void SNESSnapshot_Init ( SNESSnapshot * self )
+{
+	assert ( self != NULL );
+	self->buffer[0].snes_state = 0;
+	self->buffer[0].db9_state = 0;
+	self->buffer[1].snes_state = 0;
+	self->buffer[1].db9_state = 0;
+	self->sequence = 0;
+	SNES2DB9_BARRIER();
+}
+
+void SNESSnapshot_Publish ( SNESSnapshot * self, const SNESSnapshotData * data )
+{
+	SNESSnapshotSeq sequence;
+	assert ( self != NULL );
+	assert ( data != NULL );
+	/* only the writer changes the counter: */
+	sequence = self->sequence;
+	self->buffer[ ( sequence + 1u ) & 1u].snes_state = data->snes_state;
+	self->buffer[ ( sequence + 1u ) & 1u].db9_state = data->db9_state;
+	/* buffer contents must be complete before the buffer becomes readable: */
+	SNES2DB9_BARRIER();
+	self->sequence = ( SNESSnapshotSeq ) ( sequence + 1u );
+	SNES2DB9_BARRIER();
+}
+
+SNESSnapshotSeq SNESSnapshot_Read ( const SNESSnapshot * self, SNESSnapshotData * data )
+{
+	SNESSnapshotSeq sequence;
+	assert ( self != NULL );
+	assert ( data != NULL );
+
+	do
+	{
+		sequence = self->sequence;
+		SNES2DB9_BARRIER();
+		data->snes_state = self->buffer[sequence & 1u].snes_state;
+		data->db9_state = self->buffer[sequence & 1u].db9_state;
+		SNES2DB9_BARRIER();
+	}
+	while ( sequence != self->sequence );
+
+	return sequence;
+}
@@ -0,0 +1,144 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_telemetry.c
+ * @brief   implements SNESTelemetry object
+ * @details A frame is sent as 8N1 UART bytes, one bit per SNESTelemetry_Update() call.
+ *          The baud rate equals the call rate, 5000 baud with the 200µs tick of the ATtiny84.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+#define BIT_START  0u   /**< bit time of the start bit */
+#define BIT_STOP   9u   /**< bit time of the stop bit */
+
+void SNESTelemetry_Init ( SNESTelemetry * self )
+{
+	assert ( self != NULL );
+	memset ( self->frame, 0, sizeof ( self->frame ) );
+	self->length = 0;
+	self->index = 0;
+	self->bit = BIT_START;
+	self->sequence = 0;
+}
+
+uint8_t SNESTelemetry_Crc8 ( const uint8_t * data, uint8_t length )
+{
+	uint8_t crc = 0;
+	uint8_t bit;
+	assert ( ( data != NULL ) || ( length == 0 ) );
+
+	while ( length > 0 )
+	{
+		crc ^= *data++;
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			if ( ( crc & 0x80u ) != 0 )
+			{
+				crc = ( uint8_t ) ( ( crc << 1 ) ^ 0x07u );
+			}
+			else
+			{
+				crc = ( uint8_t ) ( crc << 1 );
+			}
+		}
+
+		length--;
+	}
+
+	return crc;
+}
+
+void SNESTelemetry_Encode ( const SNESTelemetryData * data, uint8_t sequence, uint8_t * frame )
+{
+	assert ( data != NULL );
+	assert ( frame != NULL );
+	frame[0] = SNESTELEMETRY_SYNC;
+	frame[1] = sequence;
+	frame[2] = ( uint8_t ) ( data->snes_state & 0xFFu );
+	frame[3] = ( uint8_t ) ( data->snes_state >> 8 );
+	frame[4] = data->db9_state;
+	frame[5] = data->status;
+	frame[6] = ( uint8_t ) ( data->timing.missed_ticks & 0xFFu );
+	frame[7] = ( uint8_t ) ( data->timing.missed_ticks >> 8 );
+	frame[8] = data->timing.max_backlog;
+	frame[9] = ( uint8_t ) ( data->timing.max_iteration & 0xFFu );
+	frame[10] = ( uint8_t ) ( data->timing.max_iteration >> 8 );
+	/* the sync byte is excluded so a receiver can check the frame after resynchronization: */
+	frame[11] = SNESTelemetry_Crc8 ( &frame[1], SNESTELEMETRY_FRAME_SIZE - 2u );
+}
+
+bool SNESTelemetry_Send ( SNESTelemetry * self, const SNESTelemetryData * data )
+{
+	assert ( self != NULL );
+
+	if ( self->length != 0 )
+	{
+		return false;
+	}
+
+	SNESTelemetry_Encode ( data, self->sequence, self->frame );
+	self->sequence++;
+	self->index = 0;
+	self->bit = BIT_START;
+	self->length = SNESTELEMETRY_FRAME_SIZE;
+	return true;
+}
+
+bool SNESTelemetry_IsBusy ( const SNESTelemetry * self )
+{
+	assert ( self != NULL );
+	return ( self->length != 0 );
+}
+
+SNES2DB9_Pinstate SNESTelemetry_Update ( SNESTelemetry * self )
+{
+	SNES2DB9_Pinstate level = SNES2DB9_PIN_HIGH;
+	assert ( self != NULL );
+
+	if ( self->length == 0 )
+	{
+		return level;
+	}
+
+	if ( self->bit == BIT_START )
+	{
+		level = SNES2DB9_PIN_LOW;
+	}
+	else if ( self->bit < BIT_STOP )
+	{
+		/* data bits LSB first: */
+		if ( ( ( self->frame[self->index] >> ( self->bit - 1u ) ) & 1u ) == 0 )
+		{
+			level = SNES2DB9_PIN_LOW;
+		}
+	}
+
+	if ( self->bit == BIT_STOP )
+	{
+		self->bit = BIT_START;
+		self->index++;
+
+		if ( self->index >= self->length )
+		{
+			self->length = 0;
+		}
+	}
+	else
+	{
+		self->bit++;
+	}
+
+	return level;
+}
@@ -0,0 +1,84 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_timerreader.c
+ * @brief   implements SNESTimerReader object
+ * @details The pulse widths of CLK are set by the timer alone, the interrupt latency only delays
+ *          the sample within the low phase of CLK. LATCH and starting/stopping the timer are up to the caller.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+
+void SNESTimerReader_Init ( SNESTimerReader * self )
+{
+	assert ( self != NULL );
+	SNESSnapshot_Init ( &self->snapshot );
+	self->shiftreg = 0;
+	self->bit = SNESTIMERREADER_BITS;
+}
+
+void SNESTimerReader_BeginRead ( SNESTimerReader * self )
+{
+	assert ( self != NULL );
+	self->shiftreg = 0;
+	self->bit = 0;
+}
+
+bool SNESTimerReader_Sample ( SNESTimerReader * self, SNES2DB9_Pinstate data )
+{
+	SNESSnapshotData reading;
+	assert ( self != NULL );
+
+	/* a late interrupt after the last bit only stops the timer again: */
+	if ( self->bit >= SNESTIMERREADER_BITS )
+	{
+		return true;
+	}
+
+	/* first bit is button B, shifted up to the MSB like SNESReader does: */
+	self->shiftreg <<= 1;
+
+	if ( data == SNES2DB9_PIN_LOW )
+	{
+		self->shiftreg |= 1;
+	}
+
+	self->bit++;
+
+	if ( self->bit < SNESTIMERREADER_BITS )
+	{
+		return false;
+	}
+
+	reading.snes_state = self->shiftreg;
+	reading.db9_state = 0;
+	SNESSnapshot_Publish ( &self->snapshot, &reading );
+	return true;
+}
+
+bool SNESTimerReader_IsIdle ( const SNESTimerReader * self )
+{
+	assert ( self != NULL );
+	return ( self->bit >= SNESTIMERREADER_BITS );
+}
+
+SNESSnapshotSeq SNESTimerReader_GetState ( const SNESTimerReader * self, uint16_t * snes_state )
+{
+	SNESSnapshotData reading;
+	SNESSnapshotSeq  sequence;
+	assert ( self != NULL );
+	assert ( snes_state != NULL );
+	sequence = SNESSnapshot_Read ( &self->snapshot, &reading );
+	*snes_state = reading.snes_state;
+	return sequence;
+}
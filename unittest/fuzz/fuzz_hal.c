@@ -0,0 +1,62 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    fuzz_hal.c
+ * @brief   recording fake HAL shared by the fuzz harnesses
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fuzz_hal.h"
+
+FuzzHalLog FuzzHal;
+
+void FuzzHal_Clear ( void )
+{
+	FuzzHal.count = 0;
+}
+
+/**
+ * @brief     appends a call to the log
+ * @param[in] pin accessed
+ * @param[in] state set or returned
+ * @param[in] is_read true for reads
+ */
+static void Record ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read )
+{
+	if ( FuzzHal.count < FUZZ_HAL_LOG_SIZE )
+	{
+		FuzzHal.calls[FuzzHal.count].pin = pin;
+		FuzzHal.calls[FuzzHal.count].state = state;
+		FuzzHal.calls[FuzzHal.count].is_read = is_read;
+	}
+
+	FuzzHal.count++;
+}
+
+void FuzzHal_SetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	Record ( pin, state, false );
+}
+
+SNES2DB9_Pinstate FuzzHal_ReadPin ( SNES2DB9_Pin pin )
+{
+	Record ( pin, FuzzHal.data, true );
+	return FuzzHal.data;
+}
+
+void FuzzHal_Require ( bool condition, const char * message )
+{
+	if ( !condition )
+	{
+		fprintf ( stderr, "invariant violated: %s\n", message );
+		abort();
+	}
+}
@@ -0,0 +1,76 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    fuzz_hal.h
+ * @brief   recording fake HAL shared by the fuzz harnesses
+ * @details Every pin call is appended to a fixed size log without allocations to keep
+ *          the throughput high. The DATA level returned by reads is set by the harness.
+ *
+ */
+
+#ifndef FUZZ_HAL_H
+#define FUZZ_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "snes2db9.h"
+
+#define FUZZ_HAL_LOG_SIZE  16u  /**< pin calls recorded per step, more than any core function issues */
+
+/**
+ * @brief recorded pin call
+ */
+typedef struct
+{
+	SNES2DB9_Pin      pin;      /**< pin accessed */
+	SNES2DB9_Pinstate state;    /**< level set or returned */
+	bool              is_read;  /**< true for ReadPinFunc calls */
+} FuzzHalCall;
+
+/**
+ * @brief log of the pin calls of one step
+ */
+typedef struct
+{
+	FuzzHalCall       calls[FUZZ_HAL_LOG_SIZE];  /**< recorded calls */
+	size_t            count;                     /**< number of calls, may exceed FUZZ_HAL_LOG_SIZE */
+	SNES2DB9_Pinstate data;                      /**< level returned for SNES_DATA */
+} FuzzHalLog;
+
+extern FuzzHalLog FuzzHal;  /**< the log written by the fake HAL */
+
+/**
+ * @brief clears the log before the next step
+ */
+void FuzzHal_Clear ( void );
+
+/**
+ * @brief     fake SNES2DB9_SetPinFunc
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+void FuzzHal_SetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state );
+
+/**
+ * @brief     fake SNES2DB9_ReadPinFunc
+ * @param[in] pin to read
+ * @returns   FuzzHal.data
+ */
+SNES2DB9_Pinstate FuzzHal_ReadPin ( SNES2DB9_Pin pin );
+
+/**
+ * @brief     aborts with a message if an invariant does not hold
+ * @details   abort() is recognized as a crash by libFuzzer and AFL.
+ * @param[in] condition to check
+ * @param[in] message describing the invariant
+ */
+void FuzzHal_Require ( bool condition, const char * message );
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    fuzz_main.c
+ * @brief   standalone driver for the fuzz harnesses when libFuzzer is not available
+ * @details - with file arguments each file is run once, e.g. to reproduce crashes or for AFL (@@)
+ *          - without file arguments stdin is run once
+ *          - with -n N [-s SEED] N random inputs are run as a smoke test
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INPUT_SIZE  65536u  /**< largest input accepted */
+#define MAX_RANDOM_SIZE 512u    /**< largest random input */
+
+int LLVMFuzzerTestOneInput ( const uint8_t * data, size_t size );
+
+static uint8_t Input[MAX_INPUT_SIZE];  /**< input buffer */
+
+/**
+ * @brief     runs the harness once with the content of a stream
+ * @param[in] stream to read
+ */
+static void RunStream ( FILE * stream )
+{
+	size_t size = fread ( Input, 1, sizeof ( Input ), stream );
+	LLVMFuzzerTestOneInput ( Input, size );
+}
+
+/**
+ * @brief     runs the harness with random inputs
+ * @param[in] count of inputs
+ * @param[in] seed of the random generator
+ */
+static void RunRandom ( unsigned long count, uint32_t seed )
+{
+	uint32_t rng = ( seed != 0 ) ? seed : 1u;
+
+	while ( count-- > 0 )
+	{
+		size_t size;
+		size_t idx;
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		size = rng % MAX_RANDOM_SIZE;
+
+		for ( idx = 0; idx < size; idx++ )
+		{
+			rng ^= rng << 13;
+			rng ^= rng >> 17;
+			rng ^= rng << 5;
+			Input[idx] = ( uint8_t ) rng;
+		}
+
+		LLVMFuzzerTestOneInput ( Input, size );
+	}
+}
+
+/**
+ * @brief main function of the standalone fuzz driver
+ * @param argc
+ * @param argv
+ * @return 0, invariant violations abort
+ */
+int main ( int argc, char **argv )
+{
+	int idx;
+
+	if ( ( argc >= 3 ) && ( strcmp ( argv[1], "-n" ) == 0 ) )
+	{
+		uint32_t seed = 1;
+
+		if ( ( argc == 5 ) && ( strcmp ( argv[3], "-s" ) == 0 ) )
+		{
+			seed = ( uint32_t ) strtoul ( argv[4], NULL, 0 );
+		}
+
+		RunRandom ( strtoul ( argv[2], NULL, 0 ), seed );
+	}
+	else if ( argc == 1 )
+	{
+		RunStream ( stdin );
+	}
+	else
+	{
+		for ( idx = 1; idx < argc; idx++ )
+		{
+			FILE * stream = fopen ( argv[idx], "rb" );
+
+			if ( stream == NULL )
+			{
+				perror ( argv[idx] );
+				return 2;
+			}
+
+			RunStream ( stream );
+			fclose ( stream );
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    fuzz_mapper.c
+ * @brief   fuzz harness of SNESMapper and DB9_SetPins
+ * @details Input layout:
+ *          - 6 bytes fire, autofire and jump masks, 2 bytes autofire cycle time (little endian)
+ *          - then steps of 4 bytes: SNES input and millis_passed (little endian)
+ *
+ *          Each mapper result is checked against the button invariants and driven
+ *          through DB9_SetPins(), which must set every DB9 pin exactly once.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "snes2db9.h"
+#include "fuzz_hal.h"
+
+#define HEADER_SIZE  8u  /**< size of the configuration header */
+#define STEP_SIZE    4u  /**< size of one step */
+#define DB9_VALID_BITS ( DB9_BTNMASK_Up | DB9_BTNMASK_Down | DB9_BTNMASK_Left | DB9_BTNMASK_Right | DB9_BTNMASK_Fire )  /**< all DB9 outputs */
+
+/**
+ * @brief     reads a little endian 16bit value
+ * @param[in] data points to the first byte
+ * @returns   value
+ */
+static uint16_t Read16 ( const uint8_t * data )
+{
+	return ( uint16_t ) ( data[0] | ( data[1] << 8 ) );
+}
+
+/**
+ * @brief     checks the pin calls of DB9_SetPins
+ * @param[in] out DB9 state written
+ */
+static void CheckDB9 ( uint8_t out )
+{
+	static const SNES2DB9_Pin pins[] = { DB9_UP, DB9_DOWN, DB9_LEFT, DB9_RIGHT, DB9_FIRE };
+	static const uint8_t      masks[] = { DB9_BTNMASK_Up, DB9_BTNMASK_Down, DB9_BTNMASK_Left, DB9_BTNMASK_Right, DB9_BTNMASK_Fire };
+	uint8_t seen = 0;
+	size_t  call;
+	size_t  pin;
+	FuzzHal_Require ( FuzzHal.count == 5u, "DB9_SetPins sets five pins" );
+
+	for ( call = 0; call < FuzzHal.count; call++ )
+	{
+		FuzzHal_Require ( !FuzzHal.calls[call].is_read, "DB9_SetPins does not read" );
+
+		for ( pin = 0; pin < 5u; pin++ )
+		{
+			if ( FuzzHal.calls[call].pin == pins[pin] )
+			{
+				FuzzHal_Require ( ( seen & masks[pin] ) == 0, "each DB9 pin is set once" );
+				seen |= masks[pin];
+				FuzzHal_Require ( ( FuzzHal.calls[call].state == SNES2DB9_PIN_LOW ) == ( ( out & masks[pin] ) != 0 ),
+				                  "active DB9 pins are pulled low, inactive released" );
+				FuzzHal_Require ( FuzzHal.calls[call].state != SNES2DB9_PIN_HIGH, "DB9 pins are never driven high" );
+			}
+		}
+	}
+
+	FuzzHal_Require ( seen == DB9_VALID_BITS, "all DB9 pins are set" );
+}
+
+/**
+ * @brief     libFuzzer entry point
+ * @param[in] data fuzz input
+ * @param[in] size of the fuzz input
+ * @returns   0
+ */
+int LLVMFuzzerTestOneInput ( const uint8_t * data, size_t size )
+{
+	SNESMapperButtonMasks masks;
+	SNESMapper mapper;
+	uint16_t   cycletime;
+	size_t     idx;
+
+	if ( size < HEADER_SIZE )
+	{
+		return 0;
+	}
+
+	masks.fire_mask = Read16 ( &data[0] );
+	masks.autofire_mask = Read16 ( &data[2] );
+	masks.jump_mask = Read16 ( &data[4] );
+	cycletime = Read16 ( &data[6] );
+	SNESMapper_Init ( &mapper, &masks );
+	SNESMapper_SetAutofireDuration ( &mapper, cycletime );
+
+	for ( idx = HEADER_SIZE; ( idx + STEP_SIZE ) <= size; idx += STEP_SIZE )
+	{
+		uint16_t input = Read16 ( &data[idx] );
+		uint8_t  out = SNESMapper_Update ( &mapper, input, Read16 ( &data[idx + 2u] ) );
+		FuzzHal_Require ( ( out & ~DB9_VALID_BITS ) == 0, "no undefined DB9 bits" );
+		FuzzHal_Require ( ( ( out & DB9_BTNMASK_Up ) != 0 ) == ( ( input & ( SNES_BTNMASK_Up | masks.jump_mask ) ) != 0 ), "Up follows Up or jump" );
+		FuzzHal_Require ( ( ( out & DB9_BTNMASK_Down ) != 0 ) == ( ( input & SNES_BTNMASK_Down ) != 0 ), "Down follows its button" );
+		FuzzHal_Require ( ( ( out & DB9_BTNMASK_Left ) != 0 ) == ( ( input & SNES_BTNMASK_Left ) != 0 ), "Left follows its button" );
+		FuzzHal_Require ( ( ( out & DB9_BTNMASK_Right ) != 0 ) == ( ( input & SNES_BTNMASK_Right ) != 0 ), "Right follows its button" );
+		FuzzHal_Require ( ( ( out & DB9_BTNMASK_Fire ) == 0 ) || ( ( input & ( masks.fire_mask | masks.autofire_mask ) ) != 0 ),
+		                  "Fire only with fire or autofire buttons" );
+		FuzzHal_Require ( ( ( input & masks.fire_mask ) == 0 ) || ( ( out & DB9_BTNMASK_Fire ) != 0 ), "fire buttons always fire" );
+		FuzzHal_Require ( ( cycletime != 0 ) || ( ( out & DB9_BTNMASK_Fire ) == 0 ) || ( ( input & masks.fire_mask ) != 0 ),
+		                  "no autofire when disabled" );
+		FuzzHal_Clear();
+		DB9_SetPins ( out, FuzzHal_SetPin );
+		CheckDB9 ( out );
+	}
+
+	return 0;
+}
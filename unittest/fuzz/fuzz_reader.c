@@ -0,0 +1,140 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    fuzz_reader.c
+ * @brief   fuzz harness of the SNESReader state machine
+ * @details Each input byte is one step:
+ *          - bits 0..1 select the operation: 0/1 update, 2 SNESReader_BeginRead(), 3 stuck line
+ *          - bit 2 is the DATA level for the step
+ *          - bits 3..7 are the repeat count of a stuck line
+ *
+ *          The harness shadows the reader with its own model of the protocol steps and checks
+ *          pin order, the idle state and that the returned result only changes at the step
+ *          completing a reading. Only the public API is used, the reader internals may change freely.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "snes2db9.h"
+#include "fuzz_hal.h"
+
+#define STEP_LATCH      0   /**< protocol step rising the latch pin */
+#define STEP_COMPLETE  32   /**< protocol step publishing the result */
+#define STEP_IDLE      33   /**< no reading in progress */
+
+/**
+ * @brief shadow model of the reader
+ */
+typedef struct
+{
+	uint8_t  step;      /**< protocol step of the next update */
+	uint16_t shiftreg;  /**< bits accumulated since the last latch */
+	uint16_t result;    /**< last result returned by the reader */
+} Shadow;
+
+/**
+ * @brief          performs one update and checks all invariants
+ * @param[in, out] reader under test
+ * @param[in, out] shadow model
+ * @param[in]      data level presented on SNES_DATA
+ */
+static void Step ( SNESReader * reader, Shadow * shadow, SNES2DB9_Pinstate data )
+{
+	uint8_t  step = shadow->step;
+	uint16_t ret;
+	bool     expect_read = ( step < STEP_COMPLETE ) && ( ( step % 2 ) == 1 );
+	FuzzHal_Clear();
+	FuzzHal.data = data;
+	ret = SNESReader_Update ( reader );
+	FuzzHal_Require ( FuzzHal.count == ( expect_read ? 3u : 2u ), "number of pin calls per update" );
+	FuzzHal_Require ( !FuzzHal.calls[0].is_read && ( FuzzHal.calls[0].pin == SNES_CLK ), "CLK is set first" );
+	FuzzHal_Require ( !FuzzHal.calls[1].is_read && ( FuzzHal.calls[1].pin == SNES_LATCH ), "LATCH is set second" );
+	FuzzHal_Require ( ( FuzzHal.calls[1].state == SNES2DB9_PIN_HIGH ) == ( step == STEP_LATCH ), "LATCH is high only in the latch step" );
+	FuzzHal_Require ( ( FuzzHal.calls[0].state == SNES2DB9_PIN_LOW ) == ( ( step != STEP_LATCH ) && ( step < STEP_COMPLETE ) && ( ( step % 2 ) == 0 ) ),
+	                  "CLK is low only in clock steps" );
+
+	if ( expect_read )
+	{
+		FuzzHal_Require ( FuzzHal.calls[2].is_read && ( FuzzHal.calls[2].pin == SNES_DATA ), "DATA is read after CLK and LATCH" );
+	}
+
+	/* advance shadow model: */
+	if ( step == STEP_LATCH )
+	{
+		shadow->shiftreg = 0;
+	}
+	else if ( ( step < STEP_COMPLETE ) && ( ( step % 2 ) == 0 ) )
+	{
+		shadow->shiftreg <<= 1;
+	}
+
+	if ( expect_read && ( data == SNES2DB9_PIN_LOW ) )
+	{
+		shadow->shiftreg |= 1;
+	}
+
+	if ( step == STEP_COMPLETE )
+	{
+		FuzzHal_Require ( ret == shadow->shiftreg, "result matches the bits read" );
+		shadow->result = ret;
+	}
+	else
+	{
+		FuzzHal_Require ( ret == shadow->result, "result only changes when a reading completes" );
+	}
+
+	shadow->step = ( step < STEP_IDLE ) ? ( uint8_t ) ( step + 1u ) : STEP_IDLE;
+	FuzzHal_Require ( SNESReader_IsIdle ( reader ) == ( shadow->step == STEP_IDLE ), "idle exactly after the completing step" );
+}
+
+/**
+ * @brief     libFuzzer entry point
+ * @param[in] data fuzz input
+ * @param[in] size of the fuzz input
+ * @returns   0
+ */
+int LLVMFuzzerTestOneInput ( const uint8_t * data, size_t size )
+{
+	SNESReader reader;
+	Shadow     shadow = { STEP_IDLE, 0, 0 };
+	size_t     idx;
+	FuzzHal_Clear();
+	SNESReader_Init ( &reader, FuzzHal_SetPin, FuzzHal_ReadPin );
+	FuzzHal_Require ( FuzzHal.count == 2u, "init sets CLK and LATCH" );
+	FuzzHal_Require ( SNESReader_IsIdle ( &reader ) == true, "reader starts idle" );
+
+	for ( idx = 0; idx < size; idx++ )
+	{
+		uint8_t           op = data[idx] & 0x03u;
+		SNES2DB9_Pinstate level = ( ( data[idx] & 0x04u ) != 0 ) ? SNES2DB9_PIN_HIGH : SNES2DB9_PIN_LOW;
+
+		if ( op == 2u )
+		{
+			SNESReader_BeginRead ( &reader );
+			shadow.step = STEP_LATCH;
+			FuzzHal_Require ( SNESReader_IsIdle ( &reader ) == false, "BeginRead starts a reading" );
+		}
+		else if ( op == 3u )
+		{
+			uint8_t repeat = ( uint8_t ) ( data[idx] >> 3 ) + 1u;
+
+			while ( repeat-- > 0 )
+			{
+				Step ( &reader, &shadow, level );
+			}
+		}
+		else
+		{
+			Step ( &reader, &shadow, level );
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,620 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_capture.c
+ * @brief   implements the logic analyzer capture reader
+ *
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "snes2db9_capture.h"
+
+#define RELEASE_CHUNK  ( 64u * 1024u * 1024u )  /**< consumed bytes released from the mapping at once */
+#define MAX_VCD_VARS   1024u                    /**< maximum number of VCD variables considered for channel lookup */
+
+static const uint8_t ChannelBits[CAPTURE_CHANNELS] = { CAPTURE_LATCH, CAPTURE_CLK, CAPTURE_DATA };  /**< level bit per channel */
+
+/**
+ * @brief VCD variable found in the header
+ */
+typedef struct
+{
+	char id[CAPTURE_ID_SIZE];  /**< identifier */
+	char name[64];             /**< reference name */
+} VcdVar;
+
+/**
+ * @brief          releases consumed pages of the mapping to keep memory usage constant
+ * @param[in, out] self points to instance of Capture
+ */
+static void ReleaseConsumed ( Capture * self )
+{
+	long   page = sysconf ( _SC_PAGESIZE );
+	size_t end;
+
+	if ( ( self->pos - self->released ) < RELEASE_CHUNK )
+	{
+		return;
+	}
+
+	end = self->pos - ( self->pos % ( size_t ) page );
+	( void ) madvise ( ( void * ) ( self->data + self->released ), end - self->released, MADV_DONTNEED );
+	self->released = end;
+}
+
+/**
+ * @brief          returns the next line without line terminator
+ * @param[in, out] self points to instance of Capture
+ * @param[out]     len of the line
+ * @returns        start of the line, NULL at the end of the file
+ */
+static const char * NextLine ( Capture * self, size_t * len )
+{
+	const char * line;
+	const char * end;
+
+	if ( self->pos >= self->size )
+	{
+		return NULL;
+	}
+
+	line = self->data + self->pos;
+	end = memchr ( line, '\n', self->size - self->pos );
+
+	if ( end == NULL )
+	{
+		end = self->data + self->size;
+	}
+
+	self->pos = ( size_t ) ( end - self->data ) + 1u;
+	*len = ( size_t ) ( end - line );
+
+	if ( ( *len > 0 ) && ( line[*len - 1] == '\r' ) )
+	{
+		( *len )--;
+	}
+
+	ReleaseConsumed ( self );
+	return line;
+}
+
+/**
+ * @brief          returns the next whitespace separated token
+ * @param[in, out] self points to instance of Capture
+ * @param[out]     len of the token
+ * @returns        start of the token, NULL at the end of the file
+ */
+static const char * NextToken ( Capture * self, size_t * len )
+{
+	const char * token;
+
+	while ( ( self->pos < self->size ) && isspace ( ( unsigned char ) self->data[self->pos] ) )
+	{
+		self->pos++;
+	}
+
+	if ( self->pos >= self->size )
+	{
+		return NULL;
+	}
+
+	token = self->data + self->pos;
+
+	while ( ( self->pos < self->size ) && !isspace ( ( unsigned char ) self->data[self->pos] ) )
+	{
+		self->pos++;
+	}
+
+	*len = ( size_t ) ( ( self->data + self->pos ) - token );
+	ReleaseConsumed ( self );
+	return token;
+}
+
+/**
+ * @brief     compares a token with a string
+ * @param[in] token to compare
+ * @param[in] len of the token
+ * @param[in] str to compare with
+ * @returns   true if equal
+ */
+static bool TokenIs ( const char * token, size_t len, const char * str )
+{
+	return ( strlen ( str ) == len ) && ( memcmp ( token, str, len ) == 0 );
+}
+
+/**
+ * @brief     case insensitive substring search
+ * @param[in] haystack to search in
+ * @param[in] needle to search
+ * @returns   true if found
+ */
+static bool ContainsNoCase ( const char * haystack, const char * needle )
+{
+	size_t len = strlen ( needle );
+
+	for ( ; *haystack != '\0'; haystack++ )
+	{
+		if ( strncasecmp ( haystack, needle, len ) == 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief     looks up a channel name in a list of names
+ * @param[in] name to look up
+ * @param[in] list of names
+ * @param[in] stride between names in bytes
+ * @param[in] count of names
+ * @returns   index of the match, -1 if not found
+ */
+static int FindName ( const char * name, const char * list, size_t stride, size_t count )
+{
+	size_t idx;
+
+	for ( idx = 0; idx < count; idx++ )
+	{
+		if ( strcmp ( list + ( idx * stride ), name ) == 0 )
+		{
+			return ( int ) idx;
+		}
+	}
+
+	for ( idx = 0; idx < count; idx++ )
+	{
+		if ( ContainsNoCase ( list + ( idx * stride ), name ) )
+		{
+			return ( int ) idx;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief     parses a sigrok sample rate such as "24 MHz"
+ * @param[in] text following the "Samplerate:" key
+ * @returns   sample rate in Hz, 0 if not parseable
+ */
+static uint64_t ParseSamplerate ( const char * text )
+{
+	char * unit;
+	double value = strtod ( text, &unit );
+
+	while ( *unit == ' ' )
+	{
+		unit++;
+	}
+
+	switch ( toupper ( ( unsigned char ) *unit ) )
+	{
+		case 'K': value *= 1e3; break;
+		case 'M': value *= 1e6; break;
+		case 'G': value *= 1e9; break;
+		default: break;
+	}
+
+	return ( uint64_t ) ( value + 0.5 );
+}
+
+/**
+ * @brief          parses the CSV header and locates the channel columns
+ * @param[in, out] self points to instance of Capture
+ * @param[in]      names of the channels
+ * @returns        0 on success, -1 on error
+ */
+static int OpenCsv ( Capture * self, const char * const names[CAPTURE_CHANNELS] )
+{
+	char         header[64][64];
+	size_t       nr_fields = 0;
+	size_t       len;
+	size_t       start;
+	const char * line;
+	uint32_t     channel;
+
+	self->time_column = -1;
+
+	while ( ( line = NextLine ( self, &len ) ) != NULL )
+	{
+		if ( ( len == 0 ) || ( line[0] == ';' ) )
+		{
+			const char * key = ( len > 0 ) ? memchr ( line, ':', len ) : NULL;
+
+			if ( ( key != NULL ) && ( self->samplerate_hz == 0 ) && ( len > 12 ) && ( strncasecmp ( line, "; Samplerate", 12 ) == 0 ) )
+			{
+				char   text[32] = { 0 };
+				size_t text_len = ( size_t ) ( line + len - key - 1 );
+				memcpy ( text, key + 1, ( text_len < sizeof ( text ) ) ? text_len : sizeof ( text ) - 1u );
+				self->samplerate_hz = ParseSamplerate ( text );
+			}
+
+			continue;
+		}
+
+		break;
+	}
+
+	if ( line == NULL )
+	{
+		fprintf ( stderr, "capture contains no samples\n" );
+		return -1;
+	}
+
+	/* a first row with letters is the header, otherwise it is data: */
+	for ( start = 0; ( start < len ) && !isalpha ( ( unsigned char ) line[start] ); start++ )
+	{
+	}
+
+	if ( start < len )
+	{
+		size_t pos = 0;
+
+		while ( ( pos <= len ) && ( nr_fields < 64u ) )
+		{
+			size_t end = pos;
+			size_t field_len;
+
+			while ( ( end < len ) && ( line[end] != ',' ) )
+			{
+				end++;
+			}
+
+			field_len = ( ( end - pos ) < 63u ) ? ( end - pos ) : 63u;
+			memcpy ( header[nr_fields], line + pos, field_len );
+			header[nr_fields][field_len] = '\0';
+
+			if ( strncasecmp ( header[nr_fields], "Time", 4 ) == 0 )
+			{
+				self->time_column = ( int ) nr_fields;
+			}
+
+			nr_fields++;
+			pos = end + 1u;
+		}
+	}
+	else
+	{
+		/* rewind to the first data row: */
+		self->pos = ( size_t ) ( line - self->data );
+	}
+
+	for ( channel = 0; channel < CAPTURE_CHANNELS; channel++ )
+	{
+		char * end;
+		long   column = strtol ( names[channel], &end, 10 );
+
+		if ( ( *end == '\0' ) && ( end != names[channel] ) )
+		{
+			self->columns[channel] = ( int ) column;
+		}
+		else if ( nr_fields > 0 )
+		{
+			self->columns[channel] = FindName ( names[channel], &header[0][0], sizeof ( header[0] ), nr_fields );
+		}
+		else
+		{
+			/* no header: LATCH, CLK, DATA in the first columns */
+			self->columns[channel] = ( int ) channel;
+		}
+
+		if ( self->columns[channel] < 0 )
+		{
+			fprintf ( stderr, "channel %s not found in CSV header\n", names[channel] );
+			return -1;
+		}
+	}
+
+	if ( ( self->time_column < 0 ) && ( self->samplerate_hz == 0 ) )
+	{
+		fprintf ( stderr, "CSV capture has neither time column nor sample rate, use --samplerate\n" );
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief          parses the VCD header and locates the channel identifiers
+ * @param[in, out] self points to instance of Capture
+ * @param[in]      names of the channels
+ * @returns        0 on success, -1 on error
+ */
+static int OpenVcd ( Capture * self, const char * const names[CAPTURE_CHANNELS] )
+{
+	VcdVar *     vars = calloc ( MAX_VCD_VARS, sizeof ( VcdVar ) );
+	size_t       nr_vars = 0;
+	size_t       len;
+	const char * token;
+	uint32_t     channel;
+	int          rc = 0;
+
+	if ( vars == NULL )
+	{
+		return -1;
+	}
+
+	self->timescale_fs = 1000000u;
+
+	while ( ( token = NextToken ( self, &len ) ) != NULL )
+	{
+		if ( TokenIs ( token, len, "$enddefinitions" ) )
+		{
+			( void ) NextToken ( self, &len );
+			break;
+		}
+		else if ( TokenIs ( token, len, "$timescale" ) )
+		{
+			char     text[32] = { 0 };
+			size_t   used = 0;
+			char *   unit;
+			uint64_t value;
+
+			while ( ( ( token = NextToken ( self, &len ) ) != NULL ) && !TokenIs ( token, len, "$end" ) )
+			{
+				if ( ( used + len ) < sizeof ( text ) )
+				{
+					memcpy ( text + used, token, len );
+					used += len;
+				}
+			}
+
+			value = strtoull ( text, &unit, 10 );
+			self->timescale_fs = value * ( ( strcmp ( unit, "s" ) == 0 ) ? 1000000000000000ull :
+			                               ( strcmp ( unit, "ms" ) == 0 ) ? 1000000000000ull :
+			                               ( strcmp ( unit, "us" ) == 0 ) ? 1000000000ull :
+			                               ( strcmp ( unit, "ns" ) == 0 ) ? 1000000ull :
+			                               ( strcmp ( unit, "ps" ) == 0 ) ? 1000ull : 1ull );
+		}
+		else if ( TokenIs ( token, len, "$var" ) )
+		{
+			const char * fields[4];
+			size_t       lens[4];
+			uint32_t     idx;
+
+			/* type, size, identifier, reference: */
+			for ( idx = 0; idx < 4u; idx++ )
+			{
+				fields[idx] = NextToken ( self, &lens[idx] );
+
+				if ( fields[idx] == NULL )
+				{
+					break;
+				}
+			}
+
+			if ( ( idx == 4u ) && ( nr_vars < MAX_VCD_VARS ) && ( lens[2] < CAPTURE_ID_SIZE ) )
+			{
+				memcpy ( vars[nr_vars].id, fields[2], lens[2] );
+				memcpy ( vars[nr_vars].name, fields[3], ( lens[3] < sizeof ( vars[0].name ) ) ? lens[3] : sizeof ( vars[0].name ) - 1u );
+				nr_vars++;
+			}
+
+			while ( ( ( token = NextToken ( self, &len ) ) != NULL ) && !TokenIs ( token, len, "$end" ) )
+			{
+			}
+		}
+		else if ( ( token[0] == '$' ) && !TokenIs ( token, len, "$end" ) && !TokenIs ( token, len, "$scope" ) &&
+		          !TokenIs ( token, len, "$upscope" ) )
+		{
+			/* $date, $version, $comment: */
+			while ( ( ( token = NextToken ( self, &len ) ) != NULL ) && !TokenIs ( token, len, "$end" ) )
+			{
+			}
+		}
+	}
+
+	for ( channel = 0; channel < CAPTURE_CHANNELS; channel++ )
+	{
+		int idx = FindName ( names[channel], vars[0].name, sizeof ( VcdVar ), nr_vars );
+
+		if ( idx < 0 )
+		{
+			fprintf ( stderr, "channel %s not found in VCD header\n", names[channel] );
+			rc = -1;
+			break;
+		}
+
+		memcpy ( self->ids[channel], vars[idx].id, CAPTURE_ID_SIZE );
+	}
+
+	free ( vars );
+	return rc;
+}
+
+int Capture_Open ( Capture * self, const char * path, const char * const names[CAPTURE_CHANNELS], uint64_t samplerate_hz )
+{
+	struct stat info;
+	int         fd;
+	void *      map;
+	assert ( self != NULL );
+	memset ( self, 0, sizeof ( *self ) );
+	self->samplerate_hz = samplerate_hz;
+	/* lines are pulled up: */
+	self->levels = CAPTURE_LATCH | CAPTURE_CLK | CAPTURE_DATA;
+	fd = open ( path, O_RDONLY );
+
+	if ( fd < 0 )
+	{
+		perror ( path );
+		return -1;
+	}
+
+	if ( ( fstat ( fd, &info ) != 0 ) || ( info.st_size == 0 ) )
+	{
+		fprintf ( stderr, "%s: empty or unreadable capture\n", path );
+		close ( fd );
+		return -1;
+	}
+
+	map = mmap ( NULL, ( size_t ) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close ( fd );
+
+	if ( map == MAP_FAILED )
+	{
+		perror ( path );
+		return -1;
+	}
+
+	( void ) madvise ( map, ( size_t ) info.st_size, MADV_SEQUENTIAL );
+	self->data = map;
+	self->size = ( size_t ) info.st_size;
+	self->format = ( memchr ( self->data, '$', ( self->size < 4096u ) ? self->size : 4096u ) != NULL ) ? CAPTURE_VCD : CAPTURE_CSV;
+
+	if ( ( ( self->format == CAPTURE_VCD ) ? OpenVcd ( self, names ) : OpenCsv ( self, names ) ) != 0 )
+	{
+		Capture_Close ( self );
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief          reads the next CSV row
+ * @param[in, out] self points to instance of Capture
+ * @returns        true if a row was read
+ */
+static bool NextCsv ( Capture * self )
+{
+	const char * line;
+	size_t       len;
+	size_t       pos = 0;
+	int          column = 0;
+	uint32_t     channel;
+
+	do
+	{
+		line = NextLine ( self, &len );
+	}
+	while ( ( line != NULL ) && ( ( len == 0 ) || ( line[0] == ';' ) ) );
+
+	if ( line == NULL )
+	{
+		return false;
+	}
+
+	self->time_ns = ( self->time_column < 0 ) ? ( self->sample_idx * 1000000000ull ) / self->samplerate_hz : self->time_ns;
+	self->sample_idx++;
+
+	while ( pos < len )
+	{
+		if ( column == self->time_column )
+		{
+			self->time_ns = ( uint64_t ) ( strtod ( line + pos, NULL ) * 1e9 + 0.5 );
+		}
+
+		for ( channel = 0; channel < CAPTURE_CHANNELS; channel++ )
+		{
+			if ( column == self->columns[channel] )
+			{
+				self->levels = ( line[pos] == '0' ) ? ( self->levels & ~ChannelBits[channel] ) : ( self->levels | ChannelBits[channel] );
+			}
+		}
+
+		while ( ( pos < len ) && ( line[pos] != ',' ) )
+		{
+			pos++;
+		}
+
+		pos++;
+		column++;
+	}
+
+	return true;
+}
+
+/**
+ * @brief          reads all value changes of the next VCD timestamp
+ * @param[in, out] self points to instance of Capture
+ * @returns        true if a timestamp was read
+ */
+static bool NextVcd ( Capture * self )
+{
+	const char * token;
+	size_t       len;
+	bool         have_time = false;
+	uint32_t     channel;
+
+	while ( ( token = NextToken ( self, &len ) ) != NULL )
+	{
+		if ( token[0] == '#' )
+		{
+			uint64_t time = strtoull ( token + 1, NULL, 10 );
+
+			if ( have_time )
+			{
+				/* belongs to the next sample: */
+				self->pos = ( size_t ) ( token - self->data );
+				return true;
+			}
+
+			self->time_ns = ( self->timescale_fs >= 1000000u ) ? time * ( self->timescale_fs / 1000000u ) : ( time * self->timescale_fs ) / 1000000u;
+			have_time = true;
+		}
+		else if ( TokenIs ( token, len, "$comment" ) )
+		{
+			while ( ( ( token = NextToken ( self, &len ) ) != NULL ) && !TokenIs ( token, len, "$end" ) )
+			{
+			}
+		}
+		else if ( ( token[0] == 'b' ) || ( token[0] == 'B' ) || ( token[0] == 'r' ) || ( token[0] == 'R' ) )
+		{
+			/* vector and real values are not used, skip the identifier: */
+			( void ) NextToken ( self, &len );
+		}
+		else if ( token[0] != '$' )
+		{
+			for ( channel = 0; channel < CAPTURE_CHANNELS; channel++ )
+			{
+				if ( ( ( len - 1u ) == strlen ( self->ids[channel] ) ) && ( memcmp ( token + 1, self->ids[channel], len - 1u ) == 0 ) )
+				{
+					self->levels = ( token[0] == '0' ) ? ( self->levels & ~ChannelBits[channel] ) : ( self->levels | ChannelBits[channel] );
+				}
+			}
+		}
+	}
+
+	return have_time;
+}
+
+bool Capture_Next ( Capture * self, uint64_t * time_ns, uint8_t * levels )
+{
+	bool valid;
+	assert ( self != NULL );
+	valid = ( self->format == CAPTURE_VCD ) ? NextVcd ( self ) : NextCsv ( self );
+	*time_ns = self->time_ns;
+	*levels = self->levels;
+	return valid;
+}
+
+void Capture_Close ( Capture * self )
+{
+	assert ( self != NULL );
+
+	if ( self->data != NULL )
+	{
+		munmap ( ( void * ) self->data, self->size );
+		self->data = NULL;
+	}
+}
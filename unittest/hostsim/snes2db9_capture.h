@@ -0,0 +1,105 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_capture.h
+ * @brief   API of the logic analyzer capture reader
+ * @details Reads sigrok CSV and VCD captures of the LATCH, CLK and DATA lines.
+ *          The file is memory mapped and parsed incrementally, consumed pages are released
+ *          so captures of several gigabytes can be processed with constant memory.
+ *
+ */
+
+/**
+ * @addtogroup SNES2DB9_Simulator
+ * @{
+ */
+
+#ifndef SNES2DB9_CAPTURE_H
+#define SNES2DB9_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CAPTURE_LATCH    0x01u  /**< level bit of the LATCH channel */
+#define CAPTURE_CLK      0x02u  /**< level bit of the CLK channel */
+#define CAPTURE_DATA     0x04u  /**< level bit of the DATA channel */
+#define CAPTURE_CHANNELS 3u     /**< number of channels */
+#define CAPTURE_ID_SIZE  16u    /**< maximum length of a VCD identifier */
+
+/**
+ * @brief   capture file formats
+ */
+typedef enum
+{
+	CAPTURE_CSV,  /**< sigrok CSV output, optionally with time column */
+	CAPTURE_VCD   /**< value change dump */
+} CaptureFormat;
+
+/**
+ * @brief   capture reader
+ * @details All members shall be considered private. Access should be routed through the Capture_... functions
+ */
+typedef struct
+{
+	const char *  data;                                    /**< mapped file */
+	size_t        size;                                    /**< size of the mapping */
+	size_t        pos;                                     /**< parse position */
+	size_t        released;                                /**< mapping released up to this offset */
+	CaptureFormat format;                                  /**< file format */
+	uint8_t       levels;                                  /**< current levels composed of CAPTURE_xxx bits */
+	uint64_t      time_ns;                                 /**< time of the current sample */
+	uint64_t      samplerate_hz;                           /**< CSV sample rate when no time column exists */
+	uint64_t      sample_idx;                              /**< CSV sample counter */
+	int           time_column;                             /**< CSV time column, -1 if none */
+	int           columns[CAPTURE_CHANNELS];               /**< CSV column per channel */
+	uint64_t      timescale_fs;                            /**< VCD timescale in fs */
+	char          ids[CAPTURE_CHANNELS][CAPTURE_ID_SIZE];  /**< VCD identifier per channel */
+} Capture;
+
+/**
+ * @brief          opens a capture
+ * @details        The format is detected from the content. Channels are located by name
+ *                 (exact match first, then case insensitive substring) or by numeric CSV column index.
+ * @param[in, out] self points to instance of Capture
+ * @param[in]      path of the capture file
+ * @param[in]      names of the LATCH, CLK and DATA channels
+ * @param[in]      samplerate_hz used for CSV files without time column, 0 to take it from the sigrok header
+ * @returns        0 on success, -1 on error with message on stderr
+ */
+int  Capture_Open ( Capture * self, const char * path, const char * const names[CAPTURE_CHANNELS], uint64_t samplerate_hz );
+
+/**
+ * @brief          reads the next sample
+ * @details        CSV files deliver every row, VCD files one sample per timestamp.
+ *                 Undefined and high impedance levels are read as high (pulled up lines).
+ * @param[in, out] self points to instance of Capture
+ * @param[out]     time_ns of the sample
+ * @param[out]     levels composed of CAPTURE_xxx bits
+ * @returns        true if a sample was read, false at the end of the capture
+ */
+bool Capture_Next ( Capture * self, uint64_t * time_ns, uint8_t * levels );
+
+/**
+ * @brief          closes a capture
+ * @param[in, out] self points to instance of Capture
+ */
+void Capture_Close ( Capture * self );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @} */
@@ -0,0 +1,565 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_inputtrace.c
+ * @brief   implements the compact binary SNES input trace format
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "snes2db9_inputtrace.h"
+
+#define HEADER_SIZE       16u    /**< size of the file header */
+#define INDEX_ENTRY_SIZE  18u    /**< size of an index entry in the file */
+#define FOOTER_SIZE       28u    /**< size of the file footer */
+#define OP_FULL_STATE     16u    /**< opcode followed by the complete state */
+#define OP_END            31u    /**< opcode terminating the trace */
+#define OP_BITS           5u     /**< bits of the opcode in the record header */
+
+static const char HeaderMagic[4] = { 'S', '2', 'D', 'T' };  /**< file magic */
+static const char FooterMagic[4] = { 'S', '2', 'D', 'I' };  /**< index magic */
+
+/**
+ * @brief decoded record
+ */
+typedef struct
+{
+	size_t   next;   /**< offset following the record */
+	uint64_t time;   /**< time after the record */
+	uint16_t state;  /**< state after the record */
+	bool     end;    /**< record terminates the trace */
+} Record;
+
+/**
+ * @brief     stores a little endian value
+ * @param[out] buf to store to
+ * @param[in] value to store
+ * @param[in] size in bytes
+ */
+static void PutLE ( uint8_t * buf, uint64_t value, uint32_t size )
+{
+	uint32_t idx;
+
+	for ( idx = 0; idx < size; idx++ )
+	{
+		buf[idx] = ( uint8_t ) ( value >> ( 8u * idx ) );
+	}
+}
+
+/**
+ * @brief     loads a little endian value
+ * @param[in] buf to load from
+ * @param[in] size in bytes
+ * @returns   value
+ */
+static uint64_t GetLE ( const uint8_t * buf, uint32_t size )
+{
+	uint64_t value = 0;
+	uint32_t idx;
+
+	for ( idx = 0; idx < size; idx++ )
+	{
+		value |= ( uint64_t ) buf[idx] << ( 8u * idx );
+	}
+
+	return value;
+}
+
+/**
+ * @brief          appends an index entry
+ * @param[in, out] index array to grow
+ * @param[in, out] nr_index in use
+ * @param[in, out] cap_index allocated
+ * @param[in]      entry to append
+ * @returns        0 on success, -1 on allocation failure
+ */
+static int IndexAppend ( InputTraceIndex ** index, size_t * nr_index, size_t * cap_index, const InputTraceIndex * entry )
+{
+	if ( *nr_index == *cap_index )
+	{
+		size_t            cap = ( *cap_index == 0 ) ? 256u : ( *cap_index * 2u );
+		InputTraceIndex * grown = realloc ( *index, cap * sizeof ( InputTraceIndex ) );
+
+		if ( grown == NULL )
+		{
+			return -1;
+		}
+
+		*index = grown;
+		*cap_index = cap;
+	}
+
+	( *index ) [ ( *nr_index ) ++] = *entry;
+	return 0;
+}
+
+/**
+ * @brief          writes bytes and tracks the file offset
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      buf to write
+ * @param[in]      size of buf
+ * @returns        0 on success, -1 on error
+ */
+static int Write ( InputTraceWriter * self, const uint8_t * buf, size_t size )
+{
+	self->offset += size;
+	return ( fwrite ( buf, 1, size, self->fp ) == size ) ? 0 : -1;
+}
+
+/**
+ * @brief          writes a record
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      delta time to the previous record
+ * @param[in]      opcode of the record
+ * @param[in]      state for OP_FULL_STATE
+ * @returns        0 on success, -1 on error
+ */
+static int WriteRecord ( InputTraceWriter * self, uint64_t delta, uint32_t opcode, uint16_t state )
+{
+	uint8_t  buf[16];
+	size_t   len = 0;
+	uint64_t header = ( delta << OP_BITS ) | opcode;
+
+	do
+	{
+		buf[len] = ( uint8_t ) ( header & 0x7Fu );
+		header >>= 7;
+		buf[len] |= ( header != 0 ) ? 0x80u : 0;
+		len++;
+	}
+	while ( header != 0 );
+
+	if ( opcode == OP_FULL_STATE )
+	{
+		PutLE ( &buf[len], state, 2 );
+		len += 2u;
+	}
+
+	return Write ( self, buf, len );
+}
+
+/**
+ * @brief          adds index entries for all buckets starting up to a given time
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      time of the next record
+ * @returns        0 on success, -1 on allocation failure
+ */
+static int WriterIndexUpTo ( InputTraceWriter * self, uint64_t time )
+{
+	InputTraceIndex entry;
+
+	while ( ( ( uint64_t ) self->nr_index * self->bucket_ticks ) <= time )
+	{
+		entry.offset = self->offset;
+		entry.time = self->time;
+		entry.state = self->state;
+
+		if ( IndexAppend ( &self->index, &self->nr_index, &self->cap_index, &entry ) != 0 )
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int InputTraceWriter_Open ( InputTraceWriter * self, const char * path, uint32_t tick_us, uint32_t frame_ticks )
+{
+	uint8_t header[HEADER_SIZE] = { 0 };
+	assert ( self != NULL );
+	assert ( tick_us > 0 );
+	memset ( self, 0, sizeof ( *self ) );
+	self->tick_us = tick_us;
+	self->frame_ticks = frame_ticks;
+	self->bucket_ticks = INPUTTRACE_BUCKET_TICKS;
+	self->fp = fopen ( path, "wb" );
+
+	if ( self->fp == NULL )
+	{
+		return -1;
+	}
+
+	memcpy ( header, HeaderMagic, sizeof ( HeaderMagic ) );
+	header[4] = INPUTTRACE_VERSION;
+	PutLE ( &header[8], tick_us, 4 );
+	PutLE ( &header[12], frame_ticks, 4 );
+	return Write ( self, header, sizeof ( header ) );
+}
+
+int InputTraceWriter_Add ( InputTraceWriter * self, uint64_t time, uint16_t state )
+{
+	uint16_t changed;
+	uint32_t bit;
+	assert ( self != NULL );
+	assert ( time >= self->time );
+	changed = self->state ^ state;
+
+	if ( changed == 0 )
+	{
+		return 0;
+	}
+
+	if ( WriterIndexUpTo ( self, time ) != 0 )
+	{
+		return -1;
+	}
+
+	/* single button toggles use the short form: */
+	if ( ( changed & ( changed - 1u ) ) == 0 )
+	{
+		for ( bit = 0; ( changed >> bit ) != 1u; bit++ )
+		{
+		}
+
+		if ( WriteRecord ( self, time - self->time, bit, 0 ) != 0 )
+		{
+			return -1;
+		}
+	}
+	else if ( WriteRecord ( self, time - self->time, OP_FULL_STATE, state ) != 0 )
+	{
+		return -1;
+	}
+
+	self->time = time;
+	self->state = state;
+	return 0;
+}
+
+int InputTraceWriter_Close ( InputTraceWriter * self, uint64_t end_time )
+{
+	uint8_t  buf[FOOTER_SIZE];
+	uint64_t index_offset;
+	size_t   idx;
+	int      rc;
+	assert ( self != NULL );
+	assert ( end_time >= self->time );
+	rc = WriterIndexUpTo ( self, end_time );
+	rc |= WriteRecord ( self, end_time - self->time, OP_END, 0 );
+	index_offset = self->offset;
+
+	for ( idx = 0; idx < self->nr_index; idx++ )
+	{
+		PutLE ( &buf[0], self->index[idx].offset, 8 );
+		PutLE ( &buf[8], self->index[idx].time, 8 );
+		PutLE ( &buf[16], self->index[idx].state, 2 );
+		rc |= Write ( self, buf, INDEX_ENTRY_SIZE );
+	}
+
+	PutLE ( &buf[0], index_offset, 8 );
+	PutLE ( &buf[8], end_time, 8 );
+	PutLE ( &buf[16], self->nr_index, 4 );
+	PutLE ( &buf[20], self->bucket_ticks, 4 );
+	memcpy ( &buf[24], FooterMagic, sizeof ( FooterMagic ) );
+	rc |= Write ( self, buf, FOOTER_SIZE );
+	rc |= ( fclose ( self->fp ) != 0 ) ? -1 : 0;
+	free ( self->index );
+	self->fp = NULL;
+	self->index = NULL;
+	return ( rc != 0 ) ? -1 : 0;
+}
+
+/**
+ * @brief     decodes the record at a given offset
+ * @param[in] self points to instance of InputTrace
+ * @param[in] pos of the record
+ * @param[in] time before the record
+ * @param[in] state before the record
+ * @param[out] rec decoded record
+ * @returns   false if the record is truncated or invalid
+ */
+static bool Decode ( const InputTrace * self, size_t pos, uint64_t time, uint16_t state, Record * rec )
+{
+	uint64_t header = 0;
+	uint32_t shift = 0;
+	uint32_t opcode;
+	uint8_t  byte;
+
+	do
+	{
+		if ( ( pos >= self->records_end ) || ( shift > 63u ) )
+		{
+			return false;
+		}
+
+		byte = self->data[pos++];
+		header |= ( uint64_t ) ( byte & 0x7Fu ) << shift;
+		shift += 7u;
+	}
+	while ( ( byte & 0x80u ) != 0 );
+
+	opcode = ( uint32_t ) ( header & ( ( 1u << OP_BITS ) - 1u ) );
+	rec->time = time + ( header >> OP_BITS );
+	rec->state = state;
+	rec->end = false;
+
+	if ( opcode < 16u )
+	{
+		rec->state ^= ( uint16_t ) ( 1u << opcode );
+	}
+	else if ( opcode == OP_FULL_STATE )
+	{
+		if ( ( pos + 2u ) > self->records_end )
+		{
+			return false;
+		}
+
+		rec->state = ( uint16_t ) GetLE ( &self->data[pos], 2 );
+		pos += 2u;
+	}
+	else if ( opcode == OP_END )
+	{
+		rec->end = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	rec->next = pos;
+	return true;
+}
+
+/**
+ * @brief          builds the index of a trace without footer by scanning all records
+ * @param[in, out] self points to instance of InputTrace
+ * @returns        0 on success, -1 on allocation failure
+ */
+static int BuildIndex ( InputTrace * self )
+{
+	InputTraceIndex entry;
+	Record          rec = { 0, 0, 0, false };
+	size_t          cap = 0;
+	size_t          pos = HEADER_SIZE;
+	uint64_t        time = 0;
+	uint16_t        state = 0;
+	self->bucket_ticks = INPUTTRACE_BUCKET_TICKS;
+
+	while ( Decode ( self, pos, time, state, &rec ) )
+	{
+		while ( ( ( uint64_t ) self->nr_index * self->bucket_ticks ) <= rec.time )
+		{
+			entry.offset = pos;
+			entry.time = time;
+			entry.state = state;
+
+			if ( IndexAppend ( &self->index, &self->nr_index, &cap, &entry ) != 0 )
+			{
+				return -1;
+			}
+		}
+
+		if ( rec.end )
+		{
+			time = rec.time;
+			break;
+		}
+
+		pos = rec.next;
+		time = rec.time;
+		state = rec.state;
+	}
+
+	/* a truncated trace ends with its last complete record: */
+	self->end_time = time;
+	self->records_end = ( rec.end ) ? self->records_end : pos;
+	return 0;
+}
+
+/**
+ * @brief          loads the index from the footer
+ * @param[in, out] self points to instance of InputTrace
+ * @returns        0 on success, -1 if the footer is missing or invalid
+ */
+static int LoadIndex ( InputTrace * self )
+{
+	const uint8_t * footer;
+	uint64_t        index_offset;
+	size_t          idx;
+
+	if ( self->size < ( HEADER_SIZE + FOOTER_SIZE ) )
+	{
+		return -1;
+	}
+
+	footer = &self->data[self->size - FOOTER_SIZE];
+	index_offset = GetLE ( &footer[0], 8 );
+	self->nr_index = ( size_t ) GetLE ( &footer[16], 4 );
+	self->bucket_ticks = ( uint32_t ) GetLE ( &footer[20], 4 );
+
+	if ( ( memcmp ( &footer[24], FooterMagic, sizeof ( FooterMagic ) ) != 0 ) || ( self->bucket_ticks == 0 ) ||
+	        ( index_offset < HEADER_SIZE ) || ( ( index_offset + self->nr_index * INDEX_ENTRY_SIZE ) != ( self->size - FOOTER_SIZE ) ) )
+	{
+		self->nr_index = 0;
+		return -1;
+	}
+
+	self->end_time = GetLE ( &footer[8], 8 );
+	self->records_end = ( size_t ) index_offset;
+	self->index = malloc ( ( self->nr_index + 1u ) * sizeof ( InputTraceIndex ) );
+
+	if ( self->index == NULL )
+	{
+		return -1;
+	}
+
+	for ( idx = 0; idx < self->nr_index; idx++ )
+	{
+		const uint8_t * entry = &self->data[index_offset + idx * INDEX_ENTRY_SIZE];
+		self->index[idx].offset = GetLE ( &entry[0], 8 );
+		self->index[idx].time = GetLE ( &entry[8], 8 );
+		self->index[idx].state = ( uint16_t ) GetLE ( &entry[16], 2 );
+	}
+
+	return 0;
+}
+
+int InputTrace_Open ( InputTrace * self, const char * path )
+{
+	struct stat info;
+	void *      map;
+	int         fd;
+	assert ( self != NULL );
+	memset ( self, 0, sizeof ( *self ) );
+	fd = open ( path, O_RDONLY );
+
+	if ( fd < 0 )
+	{
+		return -1;
+	}
+
+	if ( ( fstat ( fd, &info ) != 0 ) || ( info.st_size < ( off_t ) HEADER_SIZE ) )
+	{
+		close ( fd );
+		return -1;
+	}
+
+	map = mmap ( NULL, ( size_t ) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close ( fd );
+
+	if ( map == MAP_FAILED )
+	{
+		return -1;
+	}
+
+	self->data = map;
+	self->size = ( size_t ) info.st_size;
+
+	if ( ( memcmp ( self->data, HeaderMagic, sizeof ( HeaderMagic ) ) != 0 ) || ( self->data[4] != INPUTTRACE_VERSION ) )
+	{
+		InputTrace_Close ( self );
+		return -1;
+	}
+
+	self->tick_us = ( uint32_t ) GetLE ( &self->data[8], 4 );
+	self->frame_ticks = ( uint32_t ) GetLE ( &self->data[12], 4 );
+
+	if ( LoadIndex ( self ) != 0 )
+	{
+		self->records_end = self->size;
+
+		if ( BuildIndex ( self ) != 0 )
+		{
+			InputTrace_Close ( self );
+			return -1;
+		}
+	}
+
+	InputTrace_Rewind ( self );
+	return 0;
+}
+
+void InputTrace_Close ( InputTrace * self )
+{
+	assert ( self != NULL );
+
+	if ( self->data != NULL )
+	{
+		munmap ( ( void * ) self->data, self->size );
+	}
+
+	free ( self->index );
+	memset ( self, 0, sizeof ( *self ) );
+}
+
+void InputTrace_Rewind ( InputTrace * self )
+{
+	assert ( self != NULL );
+	self->pos = HEADER_SIZE;
+	self->time = 0;
+	self->state = 0;
+}
+
+uint16_t InputTrace_StateAt ( InputTrace * self, uint64_t time )
+{
+	Record rec;
+	size_t bucket;
+	assert ( self != NULL );
+
+	if ( self->nr_index > 0 )
+	{
+		bucket = ( size_t ) ( time / self->bucket_ticks );
+		bucket = ( bucket < self->nr_index ) ? bucket : ( self->nr_index - 1u );
+
+		/* seek backwards or skip ahead of the cursor: */
+		if ( ( time < self->time ) || ( self->index[bucket].offset > self->pos ) )
+		{
+			self->pos = ( size_t ) self->index[bucket].offset;
+			self->time = self->index[bucket].time;
+			self->state = self->index[bucket].state;
+		}
+	}
+	else if ( time < self->time )
+	{
+		InputTrace_Rewind ( self );
+	}
+
+	while ( Decode ( self, self->pos, self->time, self->state, &rec ) && ( rec.end == false ) && ( rec.time <= time ) )
+	{
+		self->pos = rec.next;
+		self->time = rec.time;
+		self->state = rec.state;
+	}
+
+	return self->state;
+}
+
+bool InputTrace_NextChange ( InputTrace * self, uint64_t * time, uint16_t * state )
+{
+	Record rec;
+	assert ( self != NULL );
+
+	if ( !Decode ( self, self->pos, self->time, self->state, &rec ) || rec.end )
+	{
+		return false;
+	}
+
+	self->pos = rec.next;
+	self->time = rec.time;
+	self->state = rec.state;
+	*time = rec.time;
+	*state = rec.state;
+	return true;
+}
+
+void InputTrace_GetInfo ( const InputTrace * self, uint32_t * tick_us, uint32_t * frame_ticks, uint64_t * end_time )
+{
+	assert ( self != NULL );
+	*tick_us = self->tick_us;
+	*frame_ticks = self->frame_ticks;
+	*end_time = self->end_time;
+}
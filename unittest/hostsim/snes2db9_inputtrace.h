@@ -0,0 +1,181 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_inputtrace.h
+ * @brief   API of the compact binary SNES input trace format
+ * @details A trace stores the SNES gamepad state bitcoded according to SNES_BTNMASK_xxx over time.
+ *          Only changes are stored, so unchanged frames cost nothing (run length encoding).
+ *          Each change is a LEB128 varint of the time delta and an opcode:
+ *          - opcodes 0..15 toggle a single button bit
+ *          - opcode 16 is followed by the complete state in 2 bytes (little endian)
+ *          - opcode 31 terminates the trace at the end time
+ *
+ *          A typical press and release costs 4 bytes. The file ends with an index of fixed time
+ *          buckets which allows to seek to any timestamp in O(1). Traces without index, e.g. from
+ *          an interrupted recording, are indexed while opening.
+ *
+ *          File layout (all values little endian):
+ *          - header: "S2DT", version, 3 reserved bytes, tick_us (u32), frame_ticks (u32)
+ *          - records
+ *          - index entries: offset (u64), time (u64), state (u16)
+ *          - footer: index offset (u64), end time (u64), number of entries (u32), bucket_ticks (u32), "S2DI"
+ *
+ */
+
+/**
+ * @addtogroup SNES2DB9_Simulator
+ * @{
+ */
+
+#ifndef SNES2DB9_INPUTTRACE_H
+#define SNES2DB9_INPUTTRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define INPUTTRACE_VERSION       1u      /**< format version written */
+#define INPUTTRACE_BUCKET_TICKS  10000u  /**< time span covered by an index entry, bounds the records decoded per seek */
+
+/**
+ * @brief   index entry, decoder state at the start of a time bucket
+ */
+typedef struct
+{
+	uint64_t offset;  /**< file offset of the first record at or after the bucket start */
+	uint64_t time;    /**< time of the state in ticks */
+	uint16_t state;   /**< state valid at the bucket start */
+} InputTraceIndex;
+
+/**
+ * @brief   incremental trace writer
+ * @details All members shall be considered private. Access should be routed through the InputTraceWriter_... functions
+ */
+typedef struct
+{
+	FILE *            fp;            /**< output stream */
+	uint32_t          tick_us;       /**< time unit */
+	uint32_t          frame_ticks;   /**< SNES polling period */
+	uint32_t          bucket_ticks;  /**< time span per index entry */
+	uint64_t          offset;        /**< current file offset */
+	uint64_t          time;          /**< time of the last change */
+	uint16_t          state;         /**< current state */
+	InputTraceIndex * index;         /**< index built while writing */
+	size_t            nr_index;      /**< number of index entries */
+	size_t            cap_index;     /**< allocated index entries */
+} InputTraceWriter;
+
+/**
+ * @brief   memory mapped trace reader with cursor
+ * @details All members shall be considered private. Access should be routed through the InputTrace_... functions
+ */
+typedef struct
+{
+	const uint8_t *   data;          /**< mapped file */
+	size_t            size;          /**< size of the mapping */
+	size_t            records_end;   /**< end of the record section */
+	uint32_t          tick_us;       /**< time unit */
+	uint32_t          frame_ticks;   /**< SNES polling period */
+	uint32_t          bucket_ticks;  /**< time span per index entry */
+	uint64_t          end_time;      /**< time of the end record */
+	InputTraceIndex * index;         /**< index loaded from the footer or built while opening */
+	size_t            nr_index;      /**< number of index entries */
+	size_t            pos;           /**< cursor: offset of the next record */
+	uint64_t          time;          /**< cursor: time of the current state */
+	uint16_t          state;         /**< cursor: current state */
+} InputTrace;
+
+/**
+ * @brief          creates a trace file
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      path of the file
+ * @param[in]      tick_us is the time unit of the trace in us
+ * @param[in]      frame_ticks is the SNES polling period in ticks used for replay
+ * @returns        0 on success, -1 on error
+ */
+int  InputTraceWriter_Open ( InputTraceWriter * self, const char * path, uint32_t tick_us, uint32_t frame_ticks );
+
+/**
+ * @brief          appends a state
+ * @details        Times must not decrease. Unchanged states are not stored.
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      time in ticks
+ * @param[in]      state bitcoded according to SNES_BTNMASK_xxx
+ * @returns        0 on success, -1 on error
+ */
+int  InputTraceWriter_Add ( InputTraceWriter * self, uint64_t time, uint16_t state );
+
+/**
+ * @brief          terminates the trace, writes the index and closes the file
+ * @param[in, out] self points to instance of InputTraceWriter
+ * @param[in]      end_time of the trace in ticks, not before the last change
+ * @returns        0 on success, -1 on error
+ */
+int  InputTraceWriter_Close ( InputTraceWriter * self, uint64_t end_time );
+
+/**
+ * @brief          opens a trace file for reading
+ * @param[in, out] self points to instance of InputTrace
+ * @param[in]      path of the file
+ * @returns        0 on success, -1 on error
+ */
+int  InputTrace_Open ( InputTrace * self, const char * path );
+
+/**
+ * @brief          closes a trace file
+ * @param[in, out] self points to instance of InputTrace
+ */
+void InputTrace_Close ( InputTrace * self );
+
+/**
+ * @brief          returns the state at a given time
+ * @details        Seeks through the index in O(1) and decodes at most one bucket.
+ *                 Monotonic accesses continue from the cursor without seeking.
+ * @param[in, out] self points to instance of InputTrace
+ * @param[in]      time in ticks
+ * @returns        state bitcoded according to SNES_BTNMASK_xxx
+ */
+uint16_t InputTrace_StateAt ( InputTrace * self, uint64_t time );
+
+/**
+ * @brief          iterates over the changes following the cursor
+ * @param[in, out] self points to instance of InputTrace
+ * @param[out]     time of the change in ticks
+ * @param[out]     state after the change
+ * @returns        true if a change was read, false at the end of the trace
+ */
+bool InputTrace_NextChange ( InputTrace * self, uint64_t * time, uint16_t * state );
+
+/**
+ * @brief      returns the header information of a trace
+ * @param[in]  self points to instance of InputTrace
+ * @param[out] tick_us is the time unit of the trace in us
+ * @param[out] frame_ticks is the SNES polling period in ticks
+ * @param[out] end_time of the trace in ticks
+ */
+void InputTrace_GetInfo ( const InputTrace * self, uint32_t * tick_us, uint32_t * frame_ticks, uint64_t * end_time );
+
+/**
+ * @brief          moves the cursor to the start of the trace
+ * @param[in, out] self points to instance of InputTrace
+ */
+void InputTrace_Rewind ( InputTrace * self );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @} */
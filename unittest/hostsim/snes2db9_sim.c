@@ -0,0 +1,670 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_sim.c
+ * @brief   implements the host side simulator of the complete converter pipeline
+ * @details The simulation is event driven with a resolution of 1ns:
+ *          - a timer tick advances the SNESScheduler exactly like the ATtiny84 ISR
+ *          - the main loop dispatches ReaderTask() and DB9UpdateTask() through the SNESScheduler,
+ *            ticks arriving while the loop is busy are processed late and counted as on the real target
+ *          - every HAL call advances the simulated time by SimConfig.hal_call_ns
+ *          - the virtual gamepad models a 4021 shift register with propagation delay
+ *          - the emulated host samples the DB9 pins at a fixed rate
+ *          - latency probe markers are emitted like the ATtiny84 latency probe, pulses take simulated time
+ *
+ * @note    The core HAL has no context pointer, so only one simulation may run per process at a time.
+ *
+ */
+
+/**
+ * @addtogroup SNES2DB9_Simulator
+ * @{
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+#include "snes2db9_sim.h"
+
+#define SIM_TIME_INFINITE  UINT64_MAX   /**< marks an event that is not scheduled */
+#define NS_PER_MS          1000000u     /**< conversion factor */
+#define TIMER_COUNTS_PER_TICK 100u      /**< timer counts per tick, Timer0 counts to OCR0A = 99 on ATtiny84 */
+
+/**
+ * @brief internal state of the virtual gamepad and the virtual DB9 port
+ */
+typedef struct
+{
+	const SimConfig * cfg;                       /**< active configuration */
+	uint64_t          now;                       /**< current simulated time in ns */
+	uint32_t          rng;                       /**< random generator state */
+	/* virtual gamepad: */
+	uint16_t          buttons;                   /**< pad inputs, bitcoded according to SNES_BTNMASK_xxx */
+	uint16_t          latched_buttons;           /**< pad inputs at last latch */
+	uint16_t          padreg;                    /**< shift register, a set MSB pulls DATA low */
+	SNES2DB9_Pinstate latch;                     /**< LATCH level driven by the reader */
+	SNES2DB9_Pinstate clk;                       /**< CLK level driven by the reader */
+	SNES2DB9_Pinstate data;                      /**< DATA level after propagation */
+	SNES2DB9_Pinstate data_prev;                 /**< DATA level before the last change */
+	uint64_t          data_valid_at;             /**< time the DATA level becomes valid */
+	/* virtual DB9 port: */
+	SNES2DB9_Pinstate db9[DB9_FIRE + 1];         /**< current DB9 pin levels */
+	SNES2DB9_Pinstate db9_prev[DB9_FIRE + 1];    /**< DB9 pin levels before the last change */
+	uint64_t          db9_change[DB9_FIRE + 1];  /**< time of the last change per pin */
+	/* current press under observation: */
+	bool              press_active;              /**< a press is being observed */
+	uint8_t           press_db9_mask;            /**< expected DB9 pins, DB9_BTNMASK_xxx */
+	uint64_t          press_time;                /**< time of the press */
+	bool              press_pin_seen;            /**< press was visible on the DB9 pins */
+	bool              press_host_seen;           /**< press was sampled by the host */
+	SimResult *       result;                    /**< result under construction */
+	/* converter firmware: */
+	SNESReader        reader;                    /**< reader instance */
+	SNESMapper        mapper;                    /**< mapper instance */
+	SNESScheduler     scheduler;                 /**< scheduler instance dispatching the tasks */
+	SNESTask          tasks[2];                  /**< task table as in main.c */
+	uint16_t          gamepad_state;             /**< last reader result */
+	uint16_t          db9_update_ms;             /**< DB9 update period */
+	bool              latched;                   /**< a reading has been started */
+	uint8_t           probe_db9_state;           /**< DB9 state at the last output marker */
+} SimState;
+
+static SimState Sim;  /**< the single simulation instance */
+
+/**
+ * @brief   maps DB9_BTNMASK_xxx bit positions to DB9 pins
+ */
+static const SNES2DB9_Pin Db9Pins[8] =
+{
+	DB9_UP, DB9_DOWN, DB9_LEFT, DB9_RIGHT, DB9_FIRE, DB9_FIRE, DB9_FIRE, DB9_FIRE
+};
+
+/**
+ * @brief     xorshift32 random generator
+ * @returns   next random value
+ */
+static uint32_t Random ( void )
+{
+	uint32_t x = Sim.rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	Sim.rng = x;
+	return x;
+}
+
+/**
+ * @brief     random value in given inclusive range
+ * @param[in] min of range
+ * @param[in] max of range
+ * @returns   random value
+ */
+static uint32_t RandomRange ( uint32_t min, uint32_t max )
+{
+	return ( max <= min ) ? min : ( min + ( Random() % ( max - min + 1 ) ) );
+}
+
+/**
+ * @brief     DB9 pin level at given time
+ * @details   Valid for times after the second to last change of the pin.
+ * @param[in] pin to evaluate
+ * @param[in] time_ns to evaluate
+ * @returns   pin level
+ */
+static SNES2DB9_Pinstate Db9LevelAt ( SNES2DB9_Pin pin, uint64_t time_ns )
+{
+	return ( time_ns >= Sim.db9_change[pin] ) ? Sim.db9[pin] : Sim.db9_prev[pin];
+}
+
+/**
+ * @brief     checks if all expected DB9 pins of the observed press are active at given time
+ * @param[in] time_ns to evaluate
+ * @returns   true if the press is visible
+ */
+static bool PressVisibleAt ( uint64_t time_ns )
+{
+	uint8_t bit;
+
+	for ( bit = 0; bit < 8; bit++ )
+	{
+		if ( ( ( Sim.press_db9_mask & ( 1u << bit ) ) != 0 ) &&
+		        ( Db9LevelAt ( Db9Pins[bit], time_ns ) != SNES2DB9_PIN_LOW ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief     appends a latency value to a result array
+ * @param[in, out] array to extend
+ * @param[in, out] nr_entries in array
+ * @param[in] value_us to append
+ */
+static void AppendLatency ( uint32_t ** array, uint32_t * nr_entries, uint32_t value_us )
+{
+	uint32_t * grown = realloc ( *array, ( *nr_entries + 1 ) * sizeof ( uint32_t ) );
+
+	if ( grown != NULL )
+	{
+		*array = grown;
+		grown[*nr_entries] = value_us;
+		( *nr_entries )++;
+	}
+}
+
+/**
+ * @brief internal helper to present the shift register output on DATA after the propagation delay
+ */
+static void PadUpdateData ( void )
+{
+	SNES2DB9_Pinstate level = ( ( Sim.padreg & 0x8000u ) != 0 ) ? SNES2DB9_PIN_LOW : SNES2DB9_PIN_HIGH;
+
+	if ( level != Sim.data )
+	{
+		Sim.data_prev = ( Sim.now >= Sim.data_valid_at ) ? Sim.data : Sim.data_prev;
+		Sim.data = level;
+		Sim.data_valid_at = Sim.now + Sim.cfg->pad_delay_ns;
+	}
+}
+
+/**
+ * @brief internal helper to load the parallel pad inputs into the shift register
+ */
+static void PadLoad ( void )
+{
+	Sim.padreg = Sim.buttons;
+	Sim.latched_buttons = Sim.buttons;
+	PadUpdateData();
+}
+
+/**
+ * @brief     outputs a latency probe marker as burst of pulses, see ProbeMark() of the ATtiny84 implementation
+ * @param[in] marker according to SNES2DB9_PROBE_xxx, number of pulses
+ */
+static void SimProbe ( uint8_t marker )
+{
+	uint8_t pulses;
+
+	if ( ( Sim.cfg->probe_markers & SNES2DB9_PROBE_MASK ( marker ) ) == 0 )
+	{
+		return;
+	}
+
+	for ( pulses = marker; pulses > 0; pulses-- )
+	{
+		if ( Sim.cfg->probe_observer != NULL )
+		{
+			Sim.cfg->probe_observer ( Sim.cfg->observer_ctx, Sim.now, true );
+		}
+
+		Sim.now += Sim.cfg->probe_pulse_ns;
+
+		if ( Sim.cfg->probe_observer != NULL )
+		{
+			Sim.cfg->probe_observer ( Sim.cfg->observer_ctx, Sim.now, false );
+		}
+
+		Sim.now += Sim.cfg->probe_pulse_ns;
+	}
+}
+
+/**
+ * @brief     simulated HAL function to set pins, see SNES2DB9_SetPinFunc
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+static void SimSetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	Sim.now += Sim.cfg->hal_call_ns;
+
+	if ( Sim.cfg->pin_observer != NULL )
+	{
+		Sim.cfg->pin_observer ( Sim.cfg->observer_ctx, Sim.now, pin, state, false );
+	}
+
+	switch ( pin )
+	{
+		case SNES_LATCH:
+			Sim.latch = state;
+
+			if ( state == SNES2DB9_PIN_HIGH )
+			{
+				PadLoad();
+				SimProbe ( SNES2DB9_PROBE_LATCH );
+			}
+
+			break;
+
+		case SNES_CLK:
+
+			/* 4021 shifts on the rising clock edge, serial input is tied to ground: */
+			if ( ( Sim.latch != SNES2DB9_PIN_HIGH ) && ( Sim.clk == SNES2DB9_PIN_LOW ) && ( state == SNES2DB9_PIN_HIGH ) )
+			{
+				Sim.padreg = ( uint16_t ) ( ( Sim.padreg << 1 ) | 1u );
+				PadUpdateData();
+			}
+
+			Sim.clk = state;
+			break;
+
+		case SNES_DATA:
+			break;
+
+		case DB9_UP:
+		case DB9_DOWN:
+		case DB9_LEFT:
+		case DB9_RIGHT:
+		case DB9_FIRE:
+			if ( state != Sim.db9[pin] )
+			{
+				Sim.db9_prev[pin] = Sim.db9[pin];
+				Sim.db9[pin] = state;
+				Sim.db9_change[pin] = Sim.now;
+			}
+
+			if ( ( Sim.press_active == true ) && ( Sim.press_pin_seen == false ) && ( PressVisibleAt ( Sim.now ) == true ) )
+			{
+				Sim.press_pin_seen = true;
+				AppendLatency ( &Sim.result->pin_latency_us, &Sim.result->nr_pin_latency,
+				                ( uint32_t ) ( ( Sim.now - Sim.press_time ) / 1000u ) );
+			}
+
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief     simulated HAL function to read pins, see SNES2DB9_ReadPinFunc
+ * @param[in] pin to read
+ * @returns   pin level
+ */
+static SNES2DB9_Pinstate SimReadPin ( SNES2DB9_Pin pin )
+{
+	SNES2DB9_Pinstate level = SNES2DB9_PIN_HIGH;
+	Sim.now += Sim.cfg->hal_call_ns;
+
+	if ( pin == SNES_DATA )
+	{
+		level = ( Sim.now >= Sim.data_valid_at ) ? Sim.data : Sim.data_prev;
+	}
+
+	if ( Sim.cfg->pin_observer != NULL )
+	{
+		Sim.cfg->pin_observer ( Sim.cfg->observer_ctx, Sim.now, pin, level, true );
+	}
+
+	return level;
+}
+
+/**
+ * @brief     finalizes the statistics of the observed press
+ */
+static void ClosePress ( void )
+{
+	if ( Sim.press_active == true )
+	{
+		Sim.result->nr_presses++;
+
+		if ( Sim.press_pin_seen == false )
+		{
+			Sim.result->nr_missed_pin++;
+		}
+
+		if ( Sim.press_host_seen == false )
+		{
+			Sim.result->nr_missed_host++;
+		}
+	}
+
+	Sim.press_active = false;
+}
+
+/**
+ * @brief     applies a new gamepad input state
+ * @param[in] buttons bitcoded according to SNES_BTNMASK_xxx
+ */
+static void SetButtons ( uint16_t buttons )
+{
+	Sim.buttons = buttons;
+
+	if ( Sim.latch == SNES2DB9_PIN_HIGH )
+	{
+		PadLoad();
+	}
+
+	if ( Sim.cfg->input_observer != NULL )
+	{
+		Sim.cfg->input_observer ( Sim.cfg->observer_ctx, Sim.now, buttons );
+	}
+}
+
+/**
+ * @brief   ReaderTask() of the ATtiny84 implementation
+ */
+static void SimReaderTask ( void )
+{
+	bool was_idle = SNESReader_IsIdle ( &Sim.reader );
+	Sim.gamepad_state = SNESReader_Update ( &Sim.reader );
+
+	if ( ( was_idle == false ) && ( SNESReader_IsIdle ( &Sim.reader ) == true ) )
+	{
+		SimProbe ( SNES2DB9_PROBE_UPDATE );
+	}
+}
+
+/**
+ * @brief   DB9UpdateTask() of the ATtiny84 implementation, checks the completed reading
+ */
+static void SimDB9UpdateTask ( void )
+{
+	uint8_t db9_state;
+
+	if ( Sim.latched == true )
+	{
+		Sim.result->nr_reads++;
+
+		if ( Sim.gamepad_state != Sim.latched_buttons )
+		{
+			Sim.result->nr_bad_reads++;
+		}
+	}
+
+	db9_state = SNESMapper_Update ( &Sim.mapper, Sim.gamepad_state, Sim.db9_update_ms );
+	DB9_SetPins ( db9_state, SimSetPin );
+
+	if ( db9_state != Sim.probe_db9_state )
+	{
+		Sim.probe_db9_state = db9_state;
+		SimProbe ( SNES2DB9_PROBE_OUTPUT );
+	}
+
+	SNESReader_BeginRead ( &Sim.reader );
+	Sim.latched = true;
+}
+
+void Sim_DefaultConfig ( SimConfig * config )
+{
+	assert ( config != NULL );
+	memset ( config, 0, sizeof ( SimConfig ) );
+	config->tick_ns = 200000u;
+	config->db9_update_ticks = 80u;
+	config->host_rate_hz = 50u;
+	/* roughly 40 cycles per SetPin() at 4MHz: */
+	config->hal_call_ns = 10000u;
+	config->task_overhead_ns = 5000u;
+	config->loop_jitter_ns = 0u;
+	config->pad_delay_ns = 300u;
+	config->nr_presses = 1000u;
+	config->min_press_ms = 20u;
+	config->max_press_ms = 200u;
+	config->min_gap_ms = 50u;
+	config->max_gap_ms = 300u;
+	config->seed = 1u;
+	config->masks.fire_mask = SNES_BTNMASK_B;
+	config->masks.jump_mask = SNES_BTNMASK_A;
+	config->masks.autofire_mask = SNES_BTNMASK_Y;
+	config->autofire_ms = 16u;
+	config->probe_markers = 0u;
+	config->probe_pulse_ns = 2000u;
+}
+
+int Sim_Run ( const SimConfig * config, SimResult * result )
+{
+	static const uint16_t candidates[] =
+	{
+		SNES_BTNMASK_B, SNES_BTNMASK_Y, SNES_BTNMASK_Select, SNES_BTNMASK_Start,
+		SNES_BTNMASK_Up, SNES_BTNMASK_Down, SNES_BTNMASK_Left, SNES_BTNMASK_Right,
+		SNES_BTNMASK_A, SNES_BTNMASK_X, SNES_BTNMASK_L, SNES_BTNMASK_R
+	};
+	uint16_t   press_buttons[sizeof ( candidates ) / sizeof ( candidates[0] )];
+	uint8_t    press_masks[sizeof ( candidates ) / sizeof ( candidates[0] )];
+	uint8_t    nr_candidates = 0;
+	uint8_t    idx;
+	SNESMapper probe;
+	uint64_t   busy_until = 0;
+	uint64_t   next_tick;
+	uint64_t   next_sample;
+	uint64_t   next_input;
+	uint64_t   next_loop;
+	uint64_t   end_time = SIM_TIME_INFINITE;
+	uint64_t   sample_period;
+	uint64_t   t;
+	uint32_t   presses_started = 0;
+	bool       pressed = false;
+
+	if ( ( config == NULL ) || ( result == NULL ) || ( config->tick_ns == 0 ) ||
+	        ( config->db9_update_ticks == 0 ) || ( config->host_rate_hz == 0 ) )
+	{
+		return -1;
+	}
+
+	memset ( result, 0, sizeof ( SimResult ) );
+	memset ( &Sim, 0, sizeof ( Sim ) );
+	Sim.cfg = config;
+	Sim.result = result;
+	Sim.rng = ( config->seed != 0 ) ? config->seed : 1u;
+	Sim.latch = SNES2DB9_PIN_LOW;
+	Sim.clk = SNES2DB9_PIN_HIGH;
+	Sim.data = SNES2DB9_PIN_HIGH;
+	Sim.data_prev = SNES2DB9_PIN_HIGH;
+
+	for ( idx = DB9_UP; idx <= DB9_FIRE; idx++ )
+	{
+		Sim.db9[idx] = SNES2DB9_PIN_HIGHZ;
+		Sim.db9_prev[idx] = SNES2DB9_PIN_HIGHZ;
+	}
+
+	/* select stimuli visible on DB9 without autofire: */
+	SNESMapper_Init ( &probe, ( SNESMapperButtonMasks * ) &config->masks );
+	SNESMapper_SetAutofireDuration ( &probe, 0 );
+
+	for ( idx = 0; idx < ( sizeof ( candidates ) / sizeof ( candidates[0] ) ); idx++ )
+	{
+		uint8_t mask = SNESMapper_Update ( &probe, candidates[idx], 0 );
+
+		if ( ( mask != 0 ) && ( ( candidates[idx] & config->masks.autofire_mask ) == 0 ) )
+		{
+			press_buttons[nr_candidates] = candidates[idx];
+			press_masks[nr_candidates] = mask;
+			nr_candidates++;
+		}
+	}
+
+	if ( nr_candidates == 0 )
+	{
+		return -1;
+	}
+
+	/* same initialization as InitAppl() of the ATtiny84 implementation: */
+	Sim.db9_update_ms = ( uint16_t ) ( ( ( uint64_t ) config->db9_update_ticks * config->tick_ns ) / NS_PER_MS );
+	SNESMapper_Init ( &Sim.mapper, ( SNESMapperButtonMasks * ) &config->masks );
+	SNESMapper_SetAutofireDuration ( &Sim.mapper, config->autofire_ms );
+	SNESReader_Init ( &Sim.reader, SimSetPin, SimReadPin );
+	Sim.tasks[0].func = SimReaderTask;
+	Sim.tasks[0].period_ticks = 1u;
+	Sim.tasks[1].func = SimDB9UpdateTask;
+	Sim.tasks[1].period_ticks = config->db9_update_ticks;
+	SNESScheduler_Init ( &Sim.scheduler, Sim.tasks, 2u );
+	Sim.now = 0;
+	sample_period = 1000000000ull / config->host_rate_hz;
+	next_tick = config->tick_ns;
+	next_sample = RandomRange ( 0, ( uint32_t ) sample_period );
+	next_input = ( uint64_t ) RandomRange ( config->min_gap_ms, config->max_gap_ms ) * NS_PER_MS;
+	next_loop = SIM_TIME_INFINITE;
+
+	for ( ;; )
+	{
+		t = next_tick;
+
+		if ( next_sample < t )
+		{
+			t = next_sample;
+		}
+
+		if ( next_input < t )
+		{
+			t = next_input;
+		}
+
+		if ( next_loop < t )
+		{
+			t = next_loop;
+		}
+
+		if ( t >= end_time )
+		{
+			break;
+		}
+
+		if ( t == next_input )
+		{
+			/* gamepad stimulus: */
+			Sim.now = t;
+
+			if ( pressed == true )
+			{
+				pressed = false;
+				SetButtons ( 0 );
+
+				if ( presses_started >= config->nr_presses )
+				{
+					next_input = SIM_TIME_INFINITE;
+					end_time = t + ( 4u * sample_period ) + ( 2ull * config->db9_update_ticks * config->tick_ns );
+				}
+				else
+				{
+					next_input = t + ( uint64_t ) RandomRange ( config->min_gap_ms, config->max_gap_ms ) * NS_PER_MS;
+				}
+			}
+			else
+			{
+				ClosePress();
+				idx = ( uint8_t ) ( Random() % nr_candidates );
+				pressed = true;
+				presses_started++;
+				Sim.press_active = true;
+				Sim.press_db9_mask = press_masks[idx];
+				Sim.press_time = t;
+				Sim.press_pin_seen = false;
+				Sim.press_host_seen = false;
+				SetButtons ( press_buttons[idx] );
+				next_input = t + ( uint64_t ) RandomRange ( config->min_press_ms, config->max_press_ms ) * NS_PER_MS;
+			}
+		}
+		else if ( t == next_sample )
+		{
+			/* emulated host reads the joystick port: */
+			if ( ( Sim.press_active == true ) && ( Sim.press_host_seen == false ) &&
+			        ( t >= Sim.press_time ) && ( PressVisibleAt ( t ) == true ) )
+			{
+				Sim.press_host_seen = true;
+				AppendLatency ( &result->host_latency_us, &result->nr_host_latency, ( uint32_t ) ( ( t - Sim.press_time ) / 1000u ) );
+			}
+
+			next_sample += sample_period;
+		}
+		else if ( t == next_tick )
+		{
+			/* timer ISR: */
+			result->nr_ticks++;
+			SNESScheduler_Tick ( &Sim.scheduler );
+			next_tick += config->tick_ns;
+
+			if ( next_loop == SIM_TIME_INFINITE )
+			{
+				next_loop = ( busy_until > t ) ? busy_until : t;
+			}
+		}
+		else
+		{
+			/* main loop iteration, continues until the scheduler is idle: */
+			Sim.now = t + config->task_overhead_ns;
+
+			if ( SNESScheduler_Dispatch ( &Sim.scheduler ) == true )
+			{
+				uint64_t iteration_ns;
+				busy_until = Sim.now + RandomRange ( 0, config->loop_jitter_ns );
+				iteration_ns = busy_until - t;
+				result->max_iteration_ns = ( iteration_ns > result->max_iteration_ns ) ? iteration_ns : result->max_iteration_ns;
+				SNESScheduler_ReportIteration ( &Sim.scheduler,
+				                                ( uint16_t ) ( ( iteration_ns * TIMER_COUNTS_PER_TICK ) / config->tick_ns ) );
+				next_loop = busy_until;
+			}
+			else
+			{
+				next_loop = SIM_TIME_INFINITE;
+			}
+		}
+	}
+
+	ClosePress();
+	SNESScheduler_GetStats ( &Sim.scheduler, &result->timing );
+	result->duration_ns = end_time;
+	return 0;
+}
+
+void SimResult_Free ( SimResult * result )
+{
+	assert ( result != NULL );
+	free ( result->pin_latency_us );
+	free ( result->host_latency_us );
+	result->pin_latency_us = NULL;
+	result->host_latency_us = NULL;
+	result->nr_pin_latency = 0;
+	result->nr_host_latency = 0;
+}
+
+/**
+ * @brief     comparison function for qsort()
+ * @param[in] a first value
+ * @param[in] b second value
+ * @returns   ordering of a and b
+ */
+static int CompareU32 ( const void * a, const void * b )
+{
+	uint32_t va = *( const uint32_t * ) a;
+	uint32_t vb = *( const uint32_t * ) b;
+	return ( va > vb ) - ( va < vb );
+}
+
+void Sim_ComputeStats ( uint32_t * values, uint32_t nr_values, SimStats * stats )
+{
+	uint32_t idx;
+	double   sum = 0.0;
+	assert ( stats != NULL );
+	memset ( stats, 0, sizeof ( SimStats ) );
+
+	if ( ( values == NULL ) || ( nr_values == 0 ) )
+	{
+		return;
+	}
+
+	qsort ( values, nr_values, sizeof ( uint32_t ), CompareU32 );
+
+	for ( idx = 0; idx < nr_values; idx++ )
+	{
+		sum += values[idx];
+	}
+
+	stats->min = values[0];
+	stats->median = values[nr_values / 2];
+	stats->p99 = values[ ( uint32_t ) ( ( ( uint64_t ) nr_values * 99u ) / 100u ) ];
+	stats->max = values[nr_values - 1];
+	stats->mean = sum / nr_values;
+}
+
+/** @} */
@@ -0,0 +1,157 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_sim.h
+ * @brief   API of the host side simulator of the complete converter pipeline
+ * @details The simulator runs the common core with the task timing of the ATtiny84 implementation
+ *          against a virtual SNES gamepad and a virtual DB9 port sampled by an emulated host.
+ *
+ */
+
+/**
+ * @addtogroup SNES2DB9_Simulator
+ * @{
+ */
+
+#ifndef SNES2DB9_SIM_H
+#define SNES2DB9_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "snes2db9.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief     prototype for observers of simulated pin activity
+ * @param[in] ctx is the observer context given in SimConfig
+ * @param[in] time_ns is the simulated time of the pin access
+ * @param[in] pin accessed
+ * @param[in] state set or read
+ * @param[in] is_read distinguishes reads from writes
+ */
+typedef void ( *SimPinObserver ) ( void * ctx, uint64_t time_ns, SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read );
+
+/**
+ * @brief   prototype for observers of simulated SNES gamepad input changes
+ * @param[in] ctx is the observer context given in SimConfig
+ * @param[in] time_ns is the simulated time of the change
+ * @param[in] snes_pin_mask is the new button state bitcoded according to SNES_BTNMASK_xxx (active high)
+ */
+typedef void ( *SimInputObserver ) ( void * ctx, uint64_t time_ns, uint16_t snes_pin_mask );
+
+/**
+ * @brief     prototype for observers of the simulated latency probe pin
+ * @param[in] ctx is the observer context given in SimConfig
+ * @param[in] time_ns is the simulated time of the edge
+ * @param[in] level of the probe pin after the edge
+ */
+typedef void ( *SimProbeObserver ) ( void * ctx, uint64_t time_ns, bool level );
+
+/**
+ * @brief   configuration of a simulation run
+ * @details Use Sim_DefaultConfig() to obtain the timing of the ATtiny84 implementation.
+ */
+typedef struct
+{
+	uint32_t              tick_ns;              /**< timer tick period, 200µs on ATtiny84 */
+	uint16_t              db9_update_ticks;     /**< number of ticks between DB9 updates */
+	uint16_t              host_rate_hz;         /**< DB9 sampling rate of the emulated host, usually 50 or 60 */
+	uint32_t              hal_call_ns;          /**< execution time of a single hardware abstraction call */
+	uint32_t              task_overhead_ns;     /**< execution time of the main loop and task dispatch excluding HAL calls */
+	uint32_t              loop_jitter_ns;       /**< maximum random extra busy time per main loop iteration, models additional workload */
+	uint32_t              pad_delay_ns;         /**< DATA propagation delay of the gamepad shift register after LATCH/CLK edges */
+	uint32_t              nr_presses;           /**< number of random single button presses to simulate */
+	uint16_t              min_press_ms;         /**< minimum press duration */
+	uint16_t              max_press_ms;         /**< maximum press duration */
+	uint16_t              min_gap_ms;           /**< minimum pause between presses */
+	uint16_t              max_gap_ms;           /**< maximum pause between presses */
+	uint32_t              seed;                 /**< random seed, runs are reproducible for equal seeds */
+	SNESMapperButtonMasks masks;                /**< mapper configuration */
+	uint16_t              autofire_ms;          /**< mapper autofire cycle time */
+	SimPinObserver        pin_observer;         /**< optional observer of all HAL calls, may be NULL */
+	SimInputObserver      input_observer;       /**< optional observer of all gamepad input changes, may be NULL */
+	uint8_t               probe_markers;        /**< latency probe markers to emit, composed of SNES2DB9_PROBE_MASK() bits */
+	uint32_t              probe_pulse_ns;       /**< width of a probe pulse and of the pause after it */
+	SimProbeObserver      probe_observer;       /**< optional observer of the latency probe pin, may be NULL */
+	void *                observer_ctx;         /**< context passed to the observers */
+} SimConfig;
+
+/**
+ * @brief   results of a simulation run
+ * @details Latency arrays are allocated by Sim_Run() and released by SimResult_Free().
+ */
+typedef struct
+{
+	uint32_t   nr_presses;         /**< number of presses simulated */
+	uint32_t   nr_missed_pin;      /**< presses never visible on the DB9 pins */
+	uint32_t   nr_missed_host;     /**< presses never sampled by the host */
+	uint32_t * pin_latency_us;     /**< press to DB9 pin latency per detected press */
+	uint32_t   nr_pin_latency;     /**< number of entries in pin_latency_us */
+	uint32_t * host_latency_us;    /**< press to host sample latency per detected press */
+	uint32_t   nr_host_latency;    /**< number of entries in host_latency_us */
+	uint64_t   nr_ticks;           /**< number of timer ticks simulated */
+	SNESSchedulerStats timing;     /**< scheduler instrumentation counters as on the target, iteration time in timer counts */
+	uint64_t   max_iteration_ns;   /**< longest main loop iteration executing a task */
+	uint64_t   nr_reads;           /**< number of complete SNES readings */
+	uint64_t   nr_bad_reads;       /**< readings not matching the pad state at latch time */
+	uint64_t   duration_ns;        /**< simulated time */
+} SimResult;
+
+/**
+ * @brief      distribution summary of a latency array
+ */
+typedef struct
+{
+	uint32_t min;     /**< minimum value */
+	uint32_t median;  /**< median value */
+	uint32_t p99;     /**< 99th percentile */
+	uint32_t max;     /**< maximum value */
+	double   mean;    /**< arithmetic mean */
+} SimStats;
+
+/**
+ * @brief      fills a configuration with the timing and mapping of the ATtiny84 implementation
+ * @param[out] config to initialize
+ */
+void Sim_DefaultConfig ( SimConfig * config );
+
+/**
+ * @brief      runs a complete simulation
+ * @param[in]  config of the run
+ * @param[out] result of the run, release with SimResult_Free()
+ * @returns    0 on success, -1 on invalid configuration or allocation failure
+ */
+int  Sim_Run ( const SimConfig * config, SimResult * result );
+
+/**
+ * @brief          releases memory held by a result
+ * @param[in, out] result to release
+ */
+void SimResult_Free ( SimResult * result );
+
+/**
+ * @brief          computes the distribution summary of a latency array
+ * @details        The array is sorted in place.
+ * @param[in, out] values to summarize
+ * @param[in]      nr_values in the array
+ * @param[out]     stats computed, all zero for an empty array
+ */
+void Sim_ComputeStats ( uint32_t * values, uint32_t nr_values, SimStats * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @} */
@@ -0,0 +1,363 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_trace.c
+ * @brief   implements the tracing pin HAL and VCD writer
+ * @details Events are encoded in 32bit:
+ *          - bits 28..31 kind of event
+ *          - pin events: bits 8..11 pin, bits 0..1 state
+ *          - input events: bits 0..15 SNES button mask
+ *          - probe events: bit 0 level of the latency probe pin
+ *
+ *          The VCD file has a 1ns timescale. Each pin is a wire (HIGHZ is shown as z),
+ *          each read produces an event on read_<pin> and updates the wire to the sampled level,
+ *          the gamepad buttons are a 16bit vector and the latency probe is the wire PROBE.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "snes2db9.h"
+#include "snes2db9_trace.h"
+
+#define EVENT_SET    0u   /**< pin set by the HAL */
+#define EVENT_READ   1u   /**< pin read by the HAL */
+#define EVENT_INPUT  2u   /**< gamepad buttons changed */
+#define EVENT_TIME   3u   /**< no event, carries a time delta exceeding 32bit */
+#define EVENT_PROBE  4u   /**< latency probe pin changed */
+
+#define EVENT_KIND(event)      ( ( event ) >> 28 )            /**< extracts the kind of an event */
+#define EVENT_PIN(event)       ( ( ( event ) >> 8 ) & 0x0Fu )  /**< extracts the pin of a pin event */
+#define EVENT_STATE(event)     ( ( event ) & 0x03u )           /**< extracts the state of a pin event */
+#define EVENT_BUTTONS(event)   ( ( event ) & 0xFFFFu )         /**< extracts the mask of an input event */
+
+#define NR_PINS          8u   /**< number of pins defined by SNES2DB9_Pin */
+#define VCD_ID_PIN       '!'  /**< first VCD identifier of the pin wires */
+#define VCD_ID_READ      ')'  /**< first VCD identifier of the read events */
+#define VCD_ID_BUTTONS   '1'  /**< VCD identifier of the button vector */
+#define VCD_ID_PROBE     '2'  /**< VCD identifier of the latency probe wire */
+
+static PinTrace * Active = NULL;  /**< trace used by the tracing HAL */
+
+/**
+ * @brief names of the pins in VCD output
+ */
+static const char * const PinNames[NR_PINS] =
+{
+	"SNES_LATCH", "SNES_CLK", "SNES_DATA", "DB9_UP", "DB9_DOWN", "DB9_LEFT", "DB9_RIGHT", "DB9_FIRE"
+};
+
+/**
+ * @brief     converts a pin state into a VCD value
+ * @param[in] state to convert
+ * @returns   VCD value character
+ */
+static char VcdValue ( uint32_t state )
+{
+	char value;
+
+	switch ( state )
+	{
+		case SNES2DB9_PIN_LOW:
+			value = '0';
+			break;
+
+		case SNES2DB9_PIN_HIGH:
+			value = '1';
+			break;
+
+		default:
+			value = 'z';
+			break;
+	}
+
+	return value;
+}
+
+/**
+ * @brief          writes the VCD header
+ * @param[in, out] self points to instance of PinTrace
+ */
+static void VcdHeader ( PinTrace * self )
+{
+	uint32_t pin;
+	fprintf ( self->vcd, "$version SNES2DB9 pin trace $end\n" );
+	fprintf ( self->vcd, "$timescale 1ns $end\n" );
+	fprintf ( self->vcd, "$scope module snes2db9 $end\n" );
+
+	for ( pin = 0; pin < NR_PINS; pin++ )
+	{
+		fprintf ( self->vcd, "$var wire 1 %c %s $end\n", VCD_ID_PIN + pin, PinNames[pin] );
+	}
+
+	for ( pin = 0; pin < NR_PINS; pin++ )
+	{
+		fprintf ( self->vcd, "$var event 1 %c read_%s $end\n", VCD_ID_READ + pin, PinNames[pin] );
+	}
+
+	fprintf ( self->vcd, "$var wire 16 %c buttons $end\n", VCD_ID_BUTTONS );
+	fprintf ( self->vcd, "$var wire 1 %c PROBE $end\n", VCD_ID_PROBE );
+	fprintf ( self->vcd, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n" );
+
+	for ( pin = 0; pin < NR_PINS; pin++ )
+	{
+		fprintf ( self->vcd, "x%c\n", VCD_ID_PIN + pin );
+	}
+
+	fprintf ( self->vcd, "b0 %c\n0%c\n$end\n", VCD_ID_BUTTONS, VCD_ID_PROBE );
+	self->vcd_started = true;
+	self->vcd_time_ns = 0;
+}
+
+/**
+ * @brief          writes one record to the VCD stream
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      time_ns of the record
+ * @param[in]      event of the record
+ */
+static void VcdEvent ( PinTrace * self, uint64_t time_ns, uint32_t event )
+{
+	uint32_t bit;
+
+	if ( EVENT_KIND ( event ) == EVENT_TIME )
+	{
+		return;
+	}
+
+	if ( time_ns != self->vcd_time_ns )
+	{
+		fprintf ( self->vcd, "#%llu\n", ( unsigned long long ) time_ns );
+		self->vcd_time_ns = time_ns;
+	}
+
+	switch ( EVENT_KIND ( event ) )
+	{
+		case EVENT_SET:
+			fprintf ( self->vcd, "%c%c\n", VcdValue ( EVENT_STATE ( event ) ), VCD_ID_PIN + EVENT_PIN ( event ) );
+			break;
+
+		case EVENT_READ:
+			/* the wire of a read pin shows the sampled level: */
+			fprintf ( self->vcd, "%c%c\n1%c\n", VcdValue ( EVENT_STATE ( event ) ), VCD_ID_PIN + EVENT_PIN ( event ),
+			          VCD_ID_READ + EVENT_PIN ( event ) );
+			break;
+
+		case EVENT_PROBE:
+			fprintf ( self->vcd, "%c%c\n", ( ( event & 1u ) != 0 ) ? '1' : '0', VCD_ID_PROBE );
+			break;
+
+		default:
+			fputc ( 'b', self->vcd );
+
+			for ( bit = 16; bit > 0; bit-- )
+			{
+				fputc ( ( ( EVENT_BUTTONS ( event ) >> ( bit - 1 ) ) & 1u ) ? '1' : '0', self->vcd );
+			}
+
+			fprintf ( self->vcd, " %c\n", VCD_ID_BUTTONS );
+			break;
+	}
+}
+
+/**
+ * @brief          appends a record, flushes or overwrites if the buffer is full
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      time_ns of the event
+ * @param[in]      event encoded
+ */
+static void Append ( PinTrace * self, uint64_t time_ns, uint32_t event )
+{
+	uint64_t delta;
+	assert ( self != NULL );
+	assert ( time_ns >= self->last_ns );
+	delta = time_ns - self->last_ns;
+
+	/* split deltas not fitting the record: */
+	while ( delta > UINT32_MAX )
+	{
+		Append ( self, self->last_ns + UINT32_MAX, EVENT_TIME << 28 );
+		delta -= UINT32_MAX;
+	}
+
+	if ( self->count == self->capacity )
+	{
+		if ( self->vcd != NULL )
+		{
+			( void ) PinTrace_Flush ( self );
+		}
+		else
+		{
+			/* drop the oldest record: */
+			self->head = ( self->head + 1u ) % self->capacity;
+			self->count--;
+			self->first_ns += self->records[self->head].delta_ns;
+			self->nr_dropped++;
+		}
+	}
+
+	if ( self->count == 0 )
+	{
+		self->first_ns = time_ns;
+	}
+
+	self->records[ ( self->head + self->count ) % self->capacity].delta_ns = ( uint32_t ) delta;
+	self->records[ ( self->head + self->count ) % self->capacity].event = event;
+	self->count++;
+	self->last_ns = time_ns;
+}
+
+int PinTrace_Init ( PinTrace * self, uint32_t capacity, FILE * vcd )
+{
+	assert ( self != NULL );
+	assert ( capacity > 0 );
+	self->records = malloc ( capacity * sizeof ( PinTraceRecord ) );
+	self->capacity = capacity;
+	self->head = 0;
+	self->count = 0;
+	self->first_ns = 0;
+	self->last_ns = 0;
+	self->nr_dropped = 0;
+	self->vcd = vcd;
+	self->vcd_started = false;
+	self->vcd_time_ns = 0;
+	self->now_ns = 0;
+	self->hal_call_ns = 0;
+	self->setpin = NULL;
+	self->getpin = NULL;
+	return ( self->records != NULL ) ? 0 : -1;
+}
+
+void PinTrace_Free ( PinTrace * self )
+{
+	assert ( self != NULL );
+	( void ) PinTrace_Flush ( self );
+
+	if ( Active == self )
+	{
+		Active = NULL;
+	}
+
+	free ( self->records );
+	self->records = NULL;
+	self->count = 0;
+}
+
+void PinTrace_Record ( PinTrace * self, uint64_t time_ns, SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read )
+{
+	Append ( self, time_ns, ( ( is_read ? EVENT_READ : EVENT_SET ) << 28 ) | ( ( uint32_t ) pin << 8 ) | ( uint32_t ) state );
+}
+
+void PinTrace_RecordInput ( PinTrace * self, uint64_t time_ns, uint16_t snes_pin_mask )
+{
+	Append ( self, time_ns, ( EVENT_INPUT << 28 ) | snes_pin_mask );
+}
+
+void PinTrace_RecordProbe ( PinTrace * self, uint64_t time_ns, bool level )
+{
+	Append ( self, time_ns, ( EVENT_PROBE << 28 ) | ( level ? 1u : 0u ) );
+}
+
+int PinTrace_Flush ( PinTrace * self )
+{
+	uint64_t time_ns;
+	bool     first;
+	assert ( self != NULL );
+
+	if ( self->vcd == NULL )
+	{
+		return 0;
+	}
+
+	if ( self->vcd_started == false )
+	{
+		VcdHeader ( self );
+	}
+
+	/* the delta of the oldest record is already contained in first_ns: */
+	time_ns = self->first_ns;
+	first = true;
+
+	while ( self->count > 0 )
+	{
+		if ( first == false )
+		{
+			time_ns += self->records[self->head].delta_ns;
+		}
+
+		VcdEvent ( self, time_ns, self->records[self->head].event );
+		self->head = ( self->head + 1u ) % self->capacity;
+		self->count--;
+		first = false;
+	}
+
+	self->head = 0;
+	return ( ferror ( self->vcd ) != 0 ) ? -1 : 0;
+}
+
+void PinTrace_PinObserver ( void * ctx, uint64_t time_ns, SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read )
+{
+	PinTrace_Record ( ( PinTrace * ) ctx, time_ns, pin, state, is_read );
+}
+
+void PinTrace_InputObserver ( void * ctx, uint64_t time_ns, uint16_t snes_pin_mask )
+{
+	PinTrace_RecordInput ( ( PinTrace * ) ctx, time_ns, snes_pin_mask );
+}
+
+void PinTrace_ProbeObserver ( void * ctx, uint64_t time_ns, bool level )
+{
+	PinTrace_RecordProbe ( ( PinTrace * ) ctx, time_ns, level );
+}
+
+void PinTrace_Attach ( PinTrace * self, SNES2DB9_SetPinFunc setfunc, SNES2DB9_ReadPinFunc readfunc, uint32_t hal_call_ns )
+{
+	Active = self;
+
+	if ( self != NULL )
+	{
+		self->setpin = setfunc;
+		self->getpin = readfunc;
+		self->hal_call_ns = hal_call_ns;
+	}
+}
+
+void PinTrace_Advance ( PinTrace * self, uint64_t delta_ns )
+{
+	assert ( self != NULL );
+	self->now_ns += delta_ns;
+}
+
+void PinTrace_SetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	assert ( Active != NULL );
+
+	if ( Active->setpin != NULL )
+	{
+		Active->setpin ( pin, state );
+	}
+
+	PinTrace_Record ( Active, Active->now_ns, pin, state, false );
+	Active->now_ns += Active->hal_call_ns;
+}
+
+SNES2DB9_Pinstate PinTrace_ReadPin ( SNES2DB9_Pin pin )
+{
+	SNES2DB9_Pinstate state = SNES2DB9_PIN_HIGH;
+	assert ( Active != NULL );
+
+	if ( Active->getpin != NULL )
+	{
+		state = Active->getpin ( pin );
+	}
+
+	PinTrace_Record ( Active, Active->now_ns, pin, state, true );
+	Active->now_ns += Active->hal_call_ns;
+	return state;
+}
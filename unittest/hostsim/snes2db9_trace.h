@@ -0,0 +1,185 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    snes2db9_trace.h
+ * @brief   API of the tracing pin HAL and VCD writer
+ * @details Every SNES2DB9_SetPinFunc/SNES2DB9_ReadPinFunc call is recorded with a simulated
+ *          timestamp into a ring buffer of 8 byte records. The trace is streamed as a
+ *          VCD file which can be opened with GTKWave or sigrok.
+ *
+ */
+
+/**
+ * @addtogroup SNES2DB9_Simulator
+ * @{
+ */
+
+#ifndef SNES2DB9_TRACE_H
+#define SNES2DB9_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "snes2db9.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief   compact trace record
+ * @details The timestamp is stored as delta to the previous record.
+ *          Deltas larger than 32bit are split by PinTrace_Record().
+ */
+typedef struct
+{
+	uint32_t delta_ns;  /**< time since the previous record */
+	uint32_t event;     /**< encoded event, see snes2db9_trace.c */
+} PinTraceRecord;
+
+/**
+ * @brief   ring buffer of pin activity
+ * @details With a VCD stream attached, a full buffer is flushed to the stream and no events are lost.
+ *          Without a stream the oldest records are overwritten and the buffer keeps the latest history.
+ *          All members shall be considered private. Access should be routed through the PinTrace_... functions
+ */
+typedef struct
+{
+	PinTraceRecord *     records;         /**< record storage */
+	uint32_t             capacity;        /**< number of records in storage */
+	uint32_t             head;            /**< index of the oldest record */
+	uint32_t             count;           /**< number of buffered records */
+	uint64_t             first_ns;        /**< timestamp of the oldest buffered record */
+	uint64_t             last_ns;         /**< timestamp of the newest record */
+	uint64_t             nr_dropped;      /**< records overwritten without stream */
+	FILE *               vcd;             /**< VCD stream, may be NULL */
+	bool                 vcd_started;     /**< VCD header has been written */
+	uint64_t             vcd_time_ns;     /**< last timestamp written to the VCD stream */
+	uint64_t             now_ns;          /**< clock of the tracing HAL */
+	uint32_t             hal_call_ns;     /**< clock advance per tracing HAL call */
+	SNES2DB9_SetPinFunc  setpin;          /**< downstream HAL called by PinTrace_SetPin(), may be NULL */
+	SNES2DB9_ReadPinFunc getpin;          /**< downstream HAL called by PinTrace_ReadPin(), may be NULL */
+} PinTrace;
+
+/**
+ * @brief          initializes a trace
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      capacity of the ring buffer in records
+ * @param[in]      vcd stream to write the trace to, may be NULL to keep only the latest history
+ * @returns        0 on success, -1 on allocation failure
+ */
+int  PinTrace_Init ( PinTrace * self, uint32_t capacity, FILE * vcd );
+
+/**
+ * @brief          flushes the trace to the VCD stream and releases the buffer
+ * @param[in, out] self points to instance of PinTrace
+ */
+void PinTrace_Free ( PinTrace * self );
+
+/**
+ * @brief          records a pin access
+ * @details        Timestamps must not decrease.
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      time_ns of the access
+ * @param[in]      pin accessed
+ * @param[in]      state set or read
+ * @param[in]      is_read distinguishes reads from writes
+ */
+void PinTrace_Record ( PinTrace * self, uint64_t time_ns, SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read );
+
+/**
+ * @brief          records a change of the SNES gamepad buttons
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      time_ns of the change
+ * @param[in]      snes_pin_mask is the new button state bitcoded according to SNES_BTNMASK_xxx (active high)
+ */
+void PinTrace_RecordInput ( PinTrace * self, uint64_t time_ns, uint16_t snes_pin_mask );
+
+/**
+ * @brief          records an edge of the latency probe pin
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      time_ns of the edge
+ * @param[in]      level of the probe pin after the edge
+ */
+void PinTrace_RecordProbe ( PinTrace * self, uint64_t time_ns, bool level );
+
+/**
+ * @brief          writes all buffered records to the VCD stream
+ * @details        The VCD header is written on the first flush. Without stream the call has no effect.
+ * @param[in, out] self points to instance of PinTrace
+ * @returns        0 on success, -1 on write errors
+ */
+int  PinTrace_Flush ( PinTrace * self );
+
+/**
+ * @brief     SimPinObserver recording into the PinTrace given as ctx
+ * @param[in] ctx points to instance of PinTrace
+ * @param[in] time_ns of the access
+ * @param[in] pin accessed
+ * @param[in] state set or read
+ * @param[in] is_read distinguishes reads from writes
+ */
+void PinTrace_PinObserver ( void * ctx, uint64_t time_ns, SNES2DB9_Pin pin, SNES2DB9_Pinstate state, bool is_read );
+
+/**
+ * @brief     SimInputObserver recording into the PinTrace given as ctx
+ * @param[in] ctx points to instance of PinTrace
+ * @param[in] time_ns of the change
+ * @param[in] snes_pin_mask is the new button state
+ */
+void PinTrace_InputObserver ( void * ctx, uint64_t time_ns, uint16_t snes_pin_mask );
+
+/**
+ * @brief     SimProbeObserver recording into the PinTrace given as ctx
+ * @param[in] ctx points to instance of PinTrace
+ * @param[in] time_ns of the edge
+ * @param[in] level of the probe pin after the edge
+ */
+void PinTrace_ProbeObserver ( void * ctx, uint64_t time_ns, bool level );
+
+/**
+ * @brief          selects the trace used by the tracing HAL functions
+ * @details        The HAL prototypes carry no context, so a single trace is active at a time.
+ *                 The tracing HAL forwards every call to the downstream HAL and advances its clock by hal_call_ns.
+ * @param[in, out] self points to instance of PinTrace, NULL detaches
+ * @param[in]      setfunc downstream HAL, may be NULL
+ * @param[in]      readfunc downstream HAL, may be NULL in which case reads return SNES2DB9_PIN_HIGH
+ * @param[in]      hal_call_ns is the simulated duration of a HAL call
+ */
+void PinTrace_Attach ( PinTrace * self, SNES2DB9_SetPinFunc setfunc, SNES2DB9_ReadPinFunc readfunc, uint32_t hal_call_ns );
+
+/**
+ * @brief          advances the clock of the tracing HAL
+ * @param[in, out] self points to instance of PinTrace
+ * @param[in]      delta_ns to advance
+ */
+void PinTrace_Advance ( PinTrace * self, uint64_t delta_ns );
+
+/**
+ * @brief     tracing SNES2DB9_SetPinFunc
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+void PinTrace_SetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state );
+
+/**
+ * @brief     tracing SNES2DB9_ReadPinFunc
+ * @param[in] pin to read
+ * @returns   pin state of the downstream HAL
+ */
+SNES2DB9_Pinstate PinTrace_ReadPin ( SNES2DB9_Pin pin );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @} */
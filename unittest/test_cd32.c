@@ -0,0 +1,101 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_cd32.c
+ * @brief   unittest implementation for CD32Pad
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t idx;
+	CD32Pad ut_pad;  /**< CD32 pad instance under test */
+	char tmpstr[80];
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest CD32Pad()" );
+	UT_TESTCASE ( "Object init" );
+	UT_DESCRIPTION ( "No buttons pressed, identification trailer only" );
+	CD32Pad_Init ( &ut_pad );
+	UT_TEST ( ut_pad.image == CD32_IMAGE_TRAILER );
+	UT_TEST ( ut_pad.shiftreg == CD32_IMAGE_TRAILER );
+	UT_TESTCASE ( "Button mapping" );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_A );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Blue ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_B );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Red ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_X );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Yellow ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_Y );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Green ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_R );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Forward ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_L );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Reverse ) );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_Start );
+	UT_TEST ( ut_pad.image == ( CD32_IMAGE_TRAILER | CD32_BTNMASK_Play ) );
+	UT_TESTCASE ( "Directions and Select are not part of the serial image" );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_Up | SNES_BTNMASK_Down | SNES_BTNMASK_Left | SNES_BTNMASK_Right | SNES_BTNMASK_Select );
+	UT_TEST ( ut_pad.image == CD32_IMAGE_TRAILER );
+	UT_TESTCASE ( "Image is not visible before the host loads it" );
+	UT_PRECONDITION_STR ( "CD32Pad_Update() with Blue pressed after init" );
+	CD32Pad_Init ( &ut_pad );
+	CD32Pad_Update ( &ut_pad, SNES_BTNMASK_A );
+	UT_TEST ( ut_pad.shiftreg == CD32_IMAGE_TRAILER );
+	UT_TESTCASE ( "Serial shift-out of Blue, Yellow, Reverse" );
+	UT_PRECONDITION ( CD32Pad_Update ( &ut_pad, SNES_BTNMASK_A | SNES_BTNMASK_X | SNES_BTNMASK_L ) );
+	UT_DESCRIPTION ( "Pressed buttons pull the data line low" );
+	UT_TEST ( SNES2DB9_PIN_LOW == CD32Pad_Load ( &ut_pad ) );
+	UT_COMMENT ( "Red" );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Clock ( &ut_pad ) );
+	UT_COMMENT ( "Yellow" );
+	UT_TEST ( SNES2DB9_PIN_LOW == CD32Pad_Clock ( &ut_pad ) );
+	UT_COMMENT ( "Green" );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Clock ( &ut_pad ) );
+	UT_COMMENT ( "Forward" );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Clock ( &ut_pad ) );
+	UT_COMMENT ( "Reverse" );
+	UT_TEST ( SNES2DB9_PIN_LOW == CD32Pad_Clock ( &ut_pad ) );
+	UT_COMMENT ( "Play" );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Clock ( &ut_pad ) );
+	UT_TESTCASE ( "Pad identification trailer" );
+	UT_DESCRIPTION ( "8th bit released, 9th bit and following pulled low" );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Clock ( &ut_pad ) );
+
+	for ( idx = 9; idx <= 20; idx++ )
+	{
+		sprintf ( tmpstr, "Clock %d", idx );
+		UT_COMMENT ( tmpstr );
+		UT_TEST ( SNES2DB9_PIN_LOW == CD32Pad_Clock ( &ut_pad ) );
+	}
+
+	UT_TESTCASE ( "Reload restarts with the first button" );
+	UT_PRECONDITION ( CD32Pad_Update ( &ut_pad, SNES_BTNMASK_B ) );
+	UT_TEST ( SNES2DB9_PIN_HIGHZ == CD32Pad_Load ( &ut_pad ) );
+	UT_TEST ( SNES2DB9_PIN_LOW == CD32Pad_Clock ( &ut_pad ) );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,123 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_chord.c
+ * @brief   unittest implementation for SNESChord
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+/** chords under test */
+static const SNESChordDef ut_chords[] =
+{
+	{ SNES_BTNMASK_L, 0 },                       /* 0: Select+L immediately */
+	{ SNES_BTNMASK_L | SNES_BTNMASK_R, 0 },      /* 1: Select+L+R immediately */
+	{ SNES_BTNMASK_Start, 0 },                   /* 2: Select+Start immediately */
+	{ SNES_BTNMASK_Start, 1000 },                /* 3: Select+Start held for 1s */
+	{ 0, 2000 },                                 /* 4: Select alone held for 2s */
+};
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t cnt;
+	uint8_t  fired;
+	SNESChord ut_chord;  /**< chord instance under test */
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESChord()" );
+	UT_TESTCASE ( "Object init" );
+	SNESChord_Init ( &ut_chord, SNES_BTNMASK_Select, ut_chords, sizeof ( ut_chords ) / sizeof ( ut_chords[0] ) );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Regular input passes" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L | SNES_BTNMASK_B | 0x000F, 16 ) == ( SNES_BTNMASK_L | SNES_BTNMASK_B | 0x000F ) );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Lead button is withheld" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | 0x000F, 16 ) == 0x000F );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Chord fires once on press" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_L, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x01 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_L, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Only the exact chord fires" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_L | SNES_BTNMASK_R, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x02 );
+	UT_TESTCASE ( "Chord fires again after partial release" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_L, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x01 );
+	UT_TESTCASE ( "Chord buttons do not leak after lead release" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L | SNES_BTNMASK_B, 16 ) == SNES_BTNMASK_B );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L, 16 ) == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, 0, 16 ) == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L, 16 ) == SNES_BTNMASK_L );
+	UT_TESTCASE ( "Chord without lead does not fire" );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, 0, 16 ) == 0 );
+	UT_TESTCASE ( "Short and long hold of the same chord" );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_Start, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x04 );
+	fired = 0;
+
+	for ( cnt = 16; cnt < 1000; cnt += 16 )
+	{
+		SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_Start, 16 );
+		fired |= SNESChord_GetFired ( &ut_chord );
+	}
+
+	UT_TEST ( fired == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_Start, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x08 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select | SNES_BTNMASK_Start, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Lead alone held" );
+	SNESChord_Update ( &ut_chord, 0, 16 );
+	fired = 0;
+
+	for ( cnt = 0; cnt <= 2000; cnt += 16 )
+	{
+		SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select, 16 );
+		fired |= SNESChord_GetFired ( &ut_chord );
+	}
+
+	UT_TEST ( fired == 0x10 );
+	UT_TESTCASE ( "Hold time does not overflow" );
+
+	for ( cnt = 0; cnt < 2000; cnt++ )
+	{
+		SNESChord_Update ( &ut_chord, SNES_BTNMASK_Select, 100 );
+	}
+
+	UT_TEST ( ut_chord.held_millis == UINT16_MAX );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TESTCASE ( "Multiple lead buttons" );
+	SNESChord_Init ( &ut_chord, SNES_BTNMASK_L | SNES_BTNMASK_R, ut_chords + 2, 1 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L | SNES_BTNMASK_Start, 16 ) == ( SNES_BTNMASK_L | SNES_BTNMASK_Start ) );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0 );
+	UT_TEST ( SNESChord_Update ( &ut_chord, SNES_BTNMASK_L | SNES_BTNMASK_R | SNES_BTNMASK_Start, 16 ) == 0 );
+	UT_TEST ( SNESChord_GetFired ( &ut_chord ) == 0x01 );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,263 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_macro.c
+ * @brief   unittest implementation for SNESMacro
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+#define FRAMES 600  /**< length of the recorded input sequence */
+
+static uint8_t  eeprom[1024];            /**< simulated EEPROM */
+static uint16_t ut_input[FRAMES];        /**< recorded input sequence */
+static uint16_t ut_writes;               /**< number of simulated EEPROM writes */
+
+/**
+ * @brief     simulated EEPROM write
+ * @param[in] address to write
+ * @param[in] value to write
+ */
+static void UT_WriteByte ( uint16_t address, uint8_t value )
+{
+	eeprom[address] = value;
+	ut_writes++;
+}
+
+/**
+ * @brief     simulated EEPROM read
+ * @param[in] address to read
+ * @returns   value stored
+ */
+static uint8_t UT_ReadByte ( uint16_t address )
+{
+	return eeprom[address];
+}
+
+/**
+ * @brief     generates an input sequence with simultaneous toggles, short and long pauses
+ */
+static void UT_GenerateInput ( void )
+{
+	uint16_t cnt;
+	uint16_t state = SNES_BTNMASK_Right;
+
+	for ( cnt = 0; cnt < FRAMES; cnt++ )
+	{
+		if ( cnt == 1 )
+		{
+			state |= SNES_BTNMASK_B | SNES_BTNMASK_A;
+		}
+		else if ( cnt == 4 )
+		{
+			state &= ( uint16_t ) ~SNES_BTNMASK_B;
+		}
+		else if ( cnt == 30 )
+		{
+			state ^= SNES_BTNMASK_Right | SNES_BTNMASK_Left;
+		}
+		else if ( cnt == 400 )
+		{
+			state = SNES_BTNMASK_Y;
+		}
+		else if ( ( cnt > 410 ) && ( cnt < 500 ) && ( ( cnt % 7 ) == 0 ) )
+		{
+			state ^= SNES_BTNMASK_Start;
+		}
+
+		ut_input[cnt] = state;
+	}
+}
+
+/**
+ * @brief     plays back and compares against the generated input
+ * @param[in, out] macro to play
+ * @returns   number of deviating frames
+ */
+static uint16_t UT_ComparePlayback ( SNESMacro * macro )
+{
+	uint16_t cnt;
+	uint16_t errors = 0;
+
+	for ( cnt = 0; cnt < FRAMES; cnt++ )
+	{
+		if ( SNESMacro_Update ( macro, 0 ) != ut_input[cnt] )
+		{
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t cnt;
+	uint16_t errors;
+	SNESMacro ut_macro;  /**< macro instance under test */
+	SNESMacro ut_loaded; /**< macro instance loaded from the simulated EEPROM */
+	char tmpstr[80];
+	UT_ENABLE_HTML();
+	UT_GenerateInput();
+	UT_BEGIN ( "Unittest SNESMacro()" );
+	UT_TESTCASE ( "Object init" );
+	SNESMacro_Init ( &ut_macro );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_IDLE );
+	UT_TEST ( ut_macro.count == 0 );
+	UT_TESTCASE ( "Idle passes input through" );
+	UT_TEST ( SNESMacro_Update ( &ut_macro, SNES_BTNMASK_A | 0x000F ) == ( SNES_BTNMASK_A | 0x000F ) );
+	UT_TESTCASE ( "Empty macro does not play" );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == false );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_IDLE );
+	UT_TESTCASE ( "Recording passes input through" );
+	SNESMacro_StartRecording ( &ut_macro, ut_input[0] );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_RECORDING );
+	errors = 0;
+
+	for ( cnt = 0; cnt < FRAMES; cnt++ )
+	{
+		if ( SNESMacro_Update ( &ut_macro, ut_input[cnt] ) != ut_input[cnt] )
+		{
+			errors++;
+		}
+	}
+
+	UT_TEST ( errors == 0 );
+	SNESMacro_Stop ( &ut_macro );
+	sprintf ( tmpstr, "%d frames recorded in %d bytes", FRAMES, ut_macro.count );
+	UT_COMMENT ( tmpstr );
+	UT_TEST ( ut_macro.count < SNESMACRO_BUFFER_SIZE );
+	UT_TESTCASE ( "Playback is frame exact" );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == true );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_PLAYBACK );
+	UT_TEST ( UT_ComparePlayback ( &ut_macro ) == 0 );
+	UT_TESTCASE ( "Playback ends after the recorded duration" );
+	UT_TEST ( SNESMacro_Update ( &ut_macro, SNES_BTNMASK_X ) == SNES_BTNMASK_X );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_IDLE );
+	UT_TESTCASE ( "Looped playback repeats seamlessly" );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, true ) == true );
+	UT_TEST ( UT_ComparePlayback ( &ut_macro ) == 0 );
+	UT_TEST ( UT_ComparePlayback ( &ut_macro ) == 0 );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_PLAYBACK );
+	SNESMacro_Stop ( &ut_macro );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_IDLE );
+	UT_TESTCASE ( "Save and load" );
+	memset ( eeprom, 0xFF, sizeof ( eeprom ) );
+	SNESMacro_Save ( &ut_macro, UT_WriteByte, 100 );
+	UT_TEST ( eeprom[99] == 0xFF );
+	UT_TEST ( eeprom[100 + 3 + ut_macro.count] == 0xFF );
+	UT_TEST ( SNESMacro_Load ( &ut_macro, UT_ReadByte, 100 ) == true );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == true );
+	UT_TEST ( UT_ComparePlayback ( &ut_macro ) == 0 );
+	UT_TESTCASE ( "Erased EEPROM is rejected" );
+	UT_TEST ( SNESMacro_Load ( &ut_macro, UT_ReadByte, 500 ) == false );
+	UT_TEST ( ut_macro.count == 0 );
+	UT_TESTCASE ( "Trailer bits are not recorded" );
+	SNESMacro_StartRecording ( &ut_macro, 0x000F );
+	SNESMacro_Update ( &ut_macro, SNES_BTNMASK_A | 0x000F );
+	SNESMacro_Update ( &ut_macro, 0x0000 );
+	SNESMacro_Stop ( &ut_macro );
+	UT_TEST ( ut_macro.count == 3 );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == true );
+	UT_TEST ( SNESMacro_Update ( &ut_macro, 0 ) == SNES_BTNMASK_A );
+	UT_TEST ( SNESMacro_Update ( &ut_macro, 0 ) == 0 );
+	UT_TESTCASE ( "Overflow keeps the latest events" );
+	SNESMacro_StartRecording ( &ut_macro, 0 );
+
+	for ( cnt = 0; cnt < 1000; cnt++ )
+	{
+		SNESMacro_Update ( &ut_macro, ( cnt & 1 ) ? SNES_BTNMASK_B : 0 );
+	}
+
+	UT_TEST ( ut_macro.count == SNESMACRO_BUFFER_SIZE );
+	SNESMacro_Stop ( &ut_macro );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == true );
+	errors = 0;
+
+	for ( cnt = 1000 - SNESMACRO_BUFFER_SIZE; cnt < 1000; cnt++ )
+	{
+		if ( SNESMacro_Update ( &ut_macro, 0 ) != ( ( cnt & 1 ) ? SNES_BTNMASK_B : 0 ) )
+		{
+			errors++;
+		}
+	}
+
+	UT_TEST ( errors == 0 );
+	UT_TESTCASE ( "Background save" );
+	UT_DESCRIPTION ( "Recording and playback are refused, the input is passed through" );
+	SNESMacro_Save ( &ut_macro, UT_WriteByte, 100 );
+	SNESMacro_StartSave ( &ut_macro );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_SAVING );
+	SNESMacro_StartRecording ( &ut_macro, 0 );
+	SNESMacro_Stop ( &ut_macro );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_macro, false ) == false );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_SAVING );
+	UT_TEST ( ut_macro.count == SNESMACRO_BUFFER_SIZE );
+	UT_TEST ( SNESMacro_Update ( &ut_macro, SNES_BTNMASK_X ) == SNES_BTNMASK_X );
+	UT_DESCRIPTION ( "One byte per step, an interrupted save is rejected" );
+	ut_writes = 0;
+	UT_TEST ( SNESMacro_SaveStep ( &ut_macro, UT_WriteByte, 100 ) == true );
+	UT_TEST ( ut_writes == 1 );
+	UT_TEST ( SNESMacro_Load ( &ut_loaded, UT_ReadByte, 100 ) == false );
+	errors = 0;
+
+	while ( SNESMacro_SaveStep ( &ut_macro, UT_WriteByte, 100 ) == true )
+	{
+		if ( ut_writes != ( ut_macro.save_step ) )
+		{
+			errors++;
+		}
+
+		if ( SNESMacro_Load ( &ut_loaded, UT_ReadByte, 100 ) == true )
+		{
+			errors++;
+		}
+	}
+
+	UT_TEST ( errors == 0 );
+	UT_TEST ( ut_writes == ( SNESMACRO_BUFFER_SIZE + 4u ) );
+	UT_TEST ( SNESMacro_GetMode ( &ut_macro ) == SNESMACRO_IDLE );
+	UT_TEST ( SNESMacro_SaveStep ( &ut_macro, UT_WriteByte, 100 ) == false );
+	UT_TEST ( ut_writes == ( SNESMACRO_BUFFER_SIZE + 4u ) );
+	UT_DESCRIPTION ( "The completed save loads the recording" );
+	UT_TEST ( SNESMacro_Load ( &ut_loaded, UT_ReadByte, 100 ) == true );
+	UT_TEST ( ut_loaded.count == ut_macro.count );
+	UT_TEST ( ut_loaded.start_state == ut_macro.start_state );
+	UT_TEST ( SNESMacro_StartPlayback ( &ut_loaded, false ) == true );
+	errors = 0;
+
+	for ( cnt = 1000 - SNESMACRO_BUFFER_SIZE; cnt < 1000; cnt++ )
+	{
+		if ( SNESMacro_Update ( &ut_loaded, 0 ) != ( ( cnt & 1 ) ? SNES_BTNMASK_B : 0 ) )
+		{
+			errors++;
+		}
+	}
+
+	UT_TEST ( errors == 0 );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
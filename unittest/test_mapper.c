@@ -142,6 +142,20 @@ int main ( int argc, char **argv )
 		UT_TEST ( 0 == SNESMapper_Update ( &ut_mapper, ut_snes_input_state, 1 ) );
 	}
 
+	UT_TESTCASE ( "test Autofire, updates spanning several cycles toggle several times" );
+	UT_PRECONDITION ( SNESMapper_SetAutofireDuration ( &ut_mapper, 16 ) );
+	UT_PRECONDITION ( ut_mapper.millis = 0 );
+	UT_PRECONDITION ( ut_mapper.autofire_active = false );
+	UT_COMMENT ( "33ms: 2 toggles, off" );
+	UT_TEST ( 0 == SNESMapper_Update ( &ut_mapper, ut_snes_input_state, 33 ) );
+	UT_COMMENT ( "48ms: 3 toggles, on" );
+	UT_TEST ( DB9_BTNMASK_Fire == SNESMapper_Update ( &ut_mapper, ut_snes_input_state, 15 ) );
+	UT_COMMENT ( "88ms: 5 toggles, on" );
+	UT_TEST ( DB9_BTNMASK_Fire == SNESMapper_Update ( &ut_mapper, ut_snes_input_state, 40 ) );
+	UT_COMMENT ( "96ms: 6 toggles, off" );
+	UT_TEST ( 0 == SNESMapper_Update ( &ut_mapper, ut_snes_input_state, 8 ) );
+	UT_TEST ( ut_mapper.millis == 0 );
+
 	UT_END();
 #ifdef GCOV_ENABLED
 	return 0;
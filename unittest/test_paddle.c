@@ -0,0 +1,102 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_paddle.c
+ * @brief   unittest implementation for SNESPaddle
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t cnt;
+	uint8_t  pos, last_pos;
+	SNESPaddle ut_paddle;  /**< paddle instance under test */
+	char tmpstr[80];
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESPaddle()" );
+	UT_TESTCASE ( "Object init" );
+	SNESPaddle_Init ( &ut_paddle );
+	UT_TEST ( ut_paddle.position == 0x7F00 );
+	UT_TEST ( ut_paddle.speed == PADDLE_SPEED_MIN );
+	UT_TESTCASE ( "Joypad idle, paddle keeps position" );
+	UT_TEST ( 127 == SNESPaddle_Update ( &ut_paddle, 0, 16 ) );
+	UT_TEST ( 127 == SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_B | SNES_BTNMASK_Up, 16 ) );
+	UT_TESTCASE ( "Contradicting directions stop the paddle" );
+	UT_TEST ( 127 == SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Left | SNES_BTNMASK_Right, 16 ) );
+	UT_TESTCASE ( "Right moves with acceleration" );
+	UT_PRECONDITION ( SNESPaddle_Init ( &ut_paddle ) );
+	last_pos = 127;
+
+	for ( cnt = 1; cnt <= 4; cnt++ )
+	{
+		pos = SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Right, 16 );
+		sprintf ( tmpstr, "update %d: position %d, speed %d", cnt, pos, ut_paddle.speed );
+		UT_COMMENT ( tmpstr );
+		UT_TEST ( pos > last_pos );
+		last_pos = pos;
+	}
+
+	UT_TEST ( ut_paddle.speed == ( PADDLE_SPEED_MIN + ( 4 * 16 * PADDLE_ACCELERATION ) ) );
+	UT_TESTCASE ( "Release resets speed" );
+	UT_TEST ( last_pos == SNESPaddle_Update ( &ut_paddle, 0, 16 ) );
+	UT_TEST ( ut_paddle.speed == PADDLE_SPEED_MIN );
+	UT_TESTCASE ( "Speed saturates and position clamps right" );
+
+	for ( cnt = 0; cnt < 200; cnt++ )
+	{
+		pos = SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Right, 16 );
+	}
+
+	UT_TEST ( ut_paddle.speed == PADDLE_SPEED_MAX );
+	UT_TEST ( pos == 255 );
+	UT_TEST ( ut_paddle.position == PADDLE_POSITION_MAX );
+	UT_TESTCASE ( "Position clamps left" );
+
+	for ( cnt = 0; cnt < 200; cnt++ )
+	{
+		pos = SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Left, 16 );
+	}
+
+	UT_TEST ( pos == 0 );
+	UT_TESTCASE ( "L slows down, R speeds up" );
+	UT_PRECONDITION ( SNESPaddle_Init ( &ut_paddle ) );
+	UT_COMMENT ( "16 * 16 / 4 = 64 fraction" );
+	UT_TEST ( 127 == SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Right | SNES_BTNMASK_L, 16 ) );
+	UT_TEST ( ut_paddle.position == 0x7F40 );
+	UT_PRECONDITION ( SNESPaddle_Init ( &ut_paddle ) );
+	UT_COMMENT ( "16 * 16 * 4 = 1024 fraction" );
+	UT_TEST ( 131 == SNESPaddle_Update ( &ut_paddle, SNES_BTNMASK_Right | SNES_BTNMASK_R, 16 ) );
+	UT_TESTCASE ( "Pot line delay" );
+	UT_PRECONDITION ( ut_paddle.position = 0 );
+	UT_TEST ( 1000 == SNESPaddle_GetDelay ( &ut_paddle, 100, 1000 ) );
+	UT_PRECONDITION ( ut_paddle.position = PADDLE_POSITION_MAX );
+	UT_TEST ( 100 == SNESPaddle_GetDelay ( &ut_paddle, 100, 1000 ) );
+	UT_PRECONDITION ( ut_paddle.position = 0x8000 );
+	UT_TEST ( 549 == SNESPaddle_GetDelay ( &ut_paddle, 100, 1000 ) );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,206 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_profile.c
+ * @brief   unittest implementation for SNESProfiles
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+#define EEPROM_BASE (256)  /**< start of the profile storage in the simulated EEPROM */
+
+static uint8_t  eeprom[512];          /**< simulated EEPROM */
+static uint16_t eeprom_writes[512];   /**< number of writes per EEPROM address */
+
+/** default profiles for the test, profile 0 equals the ATtiny84 firmware configuration */
+static const SNESProfile ut_defaults[SNESPROFILE_COUNT] =
+{
+	{ { SNES_BTNMASK_B, SNES_BTNMASK_Y, SNES_BTNMASK_A }, 16 },
+	{ { SNES_BTNMASK_B | SNES_BTNMASK_A, 0, 0 }, 0 },
+	{ { SNES_BTNMASK_Y, SNES_BTNMASK_B, SNES_BTNMASK_X }, 100 },
+	{ { SNES_BTNMASK_L | SNES_BTNMASK_R, SNES_BTNMASK_Y, SNES_BTNMASK_B }, 48 },
+};
+
+/**
+ * @brief     simulated EEPROM write, unchanged bytes are not written
+ * @param[in] address to write
+ * @param[in] value to write
+ */
+static void UT_WriteByte ( uint16_t address, uint8_t value )
+{
+	if ( eeprom[address] != value )
+	{
+		eeprom[address] = value;
+		eeprom_writes[address]++;
+	}
+}
+
+/**
+ * @brief     simulated EEPROM read
+ * @param[in] address to read
+ * @returns   value stored
+ */
+static uint8_t UT_ReadByte ( uint16_t address )
+{
+	return eeprom[address];
+}
+
+/**
+ * @brief     returns the highest number of writes to a single EEPROM address
+ * @returns   number of writes
+ */
+static uint16_t UT_MaxWrites ( void )
+{
+	uint16_t idx;
+	uint16_t max = 0;
+
+	for ( idx = 0; idx < sizeof ( eeprom ); idx++ )
+	{
+		max = ( eeprom_writes[idx] > max ) ? eeprom_writes[idx] : max;
+	}
+
+	return max;
+}
+
+/**
+ * @brief         writes the queued journal entry completely
+ * @param[in,out] profiles points to instance of SNESProfiles
+ * @returns       number of SNESProfiles_WriteStep() calls
+ */
+static uint16_t UT_FlushJournal ( SNESProfiles * profiles )
+{
+	uint16_t steps = 1;
+
+	while ( SNESProfiles_WriteStep ( profiles ) == true )
+	{
+		steps++;
+	}
+
+	return steps;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t cnt;
+	uint16_t errors;
+	SNESProfiles ut_profiles;  /**< profiles instance under test */
+	SNESMapper   ut_mapper;    /**< mapper configured by the profiles */
+	SNESProfile  profile;
+	char tmpstr[80];
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESProfiles()" );
+	UT_TESTCASE ( "Erased EEPROM is seeded with defaults" );
+	memset ( eeprom, 0xFF, sizeof ( eeprom ) );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 0 );
+	UT_TEST ( SNESProfiles_Load ( &ut_profiles, 2, &profile ) == true );
+	UT_TEST ( memcmp ( &profile, &ut_defaults[2], sizeof ( profile ) ) == 0 );
+	UT_TEST ( eeprom[EEPROM_BASE - 1] == 0xFF );
+	UT_TEST ( eeprom[EEPROM_BASE + ( SNESPROFILE_COUNT * SNESPROFILE_RECORD_SIZE )] == 0xFF );
+	UT_TESTCASE ( "Invalid index" );
+	UT_TEST ( SNESProfiles_Load ( &ut_profiles, SNESPROFILE_COUNT, &profile ) == false );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, SNESPROFILE_COUNT, &ut_mapper ) == false );
+	UT_TESTCASE ( "Select configures the mapper" );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 1, &ut_mapper ) == true );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 1 );
+	UT_TEST ( ut_mapper.autofire_cycletime_millis == 0 );
+	UT_TEST ( SNESMapper_Update ( &ut_mapper, SNES_BTNMASK_A, 16 ) == DB9_BTNMASK_Fire );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 3, &ut_mapper ) == true );
+	UT_TEST ( ut_mapper.autofire_cycletime_millis == 48 );
+	UT_TEST ( SNESMapper_Update ( &ut_mapper, SNES_BTNMASK_B, 16 ) == DB9_BTNMASK_Up );
+	UT_TEST ( SNESMapper_Update ( &ut_mapper, SNES_BTNMASK_R, 16 ) == DB9_BTNMASK_Fire );
+	UT_TESTCASE ( "Journal entry is written one byte per step" );
+	memset ( eeprom_writes, 0, sizeof ( eeprom_writes ) );
+	UT_DESCRIPTION ( "Select does not write, the mapper is configured at once" );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 2, &ut_mapper ) == true );
+	UT_TEST ( UT_MaxWrites() == 0 );
+	UT_TEST ( ut_mapper.autofire_cycletime_millis == 100 );
+	UT_DESCRIPTION ( "Reselecting while pending reuses the entry" );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 3, &ut_mapper ) == true );
+	UT_DESCRIPTION ( "Profile index first, not committed yet" );
+	UT_TEST ( SNESProfiles_WriteStep ( &ut_profiles ) == true );
+	UT_TEST ( UT_MaxWrites() == 1 );
+	UT_DESCRIPTION ( "Changing the selection now writes the profile index again" );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 1, &ut_mapper ) == true );
+	UT_TEST ( UT_FlushJournal ( &ut_profiles ) == 2 );
+	UT_TEST ( SNESProfiles_WriteStep ( &ut_profiles ) == false );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 1 );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 3, &ut_mapper ) == true );
+	UT_TEST ( UT_FlushJournal ( &ut_profiles ) == 2 );
+	UT_TESTCASE ( "Selection survives a restart" );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 3 );
+	UT_TESTCASE ( "Reselecting does not write" );
+	memset ( eeprom_writes, 0, sizeof ( eeprom_writes ) );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 3, &ut_mapper ) == true );
+	UT_TEST ( UT_MaxWrites() == 0 );
+	UT_TESTCASE ( "Stored profile replaces the default" );
+	profile = ut_defaults[0];
+	profile.autofire_cycletime_millis = 200;
+	SNESProfiles_Store ( &ut_profiles, 0, &profile );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_Select ( &ut_profiles, 0, &ut_mapper ) == true );
+	UT_TEST ( ut_mapper.autofire_cycletime_millis == 200 );
+	UT_TEST ( UT_FlushJournal ( &ut_profiles ) == 2 );
+	UT_TESTCASE ( "Corrupted profile is restored from defaults" );
+	eeprom[EEPROM_BASE + SNESPROFILE_RECORD_SIZE + 1] ^= 0x10;
+	UT_TEST ( SNESProfiles_Load ( &ut_profiles, 1, &profile ) == false );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_Load ( &ut_profiles, 1, &profile ) == true );
+	UT_TEST ( memcmp ( &profile, &ut_defaults[1], sizeof ( profile ) ) == 0 );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 0 );
+	UT_TESTCASE ( "Journal wraps and levels the wear" );
+	memset ( eeprom_writes, 0, sizeof ( eeprom_writes ) );
+	errors = 0;
+
+	for ( cnt = 1; cnt <= 1000; cnt++ )
+	{
+		( void ) SNESProfiles_Select ( &ut_profiles, ( uint8_t ) ( cnt % SNESPROFILE_COUNT ), &ut_mapper );
+		( void ) UT_FlushJournal ( &ut_profiles );
+		SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+
+		if ( SNESProfiles_GetSelected ( &ut_profiles ) != ( cnt % SNESPROFILE_COUNT ) )
+		{
+			errors++;
+		}
+	}
+
+	UT_TEST ( errors == 0 );
+	sprintf ( tmpstr, "1000 selections, at most %d writes per address", UT_MaxWrites() );
+	UT_COMMENT ( tmpstr );
+	UT_TEST ( UT_MaxWrites() <= ( ( 1000 / SNESPROFILE_JOURNAL_SLOTS ) + 1 ) );
+	UT_TESTCASE ( "Interrupted journal write keeps the previous selection" );
+	UT_PRECONDITION ( SNESProfiles_Select ( &ut_profiles, 2, &ut_mapper ) );
+	UT_PRECONDITION ( UT_FlushJournal ( &ut_profiles ) );
+	UT_COMMENT ( "only the profile index of the next entry is written" );
+	UT_PRECONDITION ( SNESProfiles_Select ( &ut_profiles, 1, &ut_mapper ) );
+	UT_PRECONDITION ( SNESProfiles_WriteStep ( &ut_profiles ) );
+	SNESProfiles_Init ( &ut_profiles, UT_WriteByte, UT_ReadByte, EEPROM_BASE, ut_defaults );
+	UT_TEST ( SNESProfiles_GetSelected ( &ut_profiles ) == 2 );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
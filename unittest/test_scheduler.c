@@ -0,0 +1,209 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_scheduler.c
+ * @brief   unittest implementation for SNESScheduler
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+static uint32_t ut_calls[3];      /**< number of executions per task */
+static char     ut_order[64];     /**< execution order, one letter per task */
+static uint8_t  ut_order_len;     /**< length of ut_order */
+
+/**
+ * @brief  records execution of a task
+ * @param  id of the task
+ */
+static void UT_Record ( uint8_t id )
+{
+	ut_calls[id]++;
+
+	if ( ut_order_len < ( sizeof ( ut_order ) - 1 ) )
+	{
+		ut_order[ut_order_len++] = ( char ) ( 'a' + id );
+		ut_order[ut_order_len] = '\0';
+	}
+}
+
+static void UT_TaskA ( void ) { UT_Record ( 0 ); }  /**< task with the highest priority */
+static void UT_TaskB ( void ) { UT_Record ( 1 ); }  /**< task with medium priority */
+static void UT_TaskC ( void ) { UT_Record ( 2 ); }  /**< task with the lowest priority */
+
+/**
+ * @brief  clears the recorded executions
+ */
+static void UT_Clear ( void )
+{
+	memset ( ut_calls, 0, sizeof ( ut_calls ) );
+	ut_order[0] = '\0';
+	ut_order_len = 0;
+}
+
+/**
+ * @brief          dispatches until idle
+ * @param[in, out] sched is the scheduler under test
+ * @returns        number of executed tasks
+ */
+static uint16_t UT_RunIdle ( SNESScheduler * sched )
+{
+	uint16_t runs = 0;
+
+	while ( SNESScheduler_Dispatch ( sched ) )
+	{
+		runs++;
+	}
+
+	return runs;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	uint16_t cnt;
+	SNESScheduler ut_sched;  /**< scheduler instance under test */
+	SNESSchedulerStats stats;
+	SNESTask ut_tasks[3] =
+	{
+		{ UT_TaskA, 1, 0 },
+		{ UT_TaskB, 4, 2 },
+		{ UT_TaskC, 4, 0 },
+	};
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESScheduler()" );
+	UT_TESTCASE ( "Object init" );
+	UT_Clear();
+	SNESScheduler_Init ( &ut_sched, ut_tasks, 3 );
+	UT_TEST ( SNESScheduler_Dispatch ( &ut_sched ) == false );
+	UT_TEST ( ut_tasks[1].countdown == 2 );
+	UT_TEST ( ut_tasks[2].countdown == 4 );
+	UT_TESTCASE ( "Period and phase offset" );
+
+	for ( cnt = 0; cnt < 8; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+		( void ) UT_RunIdle ( &ut_sched );
+	}
+
+	UT_COMMENT ( ut_order );
+	UT_TEST ( strcmp ( ut_order, "aabaacaabaac" ) == 0 );
+	UT_TEST ( SNESScheduler_GetOverruns ( &ut_sched, 0 ) == 0 );
+	UT_TESTCASE ( "Priority follows the table order" );
+	UT_Clear();
+
+	for ( cnt = 0; cnt < 4; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+	}
+
+	UT_TEST ( UT_RunIdle ( &ut_sched ) == 6 );
+	UT_COMMENT ( ut_order );
+	UT_TEST ( strcmp ( ut_order, "aaaabc" ) == 0 );
+	UT_TESTCASE ( "Backlog is not lost and counted as overrun" );
+	UT_TEST ( SNESScheduler_GetOverruns ( &ut_sched, 0 ) == 3 );
+	UT_TEST ( SNESScheduler_GetOverruns ( &ut_sched, 1 ) == 0 );
+	UT_TESTCASE ( "Instrumentation counters" );
+	SNESScheduler_GetStats ( &ut_sched, &stats );
+	UT_TEST ( stats.missed_ticks == 3 );
+	UT_TEST ( stats.max_backlog == 4 );
+	UT_TEST ( stats.max_iteration == 0 );
+	SNESScheduler_ReportIteration ( &ut_sched, 120 );
+	SNESScheduler_ReportIteration ( &ut_sched, 80 );
+	SNESScheduler_GetStats ( &ut_sched, &stats );
+	UT_TEST ( stats.max_iteration == 120 );
+	UT_TEST ( SNESScheduler_GetTicks ( &ut_sched ) == 12 );
+	SNESScheduler_ResetStats ( &ut_sched );
+	SNESScheduler_GetStats ( &ut_sched, &stats );
+	UT_TEST ( ( stats.missed_ticks == 0 ) && ( stats.max_backlog == 0 ) && ( stats.max_iteration == 0 ) );
+	UT_Clear();
+
+	for ( cnt = 0; cnt < 200; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+	}
+
+	UT_TEST ( UT_RunIdle ( &ut_sched ) == 300 );
+	UT_TEST ( ut_calls[0] == 200 );
+	UT_TEST ( ut_calls[1] == 50 );
+	UT_TEST ( ut_calls[2] == 50 );
+	UT_TEST ( SNESScheduler_GetOverruns ( &ut_sched, 1 ) == 49 );
+	UT_TESTCASE ( "Overrun counter saturates" );
+
+	for ( cnt = 0; cnt < 200; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+	}
+
+	( void ) UT_RunIdle ( &ut_sched );
+	UT_TEST ( SNESScheduler_GetOverruns ( &ut_sched, 0 ) == 255 );
+	SNESScheduler_GetStats ( &ut_sched, &stats );
+	UT_TEST ( stats.missed_ticks == 398 );
+	UT_TEST ( stats.max_backlog == 200 );
+	UT_TESTCASE ( "Backlog beyond 255 ticks is not lost" );
+	UT_DESCRIPTION ( "E.g. a main loop blocked by EEPROM writes for 450ms" );
+	UT_Clear();
+
+	for ( cnt = 0; cnt < 2200; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+	}
+
+	UT_TEST ( UT_RunIdle ( &ut_sched ) == 3300 );
+	UT_TEST ( ut_calls[0] == 2200 );
+	UT_TEST ( ut_calls[1] == 550 );
+	UT_TEST ( ut_calls[2] == 550 );
+	UT_TEST ( SNESScheduler_IsIdle ( &ut_sched ) == true );
+	UT_DESCRIPTION ( "The stall is counted in full, the backlog saturates" );
+	SNESScheduler_GetStats ( &ut_sched, &stats );
+	UT_TEST ( stats.missed_ticks == ( 398 + 2199 ) );
+	UT_TEST ( stats.max_backlog == 255 );
+	UT_TESTCASE ( "Tick counter wraps" );
+	UT_Clear();
+
+	for ( cnt = 0; cnt < 33000; cnt++ )
+	{
+		SNESScheduler_Tick ( &ut_sched );
+		SNESScheduler_Tick ( &ut_sched );
+		( void ) UT_RunIdle ( &ut_sched );
+	}
+
+	UT_TEST ( ut_calls[0] == 66000 );
+	UT_TEST ( ut_calls[1] == 16500 );
+	UT_TEST ( ut_calls[2] == 16500 );
+	UT_TESTCASE ( "Idle until the next tick" );
+	UT_DESCRIPTION ( "Unprocessed ticks and pending tasks keep the scheduler busy" );
+	UT_TEST ( SNESScheduler_IsIdle ( &ut_sched ) == true );
+	SNESScheduler_Tick ( &ut_sched );
+	UT_TEST ( SNESScheduler_IsIdle ( &ut_sched ) == false );
+	SNESScheduler_Tick ( &ut_sched );
+	SNESScheduler_Tick ( &ut_sched );
+	SNESScheduler_Tick ( &ut_sched );
+	UT_TEST ( SNESScheduler_Dispatch ( &ut_sched ) == true );
+	UT_TEST ( SNESScheduler_IsIdle ( &ut_sched ) == false );
+	UT_TEST ( UT_RunIdle ( &ut_sched ) == 5 );
+	UT_TEST ( SNESScheduler_IsIdle ( &ut_sched ) == true );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,192 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_snapshot.c
+ * @brief   unittest implementation for SNESSnapshot
+ * @details The stress test runs a writer and several reader threads at full speed.
+ *          Every published state is self consistent: both bytes of the SNES state and the DB9 state
+ *          carry the same value, so any torn read shows as a mismatch.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+#define UT_NR_READERS     3u         /**< number of reader threads */
+#define UT_NR_PUBLISHES   2000000u   /**< publications of the writer thread */
+
+static SNESSnapshot ut_snapshot;     /**< snapshot instance under test */
+static volatile int ut_writer_done;  /**< set when the writer has finished */
+
+/**
+ * @brief  result of a reader thread
+ */
+typedef struct
+{
+	uint64_t reads;       /**< number of reads */
+	uint64_t torn;        /**< reads with inconsistent data */
+	uint64_t backwards;   /**< reads with a sequence number lower than the previous one */
+	uint64_t mismatched;  /**< reads whose data does not belong to their sequence number */
+} UT_ReaderResult;
+
+/**
+ * @brief      builds the self consistent state of a publication
+ * @param[in]  value of the publication
+ * @param[out] data state to publish
+ */
+static void UT_MakeState ( uint32_t value, SNESSnapshotData * data )
+{
+	data->snes_state = ( uint16_t ) ( ( value & 0xFFu ) * 0x0101u );
+	data->db9_state = ( uint8_t ) value;
+}
+
+/**
+ * @brief     writer thread, publishes UT_NR_PUBLISHES states
+ * @param[in] arg unused
+ * @returns   NULL
+ */
+static void * UT_Writer ( void * arg )
+{
+	SNESSnapshotData data;
+	uint32_t         value;
+	( void ) arg;
+
+	for ( value = 1; value <= UT_NR_PUBLISHES; value++ )
+	{
+		UT_MakeState ( value, &data );
+		SNESSnapshot_Publish ( &ut_snapshot, &data );
+	}
+
+	__atomic_store_n ( &ut_writer_done, 1, __ATOMIC_SEQ_CST );
+	return NULL;
+}
+
+/**
+ * @brief         reader thread, reads until the writer has finished
+ * @param[in,out] arg points to UT_ReaderResult
+ * @returns       NULL
+ */
+static void * UT_Reader ( void * arg )
+{
+	UT_ReaderResult * result = ( UT_ReaderResult * ) arg;
+	SNESSnapshotData  data;
+	SNESSnapshotSeq   sequence;
+	SNESSnapshotSeq   last = 0;
+
+	while ( __atomic_load_n ( &ut_writer_done, __ATOMIC_SEQ_CST ) == 0 )
+	{
+		sequence = SNESSnapshot_Read ( &ut_snapshot, &data );
+		result->reads++;
+
+		if ( ( ( data.snes_state >> 8 ) != ( data.snes_state & 0xFFu ) ) || ( ( data.snes_state & 0xFFu ) != data.db9_state ) )
+		{
+			result->torn++;
+		}
+
+		if ( data.db9_state != ( uint8_t ) sequence )
+		{
+			result->mismatched++;
+		}
+
+		if ( sequence < last )
+		{
+			result->backwards++;
+		}
+
+		last = sequence;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	SNESSnapshotData data;
+	pthread_t        writer;
+	pthread_t        readers[UT_NR_READERS];
+	UT_ReaderResult  results[UT_NR_READERS];
+	UT_ReaderResult  total;
+	uint32_t         idx;
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESSnapshot()" );
+	UT_TESTCASE ( "Object init" );
+	UT_DESCRIPTION ( "All released state with sequence number 0" );
+	SNESSnapshot_Init ( &ut_snapshot );
+	UT_TEST ( SNESSnapshot_Read ( &ut_snapshot, &data ) == 0 );
+	UT_TEST ( ( data.snes_state == 0 ) && ( data.db9_state == 0 ) );
+	UT_TESTCASE ( "Publish and read" );
+	data.snes_state = SNES_BTNMASK_B | SNES_BTNMASK_Up;
+	data.db9_state = DB9_BTNMASK_Fire | DB9_BTNMASK_Up;
+	SNESSnapshot_Publish ( &ut_snapshot, &data );
+	memset ( &data, 0, sizeof ( data ) );
+	UT_TEST ( SNESSnapshot_Read ( &ut_snapshot, &data ) == 1 );
+	UT_TEST ( data.snes_state == ( SNES_BTNMASK_B | SNES_BTNMASK_Up ) );
+	UT_TEST ( data.db9_state == ( DB9_BTNMASK_Fire | DB9_BTNMASK_Up ) );
+	UT_DESCRIPTION ( "Repeated reads return the same state and sequence number" );
+	UT_TEST ( SNESSnapshot_Read ( &ut_snapshot, &data ) == 1 );
+	UT_TEST ( data.snes_state == ( SNES_BTNMASK_B | SNES_BTNMASK_Up ) );
+	UT_DESCRIPTION ( "Each publication advances the sequence number and switches the buffer" );
+	data.snes_state = SNES_BTNMASK_A;
+	data.db9_state = 0;
+	SNESSnapshot_Publish ( &ut_snapshot, &data );
+	data.snes_state = SNES_BTNMASK_Y;
+	SNESSnapshot_Publish ( &ut_snapshot, &data );
+	UT_TEST ( SNESSnapshot_Read ( &ut_snapshot, &data ) == 3 );
+	UT_TEST ( ( data.snes_state == SNES_BTNMASK_Y ) && ( data.db9_state == 0 ) );
+	UT_TESTCASE ( "Concurrent writer and readers" );
+	UT_DESCRIPTION ( "No torn, stale or out of order reads while publishing at full speed" );
+	SNESSnapshot_Init ( &ut_snapshot );
+	ut_writer_done = 0;
+	memset ( results, 0, sizeof ( results ) );
+	memset ( &total, 0, sizeof ( total ) );
+
+	for ( idx = 0; idx < UT_NR_READERS; idx++ )
+	{
+		( void ) pthread_create ( &readers[idx], NULL, UT_Reader, &results[idx] );
+	}
+
+	( void ) pthread_create ( &writer, NULL, UT_Writer, NULL );
+	( void ) pthread_join ( writer, NULL );
+
+	for ( idx = 0; idx < UT_NR_READERS; idx++ )
+	{
+		( void ) pthread_join ( readers[idx], NULL );
+		total.reads += results[idx].reads;
+		total.torn += results[idx].torn;
+		total.backwards += results[idx].backwards;
+		total.mismatched += results[idx].mismatched;
+	}
+
+	printf ( "%llu reads, %llu torn, %llu mismatched, %llu backwards\n", ( unsigned long long ) total.reads,
+	         ( unsigned long long ) total.torn, ( unsigned long long ) total.mismatched, ( unsigned long long ) total.backwards );
+	UT_TEST ( total.reads > 0 );
+	UT_TEST ( total.torn == 0 );
+	UT_TEST ( total.mismatched == 0 );
+	UT_TEST ( total.backwards == 0 );
+	UT_TEST ( SNESSnapshot_Read ( &ut_snapshot, &data ) == UT_NR_PUBLISHES );
+	UT_TEST ( data.db9_state == ( uint8_t ) UT_NR_PUBLISHES );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
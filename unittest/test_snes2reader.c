@@ -70,6 +70,82 @@ static SNES2DB9_Pinstate unittest_get_pin_by_pattern ( SNES2DB9_Pin pin )
 	}
 }
 
+static uint32_t ut_time_us;             /**< simulated time, advanced by the busy wait */
+static uint32_t ut_clk_fall_us;         /**< time of the last falling CLK edge */
+static uint8_t  ut_pad_min_phase_us;    /**< shortest CLK low phase the gamepad recognizes */
+static uint16_t ut_pad_buttons;         /**< pressed buttons of the gamepad, SNES_BTNMASK_xxx */
+static uint16_t ut_pad_shiftreg;        /**< shift register of the gamepad, MSB is presented on DATA */
+static SNES2DB9_Pinstate ut_pad_clk;    /**< CLK level seen by the gamepad */
+static uint8_t  ut_eeprom[SNESREADER_STORAGE_SIZE];  /**< non-volatile storage */
+
+/**
+ * @brief     pin HAL driving a model of a slow clone gamepad
+ * @details   A rising CLK edge shifts the next bit to DATA only if the low phase before it was long enough,
+ *            pressed buttons are shifted in after the 16th bit like on an original gamepad.
+ * @param[in] pin to set
+ * @param[in] state of the pin
+ */
+static void ut_pad_set_pin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	if ( ( pin == SNES_LATCH ) && ( state == SNES2DB9_PIN_HIGH ) )
+	{
+		ut_pad_shiftreg = ut_pad_buttons;
+	}
+	else if ( pin == SNES_CLK )
+	{
+		if ( ( state == SNES2DB9_PIN_LOW ) && ( ut_pad_clk == SNES2DB9_PIN_HIGH ) )
+		{
+			ut_clk_fall_us = ut_time_us;
+		}
+		else if ( ( state == SNES2DB9_PIN_HIGH ) && ( ut_pad_clk == SNES2DB9_PIN_LOW ) && ( ( ut_time_us - ut_clk_fall_us ) >= ut_pad_min_phase_us ) )
+		{
+			ut_pad_shiftreg = ( uint16_t ) ( ( ut_pad_shiftreg << 1 ) | 1u );
+		}
+
+		ut_pad_clk = state;
+	}
+}
+
+/**
+ * @brief     pin HAL reading the DATA pin of the gamepad model
+ * @param[in] pin to read
+ * @returns   pin state
+ */
+static SNES2DB9_Pinstate ut_pad_get_pin ( SNES2DB9_Pin pin )
+{
+	( void ) pin;
+	return ( ( ut_pad_shiftreg & 0x8000u ) != 0 ) ? SNES2DB9_PIN_LOW : SNES2DB9_PIN_HIGH;
+}
+
+/**
+ * @brief     busy wait HAL advancing the simulated time
+ * @param[in] microseconds to wait
+ */
+static void ut_delay ( uint8_t microseconds )
+{
+	ut_time_us += microseconds;
+}
+
+/**
+ * @brief     storage HAL writing to ut_eeprom
+ * @param[in] address to write
+ * @param[in] value to write
+ */
+static void ut_write_byte ( uint16_t address, uint8_t value )
+{
+	ut_eeprom[address] = value;
+}
+
+/**
+ * @brief     storage HAL reading from ut_eeprom
+ * @param[in] address to read
+ * @returns   value stored
+ */
+static uint8_t ut_read_byte ( uint16_t address )
+{
+	return ut_eeprom[address];
+}
+
 /**
  * @brief main function for Unittest example
  * @param argc
@@ -78,6 +154,7 @@ static SNES2DB9_Pinstate unittest_get_pin_by_pattern ( SNES2DB9_Pin pin )
  */
 int main ( int argc, char **argv )
 {
+	static const uint8_t half_periods[] = { 100, 48, 24, 12, 6, 3 };
 	uint16_t idx, result;
 	char tmpstr[80];
 	SNESReader reader;
@@ -89,6 +166,7 @@ int main ( int argc, char **argv )
 	SNESReader_Init ( &reader, unittest_set_pin, unittest_get_pin );
 	UT_TEST ( unittest_pin_state[SNES_LATCH] == SNES2DB9_PIN_LOW );
 	UT_TEST ( unittest_pin_state[SNES_CLK] == SNES2DB9_PIN_HIGH );
+	UT_TEST ( SNESReader_IsIdle ( &reader ) == true );
 	UT_TESTCASE ( "State idle (100 cycles tested)" );
 
 	for ( idx = 1; idx <= 100; idx++ )
@@ -103,6 +181,7 @@ int main ( int argc, char **argv )
 
 	UT_TESTCASE ( "State latching (begin of read cycle)" );
 	SNESReader_BeginRead ( &reader );
+	UT_TEST ( SNESReader_IsIdle ( &reader ) == false );
 	( void ) SNESReader_Update ( &reader );
 	UT_DESCRIPTION ( "Pin levels for latching: LATCH = HIGH, CLK = HIGH" );
 	UT_TEST ( unittest_pin_state[SNES_LATCH] == SNES2DB9_PIN_HIGH );
@@ -135,12 +214,15 @@ int main ( int argc, char **argv )
 		UT_Test ( unittest_nr_read_pins == ( idx+1 ), tmpstr );
 	}
 
+	UT_TEST ( SNESReader_IsIdle ( &reader ) == false );
 	UT_TESTCASE ( "State update values" );
 	UT_DESCRIPTION ( "All keys high, no SNES buttons pressed, signals on default level" );
+	UT_DESCRIPTION ( "Reader turns idle with the update" );
 	UT_TEST ( 0xFFFF == SNESReader_Update ( &reader ) );
 	UT_TEST ( unittest_pin_state[SNES_LATCH] == SNES2DB9_PIN_LOW );
 	UT_TEST ( unittest_pin_state[SNES_CLK] == SNES2DB9_PIN_HIGH );
 	UT_TEST ( unittest_nr_read_pins == 16 );
+	UT_TEST ( SNESReader_IsIdle ( &reader ) == true );
 	SNESReader_Init ( &reader, unittest_set_pin, unittest_get_pin_by_pattern );
 	UT_TESTCASE ( "Reading defined pattern A" );
 	UT_PRECONDITION ( unittest_pinpattern = ( SNES_BTNMASK_B|SNES_BTNMASK_L ) );
@@ -166,6 +248,114 @@ int main ( int argc, char **argv )
 
 	UT_TEST ( result == ( SNES_BTNMASK_Up ) );
 	UT_TEST ( unittest_nr_read_pins == 16 );
+	UT_TESTCASE ( "Reading in a single update" );
+	SNESReader_Init ( &reader, ut_pad_set_pin, ut_pad_get_pin );
+	SNESReader_SetDelayFunc ( &reader, ut_delay );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 0 );
+	SNESReader_SetHalfPeriod ( &reader, 6 );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 6 );
+	UT_PRECONDITION ( ut_pad_buttons = ( SNES_BTNMASK_Y | SNES_BTNMASK_R ) );
+	UT_PRECONDITION ( ut_time_us = 0 );
+	SNESReader_BeginRead ( &reader );
+	UT_DESCRIPTION ( "Complete reading with a busy wait of a half period after each step but the last" );
+	UT_TEST ( SNESReader_Update ( &reader ) == ( SNES_BTNMASK_Y | SNES_BTNMASK_R ) );
+	UT_TEST ( SNESReader_IsIdle ( &reader ) == true );
+	UT_TEST ( ut_time_us == ( 32u * 6u ) );
+	UT_DESCRIPTION ( "Further updates while idle do not wait" );
+	( void ) SNESReader_Update ( &reader );
+	UT_TEST ( ut_time_us == ( 32u * 6u ) );
+	UT_TESTCASE ( "Reading with a busy wait limit" );
+	SNESReader_SetWaitLimit ( &reader, 24 );
+	UT_PRECONDITION ( ut_pad_buttons = ( SNES_BTNMASK_B | SNES_BTNMASK_Left ) );
+	SNESReader_BeginRead ( &reader );
+	UT_DESCRIPTION ( "Five steps per update with four busy waits, 200µs between the updates" );
+
+	for ( idx = 0; ( idx < 40 ) && ( SNESReader_IsIdle ( &reader ) == false ); idx++ )
+	{
+		UT_PRECONDITION ( ut_time_us = 0 );
+		result = SNESReader_Update ( &reader );
+		UT_TEST ( ut_time_us <= 24u );
+		UT_PRECONDITION ( ut_time_us = 200 );
+	}
+
+	UT_TEST ( idx == 7 );
+	UT_TEST ( result == ( SNES_BTNMASK_B | SNES_BTNMASK_Left ) );
+	UT_DESCRIPTION ( "Half period above the limit performs one step per update without waits" );
+	SNESReader_SetHalfPeriod ( &reader, 48 );
+	UT_PRECONDITION ( ut_time_us = 0 );
+	SNESReader_BeginRead ( &reader );
+
+	for ( idx = 0; ( idx < 40 ) && ( SNESReader_IsIdle ( &reader ) == false ); idx++ )
+	{
+		( void ) SNESReader_Update ( &reader );
+	}
+
+	UT_TEST ( idx == 33 );
+	UT_TEST ( ut_time_us == 0 );
+	SNESReader_SetWaitLimit ( &reader, SNESREADER_WAIT_UNLIMITED );
+	SNESReader_SetHalfPeriod ( &reader, 6 );
+	UT_PRECONDITION ( ut_pad_buttons = ( SNES_BTNMASK_Y | SNES_BTNMASK_R ) );
+	SNESReader_BeginRead ( &reader );
+	( void ) SNESReader_Update ( &reader );
+	UT_TESTCASE ( "Trailer bits" );
+	UT_TEST ( SNESReader_IsValid ( SNES_BTNMASK_B | SNES_BTNMASK_R ) == true );
+	UT_TEST ( SNESReader_IsValid ( 0 ) == true );
+	UT_TEST ( SNESReader_IsValid ( 0x0001 ) == false );
+	UT_TEST ( SNESReader_IsValid ( 0xFFFF ) == false );
+	UT_TESTCASE ( "Calibration" );
+	UT_DESCRIPTION ( "Gamepad needing a low phase of 10µs settles on 12µs" );
+	UT_PRECONDITION ( ut_pad_buttons = SNES_BTNMASK_Start );
+	UT_PRECONDITION ( ut_pad_min_phase_us = 10 );
+	UT_TEST ( SNESReader_Calibrate ( &reader, SNES_BTNMASK_Start, half_periods, sizeof ( half_periods ), 4 ) == 12 );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 12 );
+	UT_DESCRIPTION ( "Calibration readings ignore the busy wait limit" );
+	SNESReader_SetWaitLimit ( &reader, 24 );
+	UT_TEST ( SNESReader_Calibrate ( &reader, SNES_BTNMASK_Start, half_periods, sizeof ( half_periods ), 4 ) == 12 );
+	SNESReader_SetWaitLimit ( &reader, SNESREADER_WAIT_UNLIMITED );
+	UT_DESCRIPTION ( "Failed readings do not replace the last result" );
+	UT_TEST ( SNESReader_Update ( &reader ) == ( SNES_BTNMASK_Y | SNES_BTNMASK_R ) );
+	SNESReader_BeginRead ( &reader );
+	UT_TEST ( SNESReader_Update ( &reader ) == SNES_BTNMASK_Start );
+	UT_DESCRIPTION ( "Fast gamepad settles on the fastest half period" );
+	UT_PRECONDITION ( ut_pad_min_phase_us = 0 );
+	UT_TEST ( SNESReader_Calibrate ( &reader, SNES_BTNMASK_Start, half_periods, sizeof ( half_periods ), 4 ) == 3 );
+	UT_DESCRIPTION ( "Missed edges with nothing pressed are not detected, the held button reveals them" );
+	UT_PRECONDITION ( ut_pad_min_phase_us = 200 );
+	UT_PRECONDITION ( ut_pad_buttons = 0 );
+	UT_TEST ( SNESReader_Calibrate ( &reader, 0, half_periods, sizeof ( half_periods ), 4 ) == 3 );
+	UT_PRECONDITION ( ut_pad_buttons = SNES_BTNMASK_Start );
+	UT_DESCRIPTION ( "Too slow gamepad selects one step per update" );
+	UT_TEST ( SNESReader_Calibrate ( &reader, SNES_BTNMASK_Start, half_periods, sizeof ( half_periods ), 4 ) == 0 );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 0 );
+	UT_DESCRIPTION ( "Expected state with trailer bits set is rejected without readings" );
+	UT_PRECONDITION ( ut_time_us = 0 );
+	UT_TEST ( SNESReader_Calibrate ( &reader, 0xFFFF, half_periods, sizeof ( half_periods ), 4 ) == 0 );
+	UT_TEST ( ut_time_us == 0 );
+	UT_TESTCASE ( "Non-volatile storage" );
+	UT_DESCRIPTION ( "Erased storage is rejected, timing unchanged" );
+	memset ( ut_eeprom, 0xFF, sizeof ( ut_eeprom ) );
+	SNESReader_SetHalfPeriod ( &reader, 24 );
+	UT_TEST ( SNESReader_LoadHalfPeriod ( &reader, ut_read_byte, 0, half_periods, sizeof ( half_periods ) ) == false );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 24 );
+	UT_DESCRIPTION ( "Stored timing is restored" );
+	SNESReader_SaveHalfPeriod ( &reader, ut_write_byte, 0 );
+	SNESReader_Init ( &reader, ut_pad_set_pin, ut_pad_get_pin );
+	SNESReader_SetDelayFunc ( &reader, ut_delay );
+	UT_TEST ( SNESReader_LoadHalfPeriod ( &reader, ut_read_byte, 0, half_periods, sizeof ( half_periods ) ) == true );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 24 );
+	UT_DESCRIPTION ( "Corrupted storage is rejected" );
+	ut_eeprom[1] ^= 0x10;
+	UT_TEST ( SNESReader_LoadHalfPeriod ( &reader, ut_read_byte, 0, half_periods, sizeof ( half_periods ) ) == false );
+	UT_DESCRIPTION ( "Half period with a matching complement but not probed is rejected" );
+	ut_write_byte ( 0, 200 );
+	ut_write_byte ( 1, ( uint8_t ) ~200u );
+	UT_TEST ( SNESReader_LoadHalfPeriod ( &reader, ut_read_byte, 0, half_periods, sizeof ( half_periods ) ) == false );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 24 );
+	UT_DESCRIPTION ( "Stored failed calibration selects one step per update" );
+	ut_write_byte ( 0, 0 );
+	ut_write_byte ( 1, 0xFF );
+	UT_TEST ( SNESReader_LoadHalfPeriod ( &reader, ut_read_byte, 0, half_periods, sizeof ( half_periods ) ) == true );
+	UT_TEST ( SNESReader_GetHalfPeriod ( &reader ) == 0 );
 	UT_END();
 #ifdef GCOV_ENABLED
 	return 0;
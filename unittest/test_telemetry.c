@@ -0,0 +1,147 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_telemetry.c
+ * @brief   unittest implementation for SNESTelemetry
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+static SNES2DB9_Pinstate ut_line[SNESTELEMETRY_FRAME_SIZE * SNESTELEMETRY_BITS_PER_BYTE * 2];  /**< TX line levels per bit time */
+static uint16_t          ut_line_len;                                                          /**< number of recorded bit times */
+
+/**
+ * @brief          records the TX line until the transmission has finished
+ * @param[in, out] telemetry is the instance under test
+ */
+static void UT_Transmit ( SNESTelemetry * telemetry )
+{
+	ut_line_len = 0;
+
+	while ( ( SNESTelemetry_IsBusy ( telemetry ) == true ) && ( ut_line_len < ( sizeof ( ut_line ) / sizeof ( ut_line[0] ) ) ) )
+	{
+		ut_line[ut_line_len++] = SNESTelemetry_Update ( telemetry );
+	}
+}
+
+/**
+ * @brief      decodes the recorded TX line as 8N1 UART bytes
+ * @param[out] bytes decoded
+ * @param[in]  max_bytes to decode
+ * @returns    number of decoded bytes, stops at the first framing error
+ */
+static uint8_t UT_Receive ( uint8_t * bytes, uint8_t max_bytes )
+{
+	uint8_t  count = 0;
+	uint16_t pos = 0;
+	uint8_t  bit;
+
+	while ( ( count < max_bytes ) && ( ( pos + SNESTELEMETRY_BITS_PER_BYTE ) <= ut_line_len ) )
+	{
+		if ( ( ut_line[pos] != SNES2DB9_PIN_LOW ) || ( ut_line[pos + 9u] != SNES2DB9_PIN_HIGH ) )
+		{
+			break;
+		}
+
+		bytes[count] = 0;
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			if ( ut_line[pos + 1u + bit] == SNES2DB9_PIN_HIGH )
+			{
+				bytes[count] |= ( uint8_t ) ( 1u << bit );
+			}
+		}
+
+		count++;
+		pos += SNESTELEMETRY_BITS_PER_BYTE;
+	}
+
+	return count;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	static const uint8_t check[] = "123456789";
+	SNESTelemetry     ut_telemetry;  /**< telemetry instance under test */
+	SNESTelemetryData data;
+	uint8_t           frame[SNESTELEMETRY_FRAME_SIZE];
+	uint8_t           received[SNESTELEMETRY_FRAME_SIZE + 1];
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESTelemetry()" );
+	UT_TESTCASE ( "Object init" );
+	UT_DESCRIPTION ( "TX line idles high" );
+	SNESTelemetry_Init ( &ut_telemetry );
+	UT_TEST ( SNESTelemetry_IsBusy ( &ut_telemetry ) == false );
+	UT_TEST ( SNESTelemetry_Update ( &ut_telemetry ) == SNES2DB9_PIN_HIGH );
+	UT_TESTCASE ( "CRC-8" );
+	UT_DESCRIPTION ( "Check value of polynomial 0x07" );
+	UT_TEST ( SNESTelemetry_Crc8 ( check, 9 ) == 0xF4 );
+	UT_TEST ( SNESTelemetry_Crc8 ( check, 0 ) == 0x00 );
+	UT_TESTCASE ( "Frame layout" );
+	data.snes_state = SNES_BTNMASK_B | SNES_BTNMASK_R;
+	data.db9_state = DB9_BTNMASK_Fire | DB9_BTNMASK_Up;
+	data.status = 0x5A;
+	data.timing.missed_ticks = 0x1234;
+	data.timing.max_backlog = 3;
+	data.timing.max_iteration = 0xABCD;
+	SNESTelemetry_Encode ( &data, 0x42, frame );
+	UT_TEST ( frame[0] == SNESTELEMETRY_SYNC );
+	UT_TEST ( frame[1] == 0x42 );
+	UT_TEST ( ( frame[2] == 0x10 ) && ( frame[3] == 0x80 ) );
+	UT_TEST ( frame[4] == ( DB9_BTNMASK_Fire | DB9_BTNMASK_Up ) );
+	UT_TEST ( frame[5] == 0x5A );
+	UT_TEST ( ( frame[6] == 0x34 ) && ( frame[7] == 0x12 ) );
+	UT_TEST ( frame[8] == 3 );
+	UT_TEST ( ( frame[9] == 0xCD ) && ( frame[10] == 0xAB ) );
+	UT_DESCRIPTION ( "CRC excludes the sync byte, a valid frame checks to 0" );
+	UT_TEST ( frame[11] == SNESTelemetry_Crc8 ( &frame[1], SNESTELEMETRY_FRAME_SIZE - 2 ) );
+	UT_TEST ( SNESTelemetry_Crc8 ( &frame[1], SNESTELEMETRY_FRAME_SIZE - 1 ) == 0 );
+	UT_TESTCASE ( "Send while idle" );
+	UT_TEST ( SNESTelemetry_Send ( &ut_telemetry, &data ) == true );
+	UT_TEST ( SNESTelemetry_IsBusy ( &ut_telemetry ) == true );
+	UT_DESCRIPTION ( "Send while busy is rejected" );
+	UT_TEST ( SNESTelemetry_Send ( &ut_telemetry, &data ) == false );
+	UT_TESTCASE ( "UART bit stream" );
+	UT_DESCRIPTION ( "8N1, LSB first, one bit per update, first frame has sequence number 0" );
+	UT_Transmit ( &ut_telemetry );
+	UT_TEST ( ut_line_len == ( SNESTELEMETRY_FRAME_SIZE * SNESTELEMETRY_BITS_PER_BYTE ) );
+	UT_TEST ( SNESTelemetry_IsBusy ( &ut_telemetry ) == false );
+	UT_TEST ( SNESTelemetry_Update ( &ut_telemetry ) == SNES2DB9_PIN_HIGH );
+	SNESTelemetry_Encode ( &data, 0, frame );
+	UT_TEST ( UT_Receive ( received, SNESTELEMETRY_FRAME_SIZE ) == SNESTELEMETRY_FRAME_SIZE );
+	UT_TEST ( memcmp ( received, frame, SNESTELEMETRY_FRAME_SIZE ) == 0 );
+	UT_TESTCASE ( "Sequence number" );
+	UT_DESCRIPTION ( "Next frame has sequence number 1" );
+	data.snes_state = 0;
+	UT_TEST ( SNESTelemetry_Send ( &ut_telemetry, &data ) == true );
+	UT_Transmit ( &ut_telemetry );
+	SNESTelemetry_Encode ( &data, 1, frame );
+	UT_TEST ( UT_Receive ( received, SNESTELEMETRY_FRAME_SIZE ) == SNESTELEMETRY_FRAME_SIZE );
+	UT_TEST ( memcmp ( received, frame, SNESTELEMETRY_FRAME_SIZE ) == 0 );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
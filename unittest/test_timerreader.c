@@ -0,0 +1,150 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    test_timerreader.c
+ * @brief   unittest implementation for SNESTimerReader
+ * @details The SNES gamepad is modelled as the 16 bit parallel in/serial out shift register it contains:
+ *          LATCH loads the buttons, every rising CLK edge shifts the next button to DATA.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "snes2db9.h"   /* object to test */
+
+#include "unittest.h"      /* unittest framework access */
+
+/**
+ * @brief  model of the SNES gamepad shift register
+ */
+typedef struct
+{
+	uint16_t buttons;   /**< pressed buttons, SNES_BTNMASK_xxx */
+	uint16_t shiftreg;  /**< shift register, MSB is presented on DATA */
+} UT_Gamepad;
+
+/**
+ * @brief          LATCH pulse, loads the pressed buttons
+ * @param[in, out] pad model
+ */
+static void UT_Latch ( UT_Gamepad * pad )
+{
+	pad->shiftreg = pad->buttons;
+}
+
+/**
+ * @brief     level of the DATA pin, low for a pressed button
+ * @param[in] pad model
+ * @returns   pin state
+ */
+static SNES2DB9_Pinstate UT_Data ( const UT_Gamepad * pad )
+{
+	return ( ( pad->shiftreg & 0x8000u ) != 0 ) ? SNES2DB9_PIN_LOW : SNES2DB9_PIN_HIGH;
+}
+
+/**
+ * @brief          runs the CLK timer after the LATCH pulse until the compare interrupt stops it
+ * @param[in, out] reader under test
+ * @param[in, out] pad model
+ * @param[in]      max_edges falling CLK edges generated at most
+ * @returns        number of falling CLK edges until the timer was stopped
+ */
+static uint8_t UT_RunTimer ( SNESTimerReader * reader, UT_Gamepad * pad, uint8_t max_edges )
+{
+	uint8_t edges = 0;
+
+	while ( edges < max_edges )
+	{
+		/* falling edge with compare interrupt: */
+		edges++;
+
+		if ( SNESTimerReader_Sample ( reader, UT_Data ( pad ) ) == true )
+		{
+			break;
+		}
+
+		/* rising edge at the end of the timer period: */
+		pad->shiftreg <<= 1;
+	}
+
+	return edges;
+}
+
+/**
+ * @brief main function for Unittest example
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main ( int argc, char **argv )
+{
+	SNESTimerReader ut_reader;  /**< reader instance under test */
+	UT_Gamepad      pad;
+	uint16_t        snes_state;
+	UT_ENABLE_HTML();
+	UT_BEGIN ( "Unittest SNESTimerReader()" );
+	UT_TESTCASE ( "Object init" );
+	UT_DESCRIPTION ( "Idle with all released state" );
+	SNESTimerReader_Init ( &ut_reader );
+	UT_TEST ( SNESTimerReader_IsIdle ( &ut_reader ) == true );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 0 );
+	UT_TEST ( snes_state == 0 );
+	UT_TESTCASE ( "Complete reading" );
+	UT_DESCRIPTION ( "Timer is stopped after 16 falling CLK edges, the first bit is button B" );
+	pad.buttons = SNES_BTNMASK_B | SNES_BTNMASK_Left | SNES_BTNMASK_R;
+	UT_Latch ( &pad );
+	SNESTimerReader_BeginRead ( &ut_reader );
+	UT_TEST ( SNESTimerReader_IsIdle ( &ut_reader ) == false );
+	UT_TEST ( UT_RunTimer ( &ut_reader, &pad, 32 ) == SNESTIMERREADER_BITS );
+	UT_TEST ( SNESTimerReader_IsIdle ( &ut_reader ) == true );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 1 );
+	UT_TEST ( snes_state == ( SNES_BTNMASK_B | SNES_BTNMASK_Left | SNES_BTNMASK_R ) );
+	UT_DESCRIPTION ( "All buttons and no buttons" );
+	pad.buttons = 0xFFFF;
+	UT_Latch ( &pad );
+	SNESTimerReader_BeginRead ( &ut_reader );
+	( void ) UT_RunTimer ( &ut_reader, &pad, 32 );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 2 );
+	UT_TEST ( snes_state == 0xFFFF );
+	pad.buttons = 0;
+	UT_Latch ( &pad );
+	SNESTimerReader_BeginRead ( &ut_reader );
+	( void ) UT_RunTimer ( &ut_reader, &pad, 32 );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 3 );
+	UT_TEST ( snes_state == 0 );
+	UT_TESTCASE ( "Partial reading" );
+	UT_DESCRIPTION ( "The previous reading stays valid until the last bit has been sampled" );
+	pad.buttons = SNES_BTNMASK_Start;
+	UT_Latch ( &pad );
+	SNESTimerReader_BeginRead ( &ut_reader );
+	UT_TEST ( UT_RunTimer ( &ut_reader, &pad, 15 ) == 15 );
+	UT_TEST ( SNESTimerReader_IsIdle ( &ut_reader ) == false );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 3 );
+	UT_TEST ( snes_state == 0 );
+	UT_DESCRIPTION ( "A new reading discards the reading in progress" );
+	pad.buttons = SNES_BTNMASK_Y | SNES_BTNMASK_A;
+	UT_Latch ( &pad );
+	SNESTimerReader_BeginRead ( &ut_reader );
+	UT_TEST ( UT_RunTimer ( &ut_reader, &pad, 32 ) == SNESTIMERREADER_BITS );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 4 );
+	UT_TEST ( snes_state == ( SNES_BTNMASK_Y | SNES_BTNMASK_A ) );
+	UT_TESTCASE ( "Interrupt while idle" );
+	UT_DESCRIPTION ( "A late compare interrupt stops the timer without a new reading" );
+	UT_TEST ( SNESTimerReader_Sample ( &ut_reader, SNES2DB9_PIN_LOW ) == true );
+	UT_TEST ( SNESTimerReader_GetState ( &ut_reader, &snes_state ) == 4 );
+	UT_TEST ( snes_state == ( SNES_BTNMASK_Y | SNES_BTNMASK_A ) );
+	UT_END();
+#ifdef GCOV_ENABLED
+	return 0;
+#else
+	return UT_Result;
+#endif
+}
+
+/** @} */
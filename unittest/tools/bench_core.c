@@ -0,0 +1,380 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    bench_core.c
+ * @brief   microbenchmark of the common core hot path
+ * @details Each core function is timed in batches against stub HALs.
+ *          The per batch cost in ns/op is summarized as min/median/p99 over all batches.
+ *          Use a Release build, the default Coverage build times instrumented code.
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snes2db9.h"
+
+#define DEFAULT_BATCHES     101u      /**< number of timed batches per benchmark */
+#define DEFAULT_ITERATIONS  100000u   /**< number of calls per batch */
+
+/**
+ * @brief result of a single benchmark
+ */
+typedef struct
+{
+	const char * name;       /**< benchmark name */
+	double       min_ns;     /**< fastest batch in ns/op */
+	double       median_ns;  /**< median batch in ns/op */
+	double       p99_ns;     /**< 99th percentile batch in ns/op */
+} BenchResult;
+
+/**
+ * @brief prototype of a benchmark body running the given number of calls
+ */
+typedef void ( *BenchFunc ) ( uint32_t iterations );
+
+static volatile uint32_t Sink;         /**< keeps results alive */
+static uint32_t          PinWrites;    /**< counts stub HAL writes */
+static uint32_t          DataPattern;  /**< pseudo random DATA levels of the stub HAL */
+
+/**
+ * @brief     stub HAL to set pins
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+static void StubSetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	PinWrites += ( uint32_t ) pin + ( uint32_t ) state;
+}
+
+/**
+ * @brief     stub HAL to read pins
+ * @param[in] pin to read
+ * @returns   pseudo random level
+ */
+static SNES2DB9_Pinstate StubReadPin ( SNES2DB9_Pin pin )
+{
+	( void ) pin;
+	DataPattern = ( DataPattern >> 1 ) | ( ( DataPattern ^ ( DataPattern >> 3 ) ) << 31 );
+	return ( ( DataPattern & 1u ) != 0 ) ? SNES2DB9_PIN_LOW : SNES2DB9_PIN_HIGH;
+}
+
+/**
+ * @brief     SNESReader_Update() over complete reading cycles, restarted like the DB9 update task does
+ * @param[in] iterations to run
+ */
+static void BenchReaderUpdate ( uint32_t iterations )
+{
+	static SNESReader reader;
+	static bool initialized = false;
+	static uint8_t phase = 0;  /* position in the reading cycle, kept across batches */
+	uint32_t idx;
+	uint16_t acc = 0;
+
+	if ( initialized == false )
+	{
+		SNESReader_Init ( &reader, StubSetPin, StubReadPin );
+		initialized = true;
+	}
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		if ( phase == 0 )
+		{
+			SNESReader_BeginRead ( &reader );
+		}
+
+		phase = ( uint8_t ) ( ( phase + 1u ) % 34u );
+		acc ^= SNESReader_Update ( &reader );
+	}
+
+	Sink += acc;
+}
+
+/**
+ * @brief     SNESReader_Update() in idle state between readings
+ * @param[in] iterations to run
+ */
+static void BenchReaderIdle ( uint32_t iterations )
+{
+	static SNESReader reader;
+	uint32_t idx;
+	uint16_t acc = 0;
+	SNESReader_Init ( &reader, StubSetPin, StubReadPin );
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		acc ^= SNESReader_Update ( &reader );
+	}
+
+	Sink += acc;
+}
+
+/**
+ * @brief     SNESMapper_Update() with the ATtiny84 configuration over changing inputs
+ * @param[in] iterations to run
+ */
+static void BenchMapperUpdate ( uint32_t iterations )
+{
+	static SNESMapper mapper;
+	static bool initialized = false;
+	SNESMapperButtonMasks masks = { SNES_BTNMASK_B, SNES_BTNMASK_Y, SNES_BTNMASK_A };
+	uint32_t idx;
+	uint8_t  acc = 0;
+
+	if ( initialized == false )
+	{
+		SNESMapper_Init ( &mapper, &masks );
+		SNESMapper_SetAutofireDuration ( &mapper, 16 );
+		initialized = true;
+	}
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		acc ^= SNESMapper_Update ( &mapper, ( uint16_t ) ( idx * 0x9E37u ), 16 );
+	}
+
+	Sink += acc;
+}
+
+/**
+ * @brief     DB9_SetPins() over changing states
+ * @param[in] iterations to run
+ */
+static void BenchSetPins ( uint32_t iterations )
+{
+	uint32_t idx;
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		DB9_SetPins ( ( uint8_t ) ( idx * 0x3Bu ), StubSetPin );
+	}
+
+	Sink += PinWrites;
+}
+
+/**
+ * @brief     CD32Pad_Update() over changing inputs
+ * @param[in] iterations to run
+ */
+static void BenchCD32Update ( uint32_t iterations )
+{
+	static CD32Pad pad;
+	uint32_t idx;
+	CD32Pad_Init ( &pad );
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		CD32Pad_Update ( &pad, ( uint16_t ) ( idx * 0x9E37u ) );
+	}
+
+	Sink += pad.image;
+}
+
+/**
+ * @brief     CD32Pad_Clock() as called from the host clock interrupt
+ * @param[in] iterations to run
+ */
+static void BenchCD32Clock ( uint32_t iterations )
+{
+	static CD32Pad pad;
+	uint32_t idx;
+	uint32_t acc = 0;
+	CD32Pad_Init ( &pad );
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		acc += ( ( idx & 15u ) == 0 ) ? CD32Pad_Load ( &pad ) : CD32Pad_Clock ( &pad );
+	}
+
+	Sink += acc;
+}
+
+/**
+ * @brief     SNESPaddle_Update() over changing inputs
+ * @param[in] iterations to run
+ */
+static void BenchPaddleUpdate ( uint32_t iterations )
+{
+	static SNESPaddle paddle;
+	uint32_t idx;
+	uint32_t acc = 0;
+	SNESPaddle_Init ( &paddle );
+
+	for ( idx = 0; idx < iterations; idx++ )
+	{
+		acc += SNESPaddle_Update ( &paddle, ( uint16_t ) ( idx * 0x9E37u ), 16 );
+	}
+
+	Sink += acc;
+}
+
+/**
+ * @brief     monotonic time stamp
+ * @returns   time in ns
+ */
+static uint64_t NowNs ( void )
+{
+	struct timespec ts;
+	clock_gettime ( CLOCK_MONOTONIC, &ts );
+	return ( ( uint64_t ) ts.tv_sec * 1000000000ull ) + ( uint64_t ) ts.tv_nsec;
+}
+
+/**
+ * @brief     comparison function for qsort()
+ * @param[in] a first value
+ * @param[in] b second value
+ * @returns   ordering of a and b
+ */
+static int CompareDouble ( const void * a, const void * b )
+{
+	double va = *( const double * ) a;
+	double vb = *( const double * ) b;
+	return ( va > vb ) - ( va < vb );
+}
+
+/**
+ * @brief      runs a benchmark in batches
+ * @param[in]  name of the benchmark
+ * @param[in]  func benchmark body
+ * @param[in]  batches to time
+ * @param[in]  iterations per batch
+ * @param[out] result summary
+ */
+static void RunBench ( const char * name, BenchFunc func, uint32_t batches, uint32_t iterations, BenchResult * result )
+{
+	double * samples = malloc ( batches * sizeof ( double ) );
+	uint32_t idx;
+	uint64_t start;
+
+	if ( samples == NULL )
+	{
+		fprintf ( stderr, "out of memory\n" );
+		exit ( 1 );
+	}
+
+	/* warm up caches and branch predictors: */
+	func ( iterations );
+
+	for ( idx = 0; idx < batches; idx++ )
+	{
+		start = NowNs();
+		func ( iterations );
+		samples[idx] = ( double ) ( NowNs() - start ) / iterations;
+	}
+
+	qsort ( samples, batches, sizeof ( double ), CompareDouble );
+	result->name = name;
+	result->min_ns = samples[0];
+	result->median_ns = samples[batches / 2];
+	result->p99_ns = samples[ ( uint32_t ) ( ( ( uint64_t ) batches * 99u ) / 100u ) ];
+	free ( samples );
+}
+
+/**
+ * @brief main function of the core benchmark
+ * @details Options: --json for machine readable output, --batches N, --iterations N
+ * @param argc
+ * @param argv
+ * @return 0 on success
+ */
+int main ( int argc, char **argv )
+{
+	static const struct
+	{
+		const char * name;
+		BenchFunc    func;
+	} benches[] =
+	{
+		{ "SNESReader_Update",      BenchReaderUpdate },
+		{ "SNESReader_Update_idle", BenchReaderIdle   },
+		{ "SNESMapper_Update",      BenchMapperUpdate },
+		{ "DB9_SetPins",            BenchSetPins      },
+		{ "CD32Pad_Update",         BenchCD32Update   },
+		{ "CD32Pad_Clock",          BenchCD32Clock    },
+		{ "SNESPaddle_Update",      BenchPaddleUpdate },
+	};
+	BenchResult results[sizeof ( benches ) / sizeof ( benches[0] )];
+	uint32_t batches = DEFAULT_BATCHES;
+	uint32_t iterations = DEFAULT_ITERATIONS;
+	bool     json = false;
+	int      arg;
+	size_t   idx;
+
+	for ( arg = 1; arg < argc; arg++ )
+	{
+		if ( strcmp ( argv[arg], "--json" ) == 0 )
+		{
+			json = true;
+		}
+		else if ( ( strcmp ( argv[arg], "--batches" ) == 0 ) && ( ( arg + 1 ) < argc ) )
+		{
+			batches = ( uint32_t ) strtoul ( argv[++arg], NULL, 0 );
+		}
+		else if ( ( strcmp ( argv[arg], "--iterations" ) == 0 ) && ( ( arg + 1 ) < argc ) )
+		{
+			iterations = ( uint32_t ) strtoul ( argv[++arg], NULL, 0 );
+		}
+		else
+		{
+			fprintf ( stderr, "usage: %s [--json] [--batches N] [--iterations N]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	if ( ( batches == 0 ) || ( iterations == 0 ) )
+	{
+		fprintf ( stderr, "batches and iterations must be non-zero\n" );
+		return 1;
+	}
+
+#ifdef GCOV_ENABLED
+	fprintf ( stderr, "warning: coverage instrumented build, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n" );
+#endif
+
+	for ( idx = 0; idx < ( sizeof ( benches ) / sizeof ( benches[0] ) ); idx++ )
+	{
+		RunBench ( benches[idx].name, benches[idx].func, batches, iterations, &results[idx] );
+	}
+
+	if ( json == true )
+	{
+		printf ( "{\n  \"batches\": %u,\n  \"iterations\": %u,\n", batches, iterations );
+#ifdef GCOV_ENABLED
+		printf ( "  \"instrumented\": true,\n" );
+#else
+		printf ( "  \"instrumented\": false,\n" );
+#endif
+		printf ( "  \"unit\": \"ns/op\",\n  \"results\": [\n" );
+
+		for ( idx = 0; idx < ( sizeof ( benches ) / sizeof ( benches[0] ) ); idx++ )
+		{
+			printf ( "    { \"name\": \"%s\", \"min\": %.3f, \"median\": %.3f, \"p99\": %.3f }%s\n",
+			         results[idx].name, results[idx].min_ns, results[idx].median_ns, results[idx].p99_ns,
+			         ( ( idx + 1 ) < ( sizeof ( benches ) / sizeof ( benches[0] ) ) ) ? "," : "" );
+		}
+
+		printf ( "  ]\n}\n" );
+	}
+	else
+	{
+		printf ( "%-24s %10s %10s %10s  (ns/op, %u x %u calls)\n", "benchmark", "min", "median", "p99", batches, iterations );
+
+		for ( idx = 0; idx < ( sizeof ( benches ) / sizeof ( benches[0] ) ); idx++ )
+		{
+			printf ( "%-24s %10.3f %10.3f %10.3f\n", results[idx].name, results[idx].min_ns, results[idx].median_ns, results[idx].p99_ns );
+		}
+	}
+
+	return 0;
+}
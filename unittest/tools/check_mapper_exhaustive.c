@@ -0,0 +1,328 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    check_mapper_exhaustive.c
+ * @brief   exhaustive equivalence and property checker for SNESMapper
+ * @details Every 16bit SNES input is run through SNESMapper_Update() for a grid of
+ *          button mask configurations, autofire cycle times and millis_passed sequences.
+ *          Each output is compared against an independent reference model and checked
+ *          against invariants. Jobs are distributed over all CPU cores.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "snes2db9.h"
+
+#define NR_INPUTS         65536u  /**< every SNES button combination */
+#define MAX_THREADS       64u     /**< upper limit of worker threads */
+#define MAX_REPORTS       10u     /**< mismatches reported in detail */
+#define DB9_VALID_BITS    ( DB9_BTNMASK_Up | DB9_BTNMASK_Down | DB9_BTNMASK_Left | DB9_BTNMASK_Right | DB9_BTNMASK_Fire )  /**< all DB9 outputs */
+
+/**
+ * @brief button masks used for fire, autofire and jump configurations
+ */
+static const uint16_t MaskGrid[] =
+{
+	0,
+	SNES_BTNMASK_B,
+	SNES_BTNMASK_Y,
+	SNES_BTNMASK_A,
+	SNES_BTNMASK_L | SNES_BTNMASK_R,
+	SNES_BTNMASK_B | SNES_BTNMASK_Up,
+};
+
+/**
+ * @brief autofire cycle times in ms
+ */
+static const uint16_t AutofireGrid[] = { 0, 1, 16, 100, 65535 };
+
+#define NR_MASKS      ( sizeof ( MaskGrid ) / sizeof ( MaskGrid[0] ) )          /**< entries in MaskGrid */
+#define NR_AUTOFIRE   ( sizeof ( AutofireGrid ) / sizeof ( AutofireGrid[0] ) )  /**< entries in AutofireGrid */
+#define NR_SEQUENCES  4u                                                        /**< millis_passed sequences, see MillisPassed() */
+#define NR_JOBS       ( NR_MASKS * NR_MASKS * NR_MASKS * NR_AUTOFIRE * NR_SEQUENCES )  /**< grid size */
+
+/**
+ * @brief reference model of the mapper state
+ */
+typedef struct
+{
+	uint64_t total;     /**< ms accumulated since the mapper was initialized */
+} Reference;
+
+static uint32_t NextJob = 0;            /**< next job to hand out, accessed atomically */
+static uint64_t NrChecks = 0;           /**< number of checked updates, accessed atomically */
+static uint64_t NrFailures = 0;         /**< number of failed checks, accessed atomically */
+static pthread_mutex_t ReportLock = PTHREAD_MUTEX_INITIALIZER;  /**< serializes detailed reports */
+static uint32_t NrReports = 0;          /**< detailed reports printed */
+
+/**
+ * @brief     millis_passed sequence element
+ * @param[in] sequence number
+ * @param[in] idx of the update
+ * @returns   ms passed for the update
+ */
+static uint16_t MillisPassed ( uint32_t sequence, uint32_t idx )
+{
+	uint16_t ms;
+
+	switch ( sequence )
+	{
+		case 0:
+			ms = 16;                                             /* ATtiny84 DB9 task */
+			break;
+
+		case 1:
+			ms = 1;                                              /* fine grained */
+			break;
+
+		case 2:
+			ms = ( ( idx & 1u ) != 0 ) ? 33 : 0;                 /* bursts and zero time updates */
+			break;
+
+		default:
+			ms = ( uint16_t ) ( ( ( idx * 2654435761u ) >> 24 ) % 41u );  /* irregular 0..40 */
+			break;
+	}
+
+	return ms;
+}
+
+/**
+ * @brief     reference model of SNESMapper_Update() derived from the documented behaviour
+ * @details   The autofire phase is ( accumulated ms / cycle time ) & 1, independent of how the time
+ *            is split into updates. It starts off.
+ * @param[in, out] ref state of the model
+ * @param[in] masks configuration
+ * @param[in] cycletime autofire toggle cycle time, 0 disables autofire
+ * @param[in] input SNES buttons
+ * @param[in] ms passed since the last update
+ * @returns   expected DB9 state
+ */
+static uint8_t ReferenceUpdate ( Reference * ref, const SNESMapperButtonMasks * masks, uint16_t cycletime, uint16_t input, uint16_t ms )
+{
+	uint8_t out = 0;
+	bool    phase_on;
+	ref->total += ms;
+	phase_on = ( cycletime != 0 ) && ( ( ( ref->total / cycletime ) & 1u ) != 0 );
+
+	out |= ( ( input & ( SNES_BTNMASK_Up ) ) || ( input & masks->jump_mask ) ) ? DB9_BTNMASK_Up : 0;
+	out |= ( input & SNES_BTNMASK_Down ) ? DB9_BTNMASK_Down : 0;
+	out |= ( input & SNES_BTNMASK_Left ) ? DB9_BTNMASK_Left : 0;
+	out |= ( input & SNES_BTNMASK_Right ) ? DB9_BTNMASK_Right : 0;
+	out |= ( ( input & masks->fire_mask ) || ( ( input & masks->autofire_mask ) && phase_on ) ) ? DB9_BTNMASK_Fire : 0;
+	return out;
+}
+
+/**
+ * @brief     checks invariants independent of the reference model
+ * @param[in] masks configuration
+ * @param[in] cycletime autofire toggle cycle time
+ * @param[in] input SNES buttons
+ * @param[in] out DB9 state returned by the mapper
+ * @returns   NULL if all invariants hold, description of the violation otherwise
+ */
+static const char * CheckInvariants ( const SNESMapperButtonMasks * masks, uint16_t cycletime, uint16_t input, uint8_t out )
+{
+	if ( ( out & ~DB9_VALID_BITS ) != 0 )
+	{
+		return "undefined DB9 bits set";
+	}
+
+	if ( ( ( out & DB9_BTNMASK_Up ) != 0 ) && ( ( input & ( SNES_BTNMASK_Up | masks->jump_mask ) ) == 0 ) )
+	{
+		return "Up without Up or jump button";
+	}
+
+	if ( ( ( out & DB9_BTNMASK_Down ) != 0 ) != ( ( input & SNES_BTNMASK_Down ) != 0 ) )
+	{
+		return "Down does not follow its button";
+	}
+
+	if ( ( ( out & DB9_BTNMASK_Left ) != 0 ) != ( ( input & SNES_BTNMASK_Left ) != 0 ) )
+	{
+		return "Left does not follow its button";
+	}
+
+	if ( ( ( out & DB9_BTNMASK_Right ) != 0 ) != ( ( input & SNES_BTNMASK_Right ) != 0 ) )
+	{
+		return "Right does not follow its button";
+	}
+
+	if ( ( ( input & SNES_BTNMASK_Up ) != 0 ) && ( ( out & DB9_BTNMASK_Up ) == 0 ) )
+	{
+		return "Up button without Up";
+	}
+
+	if ( ( ( out & DB9_BTNMASK_Fire ) != 0 ) && ( ( input & ( masks->fire_mask | masks->autofire_mask ) ) == 0 ) )
+	{
+		return "Fire without fire or autofire button";
+	}
+
+	if ( ( ( input & masks->fire_mask ) != 0 ) && ( ( out & DB9_BTNMASK_Fire ) == 0 ) )
+	{
+		return "fire button without Fire";
+	}
+
+	if ( ( cycletime == 0 ) && ( ( out & DB9_BTNMASK_Fire ) != 0 ) && ( ( input & masks->fire_mask ) == 0 ) )
+	{
+		return "autofire active although disabled";
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief     reports a failure in detail, limited to MAX_REPORTS
+ * @param[in] masks configuration
+ * @param[in] cycletime autofire toggle cycle time
+ * @param[in] sequence of millis_passed
+ * @param[in] input SNES buttons
+ * @param[in] out actual DB9 state
+ * @param[in] expected DB9 state
+ * @param[in] reason of the failure
+ */
+static void Report ( const SNESMapperButtonMasks * masks, uint16_t cycletime, uint32_t sequence, uint16_t input,
+                     uint8_t out, uint8_t expected, const char * reason )
+{
+	pthread_mutex_lock ( &ReportLock );
+
+	if ( NrReports < MAX_REPORTS )
+	{
+		printf ( "FAIL fire=0x%04x autofire=0x%04x jump=0x%04x cycle=%u seq=%u input=0x%04x out=0x%02x expected=0x%02x: %s\n",
+		         masks->fire_mask, masks->autofire_mask, masks->jump_mask, cycletime, sequence, input, out, expected, reason );
+	}
+
+	NrReports++;
+	pthread_mutex_unlock ( &ReportLock );
+}
+
+/**
+ * @brief     runs one grid point over all inputs
+ * @param[in] job index into the grid
+ */
+static void RunJob ( uint32_t job )
+{
+	SNESMapperButtonMasks masks;
+	SNESMapper mapper;
+	Reference  ref = { 0 };
+	uint32_t   rest = job;
+	uint32_t   sequence = rest % NR_SEQUENCES;
+	uint16_t   cycletime;
+	uint32_t   input;
+	uint32_t   failures = 0;
+	rest /= NR_SEQUENCES;
+	cycletime = AutofireGrid[rest % NR_AUTOFIRE];
+	rest /= NR_AUTOFIRE;
+	masks.fire_mask = MaskGrid[rest % NR_MASKS];
+	rest /= NR_MASKS;
+	masks.autofire_mask = MaskGrid[rest % NR_MASKS];
+	rest /= NR_MASKS;
+	masks.jump_mask = MaskGrid[rest % NR_MASKS];
+	SNESMapper_Init ( &mapper, &masks );
+	SNESMapper_SetAutofireDuration ( &mapper, cycletime );
+
+	for ( input = 0; input < NR_INPUTS; input++ )
+	{
+		uint16_t ms = MillisPassed ( sequence, input );
+		uint8_t  out = SNESMapper_Update ( &mapper, ( uint16_t ) input, ms );
+		uint8_t  expected = ReferenceUpdate ( &ref, &masks, cycletime, ( uint16_t ) input, ms );
+		const char * reason = CheckInvariants ( &masks, cycletime, ( uint16_t ) input, out );
+
+		if ( ( reason == NULL ) && ( out != expected ) )
+		{
+			reason = "mismatch against reference model";
+		}
+
+		if ( reason != NULL )
+		{
+			failures++;
+			Report ( &masks, cycletime, sequence, ( uint16_t ) input, out, expected, reason );
+		}
+	}
+
+	__atomic_fetch_add ( &NrChecks, NR_INPUTS, __ATOMIC_RELAXED );
+	__atomic_fetch_add ( &NrFailures, failures, __ATOMIC_RELAXED );
+}
+
+/**
+ * @brief     worker thread, pulls jobs until the grid is exhausted
+ * @param[in] arg unused
+ * @returns   NULL
+ */
+static void * Worker ( void * arg )
+{
+	uint32_t job;
+	( void ) arg;
+
+	while ( ( job = __atomic_fetch_add ( &NextJob, 1u, __ATOMIC_RELAXED ) ) < NR_JOBS )
+	{
+		RunJob ( job );
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief main function of the exhaustive mapper checker
+ * @details Option: -j N to set the number of threads, default is the number of online CPUs
+ * @param argc
+ * @param argv
+ * @return 0 if all checks passed
+ */
+int main ( int argc, char **argv )
+{
+	pthread_t threads[MAX_THREADS];
+	long      nr_threads = sysconf ( _SC_NPROCESSORS_ONLN );
+	long      idx;
+
+	if ( ( argc == 3 ) && ( strcmp ( argv[1], "-j" ) == 0 ) )
+	{
+		nr_threads = strtol ( argv[2], NULL, 0 );
+	}
+	else if ( argc != 1 )
+	{
+		fprintf ( stderr, "usage: %s [-j threads]\n", argv[0] );
+		return 2;
+	}
+
+	if ( nr_threads < 1 )
+	{
+		nr_threads = 1;
+	}
+
+	if ( nr_threads > ( long ) MAX_THREADS )
+	{
+		nr_threads = MAX_THREADS;
+	}
+
+	for ( idx = 0; idx < nr_threads; idx++ )
+	{
+		if ( pthread_create ( &threads[idx], NULL, Worker, NULL ) != 0 )
+		{
+			fprintf ( stderr, "cannot create thread\n" );
+			return 2;
+		}
+	}
+
+	for ( idx = 0; idx < nr_threads; idx++ )
+	{
+		pthread_join ( threads[idx], NULL );
+	}
+
+	printf ( "%u configurations, %llu updates checked on %ld threads, %llu failures\n", ( unsigned int ) NR_JOBS,
+	         ( unsigned long long ) NrChecks, nr_threads, ( unsigned long long ) NrFailures );
+	return ( NrFailures == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,504 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    golden_runner.c
+ * @brief   replays the golden trace corpus and diffs the DB9 pin timelines
+ * @details Every input trace of the corpus (*.trace text or *.s2dt binary) is run through
+ *          SNESMapper_Update() and DB9_SetPins() with the DB9 task timing and mapper configuration of
+ *          each firmware. The resulting pin timeline is compared with <trace>.<config>.db9.
+ *          Jobs run in parallel on all CPU cores. With --regenerate the expected timelines are rewritten.
+ *
+ *          Text traces contain lines "<time_ms> <state>" with the complete SNES state bitcoded according
+ *          to SNES_BTNMASK_xxx and a final line "end <time_ms>". Lines starting with # are comments.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "snes2db9.h"
+#include "snes2db9_inputtrace.h"
+
+#define MAX_THREADS  64u   /**< upper limit of worker threads */
+#define MAX_PATH     1024u /**< maximum path length */
+
+/**
+ * @brief firmware configuration a timeline is produced for
+ */
+typedef struct
+{
+	const char * name;           /**< configuration name used in file names */
+	const char * source;         /**< firmware source the configuration is taken from */
+	uint16_t     update_ms;      /**< DB9 task period */
+	uint16_t     autofire_ms;    /**< mapper autofire cycle time */
+	uint16_t     startup_ms;     /**< startup time without DB9 output */
+} GoldenConfig;
+
+/**
+ * @brief configurations of the firmwares, see InitAppl()/DB9UpdateTask() in main.c and setup()/loop() in SNES2DB9.ino
+ */
+static const GoldenConfig Configs[] =
+{
+	{ "attiny84", "code/ATtiny84/main.c",               16, 16,                       3000 },
+	{ "arduino",  "code/Arduino/SNES2DB9/SNES2DB9.ino", 16, AUTOFIRE_CYCLETIME_IN_MS, 0    },  /* no startup delay */
+};
+
+#define NR_CONFIGS ( sizeof ( Configs ) / sizeof ( Configs[0] ) )  /**< number of configurations */
+
+/**
+ * @brief input change of a trace
+ */
+typedef struct
+{
+	uint64_t time_ms;  /**< time of the change */
+	uint16_t state;    /**< state after the change */
+} Change;
+
+/**
+ * @brief job of the runner: one trace with one configuration
+ */
+typedef struct
+{
+	char                 trace[MAX_PATH];     /**< trace file */
+	char                 expected[MAX_PATH];  /**< expected timeline file */
+	const GoldenConfig * config;              /**< configuration */
+	char *               report;              /**< result message */
+	int                  status;              /**< 0 pass, 1 mismatch, 2 error */
+} Job;
+
+static Job *    Jobs = NULL;        /**< all jobs */
+static uint32_t NrJobs = 0;         /**< number of jobs */
+static uint32_t NextJob = 0;        /**< next job to hand out, accessed atomically */
+static bool     Regenerate = false; /**< rewrite expected timelines */
+
+/**
+ * @brief DB9 pin levels recorded by the HAL, per thread because the HAL has no context
+ */
+static __thread char PinLevels[5];
+
+/**
+ * @brief     recording HAL for DB9_SetPins
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+static void RecordPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	if ( ( pin >= DB9_UP ) && ( pin <= DB9_FIRE ) )
+	{
+		PinLevels[pin - DB9_UP] = ( state == SNES2DB9_PIN_LOW ) ? '0' : ( state == SNES2DB9_PIN_HIGH ) ? '1' : 'z';
+	}
+}
+
+/**
+ * @brief     loads a trace
+ * @param[in] path of a *.trace or *.s2dt file
+ * @param[out] changes allocated array of changes
+ * @param[out] nr_changes in the array
+ * @param[out] end_ms of the trace
+ * @returns   0 on success, -1 on error
+ */
+static int LoadTrace ( const char * path, Change ** changes, size_t * nr_changes, uint64_t * end_ms )
+{
+	size_t cap = 0;
+	*changes = NULL;
+	*nr_changes = 0;
+	*end_ms = 0;
+
+	if ( strstr ( path, ".s2dt" ) != NULL )
+	{
+		InputTrace trace;
+		uint32_t   tick_us, frame_ticks;
+		uint64_t   end_time, time;
+		uint16_t   state;
+
+		if ( InputTrace_Open ( &trace, path ) != 0 )
+		{
+			return -1;
+		}
+
+		InputTrace_GetInfo ( &trace, &tick_us, &frame_ticks, &end_time );
+		*end_ms = ( end_time * tick_us ) / 1000u;
+
+		while ( InputTrace_NextChange ( &trace, &time, &state ) )
+		{
+			if ( *nr_changes == cap )
+			{
+				cap = ( cap == 0 ) ? 256u : cap * 2u;
+				*changes = realloc ( *changes, cap * sizeof ( Change ) );
+			}
+
+			( *changes ) [*nr_changes].time_ms = ( time * tick_us ) / 1000u;
+			( *changes ) [*nr_changes].state = state;
+			( *nr_changes ) ++;
+		}
+
+		InputTrace_Close ( &trace );
+	}
+	else
+	{
+		FILE * fp = fopen ( path, "r" );
+		char   line[256];
+
+		if ( fp == NULL )
+		{
+			return -1;
+		}
+
+		while ( fgets ( line, sizeof ( line ), fp ) != NULL )
+		{
+			unsigned long long time;
+			int                state;
+
+			if ( ( line[0] == '#' ) || ( line[0] == '\n' ) )
+			{
+				continue;
+			}
+
+			if ( sscanf ( line, "end %llu", &time ) == 1 )
+			{
+				*end_ms = time;
+			}
+			else if ( sscanf ( line, "%llu %i", &time, &state ) == 2 )
+			{
+				if ( *nr_changes == cap )
+				{
+					cap = ( cap == 0 ) ? 256u : cap * 2u;
+					*changes = realloc ( *changes, cap * sizeof ( Change ) );
+				}
+
+				( *changes ) [*nr_changes].time_ms = time;
+				( *changes ) [*nr_changes].state = ( uint16_t ) state;
+				( *nr_changes ) ++;
+			}
+			else
+			{
+				fclose ( fp );
+				return -1;
+			}
+		}
+
+		fclose ( fp );
+	}
+
+	return ( ( *nr_changes == 0 ) || ( *changes != NULL ) ) ? 0 : -1;
+}
+
+/**
+ * @brief     produces the DB9 timeline of a trace
+ * @param[in] changes of the trace
+ * @param[in] nr_changes in the array
+ * @param[in] end_ms of the trace
+ * @param[in] config of the firmware
+ * @param[out] size of the timeline text
+ * @returns   allocated timeline text, NULL on allocation failure
+ */
+static char * Timeline ( const Change * changes, size_t nr_changes, uint64_t end_ms, const GoldenConfig * config, size_t * size )
+{
+	SNESMapperButtonMasks masks;
+	SNESMapper mapper;
+	char       last[6] = "";
+	char *     text = NULL;
+	FILE *     out = open_memstream ( &text, size );
+	uint64_t   time;
+	uint16_t   startup_ms = 0;
+	uint16_t   state = 0;
+	size_t     idx = 0;
+
+	if ( out == NULL )
+	{
+		return NULL;
+	}
+
+	masks.fire_mask = SNES_BTNMASK_B;
+	masks.jump_mask = SNES_BTNMASK_A;
+	masks.autofire_mask = SNES_BTNMASK_Y;
+	SNESMapper_Init ( &mapper, &masks );
+	SNESMapper_SetAutofireDuration ( &mapper, config->autofire_ms );
+	fprintf ( out, "# DB9 pin timeline of %s\n", config->source );
+	fprintf ( out, "# fire B, jump A, autofire Y %u ms, update %u ms, startup %u ms\n", config->autofire_ms, config->update_ms,
+	          config->startup_ms );
+	fprintf ( out, "# time_ms UDLRF (0 pulled low, z released)\n" );
+
+	for ( time = config->update_ms; time <= end_ms; time += config->update_ms )
+	{
+		uint8_t db9;
+
+		while ( ( idx < nr_changes ) && ( changes[idx].time_ms <= time ) )
+		{
+			state = changes[idx++].state;
+		}
+
+		/* startup handling of DB9UpdateTask(): */
+		if ( ( config->startup_ms > 0 ) && ( startup_ms <= config->startup_ms ) )
+		{
+			startup_ms += config->update_ms;
+			db9 = 0;
+		}
+		else
+		{
+			db9 = SNESMapper_Update ( &mapper, state, config->update_ms );
+		}
+
+		DB9_SetPins ( db9, RecordPin );
+
+		if ( memcmp ( last, PinLevels, sizeof ( PinLevels ) ) != 0 )
+		{
+			memcpy ( last, PinLevels, sizeof ( PinLevels ) );
+			fprintf ( out, "%llu %.5s\n", ( unsigned long long ) time, last );
+		}
+	}
+
+	fprintf ( out, "end %llu\n", ( unsigned long long ) end_ms );
+	fclose ( out );
+	return text;
+}
+
+/**
+ * @brief     reads a complete file
+ * @param[in] path of the file
+ * @param[out] size of the content
+ * @returns   allocated content, NULL on error
+ */
+static char * ReadFile ( const char * path, size_t * size )
+{
+	FILE * fp = fopen ( path, "rb" );
+	char * text;
+	long   len;
+
+	if ( fp == NULL )
+	{
+		return NULL;
+	}
+
+	fseek ( fp, 0, SEEK_END );
+	len = ftell ( fp );
+	fseek ( fp, 0, SEEK_SET );
+	text = malloc ( ( size_t ) len + 1u );
+
+	if ( ( text != NULL ) && ( fread ( text, 1, ( size_t ) len, fp ) == ( size_t ) len ) )
+	{
+		text[len] = '\0';
+		*size = ( size_t ) len;
+	}
+	else
+	{
+		free ( text );
+		text = NULL;
+	}
+
+	fclose ( fp );
+	return text;
+}
+
+/**
+ * @brief     describes the first difference of two timelines
+ * @param[in] expected timeline
+ * @param[in] actual timeline
+ * @returns   allocated report
+ */
+static char * Diff ( const char * expected, const char * actual )
+{
+	char *   report = NULL;
+	size_t   size;
+	FILE *   out = open_memstream ( &report, &size );
+	uint32_t line = 1;
+
+	while ( ( *expected != '\0' ) && ( *expected == *actual ) )
+	{
+		line += ( *expected == '\n' ) ? 1u : 0u;
+		expected++;
+		actual++;
+	}
+
+	/* back to the start of the line: */
+	while ( ( line > 1 ) && ( expected[-1] != '\n' ) )
+	{
+		expected--;
+		actual--;
+	}
+
+	fprintf ( out, "first difference in line %u\n  - %.*s\n  + %.*s\n", line, ( int ) strcspn ( expected, "\n" ), expected,
+	          ( int ) strcspn ( actual, "\n" ), actual );
+	fclose ( out );
+	return report;
+}
+
+/**
+ * @brief          runs a job
+ * @param[in, out] job to run
+ */
+static void RunJob ( Job * job )
+{
+	Change * changes;
+	size_t   nr_changes, size, expected_size;
+	uint64_t end_ms;
+	char *   actual;
+	char *   expected;
+
+	if ( LoadTrace ( job->trace, &changes, &nr_changes, &end_ms ) != 0 )
+	{
+		job->report = strdup ( "cannot load trace" );
+		job->status = 2;
+		return;
+	}
+
+	actual = Timeline ( changes, nr_changes, end_ms, job->config, &size );
+	free ( changes );
+
+	if ( actual == NULL )
+	{
+		job->report = strdup ( "out of memory" );
+		job->status = 2;
+		return;
+	}
+
+	if ( Regenerate )
+	{
+		FILE * fp = fopen ( job->expected, "wb" );
+		job->status = ( ( fp != NULL ) && ( fwrite ( actual, 1, size, fp ) == size ) && ( fclose ( fp ) == 0 ) ) ? 0 : 2;
+		job->report = strdup ( ( job->status == 0 ) ? "regenerated" : "cannot write expected timeline" );
+	}
+	else if ( ( expected = ReadFile ( job->expected, &expected_size ) ) == NULL )
+	{
+		job->report = strdup ( "expected timeline missing, run with --regenerate" );
+		job->status = 2;
+	}
+	else
+	{
+		job->status = ( ( expected_size == size ) && ( memcmp ( expected, actual, size ) == 0 ) ) ? 0 : 1;
+		job->report = ( job->status == 0 ) ? strdup ( "ok" ) : Diff ( expected, actual );
+		free ( expected );
+	}
+
+	free ( actual );
+}
+
+/**
+ * @brief     worker thread, pulls jobs until all are done
+ * @param[in] arg unused
+ * @returns   NULL
+ */
+static void * Worker ( void * arg )
+{
+	uint32_t job;
+	( void ) arg;
+
+	while ( ( job = __atomic_fetch_add ( &NextJob, 1u, __ATOMIC_RELAXED ) ) < NrJobs )
+	{
+		RunJob ( &Jobs[job] );
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief     collects the jobs of a corpus directory
+ * @param[in] dir of the corpus
+ * @returns   0 on success, -1 on error
+ */
+static int CollectJobs ( const char * dir )
+{
+	struct dirent ** entries;
+	int              nr_entries = scandir ( dir, &entries, NULL, alphasort );
+	int              idx;
+	uint32_t         config;
+
+	if ( nr_entries < 0 )
+	{
+		perror ( dir );
+		return -1;
+	}
+
+	Jobs = calloc ( ( size_t ) nr_entries * NR_CONFIGS + 1u, sizeof ( Job ) );
+
+	for ( idx = 0; idx < nr_entries; idx++ )
+	{
+		const char * name = entries[idx]->d_name;
+		size_t       len = strlen ( name );
+
+		if ( ( Jobs != NULL ) &&
+		        ( ( ( len > 6 ) && ( strcmp ( name + len - 6, ".trace" ) == 0 ) ) || ( ( len > 5 ) && ( strcmp ( name + len - 5, ".s2dt" ) == 0 ) ) ) )
+		{
+			for ( config = 0; config < NR_CONFIGS; config++ )
+			{
+				Job * job = &Jobs[NrJobs++];
+				snprintf ( job->trace, sizeof ( job->trace ), "%s/%s", dir, name );
+				snprintf ( job->expected, sizeof ( job->expected ), "%s/%.*s.%s.db9", dir, ( int ) ( strrchr ( name, '.' ) - name ), name,
+				           Configs[config].name );
+				job->config = &Configs[config];
+			}
+		}
+
+		free ( entries[idx] );
+	}
+
+	free ( entries );
+	return ( Jobs != NULL ) ? 0 : -1;
+}
+
+/**
+ * @brief main function of the golden trace runner
+ * @param argc
+ * @param argv
+ * @return 0 if all timelines match
+ */
+int main ( int argc, char **argv )
+{
+	pthread_t threads[MAX_THREADS];
+	long      nr_threads = sysconf ( _SC_NPROCESSORS_ONLN );
+	long      idx;
+	uint32_t  failures = 0;
+	uint32_t  job;
+
+	if ( ( argc == 3 ) && ( strcmp ( argv[1], "--regenerate" ) == 0 ) )
+	{
+		Regenerate = true;
+	}
+	else if ( argc != 2 )
+	{
+		fprintf ( stderr, "usage: %s [--regenerate] CORPUS_DIR\n", argv[0] );
+		return 2;
+	}
+
+	if ( CollectJobs ( argv[argc - 1] ) != 0 )
+	{
+		return 2;
+	}
+
+	nr_threads = ( nr_threads < 1 ) ? 1 : ( nr_threads > ( long ) MAX_THREADS ) ? ( long ) MAX_THREADS : nr_threads;
+
+	for ( idx = 0; idx < nr_threads; idx++ )
+	{
+		pthread_create ( &threads[idx], NULL, Worker, NULL );
+	}
+
+	for ( idx = 0; idx < nr_threads; idx++ )
+	{
+		pthread_join ( threads[idx], NULL );
+	}
+
+	for ( job = 0; job < NrJobs; job++ )
+	{
+		printf ( "%-8s %-10s %s: %s", ( Jobs[job].status == 0 ) ? "PASS" : "FAIL", Jobs[job].config->name, Jobs[job].trace,
+		         Jobs[job].report );
+		printf ( ( Jobs[job].report[strlen ( Jobs[job].report ) - 1u] == '\n' ) ? "" : "\n" );
+		failures += ( Jobs[job].status != 0 ) ? 1u : 0u;
+		free ( Jobs[job].report );
+	}
+
+	printf ( "%u timelines, %u failures\n", NrJobs, failures );
+	free ( Jobs );
+	return ( ( failures == 0 ) && ( NrJobs > 0 ) ) ? 0 : 1;
+}
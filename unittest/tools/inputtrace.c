@@ -0,0 +1,362 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    inputtrace.c
+ * @brief   command line tool for binary SNES input traces
+ * @details Commands:
+ *          - fromsim: records the gamepad input of a simulator run and verifies the round trip
+ *          - info/dump: shows a trace
+ *          - at: prints the state at a given time
+ *          - replay: runs a trace through SNESMapper_Update and reports the throughput
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "snes2db9.h"
+#include "snes2db9_sim.h"
+#include "snes2db9_inputtrace.h"
+
+#define SIM_TICK_US      1000u  /**< time unit of traces recorded from the simulator */
+#define SIM_FRAME_TICKS  16u    /**< DB9 update period of the ATtiny84 implementation */
+
+/**
+ * @brief change recorded for the round trip check
+ */
+typedef struct
+{
+	uint64_t time;   /**< time in ticks */
+	uint16_t state;  /**< state after the change */
+} Change;
+
+/**
+ * @brief context of the simulator input observer
+ */
+typedef struct
+{
+	InputTraceWriter writer;      /**< trace written */
+	Change *         changes;     /**< all changes for verification */
+	size_t           nr_changes;  /**< number of changes */
+	size_t           cap_changes; /**< allocated changes */
+	int              error;       /**< write or allocation error */
+} Recorder;
+
+/**
+ * @brief     SimInputObserver writing to the trace
+ * @param[in] ctx points to Recorder
+ * @param[in] time_ns of the change
+ * @param[in] snes_pin_mask is the new state
+ */
+static void RecordInput ( void * ctx, uint64_t time_ns, uint16_t snes_pin_mask )
+{
+	Recorder * rec = ctx;
+	uint64_t   time = time_ns / ( SIM_TICK_US * 1000u );
+
+	/* changes within one tick collapse, the last one wins: */
+	if ( ( rec->nr_changes > 0 ) && ( rec->changes[rec->nr_changes - 1u].time == time ) )
+	{
+		rec->nr_changes--;
+	}
+
+	if ( rec->nr_changes == rec->cap_changes )
+	{
+		size_t   cap = ( rec->cap_changes == 0 ) ? 1024u : ( rec->cap_changes * 2u );
+		Change * grown = realloc ( rec->changes, cap * sizeof ( Change ) );
+
+		if ( grown == NULL )
+		{
+			rec->error = -1;
+			return;
+		}
+
+		rec->changes = grown;
+		rec->cap_changes = cap;
+	}
+
+	rec->changes[rec->nr_changes].time = time;
+	rec->changes[rec->nr_changes].state = snes_pin_mask;
+	rec->nr_changes++;
+}
+
+/**
+ * @brief     verifies a written trace against the recorded changes
+ * @param[in] path of the trace
+ * @param[in] rec recorded changes
+ * @param[in] end_time of the trace
+ * @returns   number of errors
+ */
+static uint32_t Verify ( const char * path, const Recorder * rec, uint64_t end_time )
+{
+	InputTrace trace;
+	uint32_t   errors = 0;
+	uint64_t   time;
+	uint16_t   state;
+	uint16_t   expected = 0;
+	size_t     idx;
+	uint32_t   seed = 1;
+
+	if ( InputTrace_Open ( &trace, path ) != 0 )
+	{
+		return 1;
+	}
+
+	/* sequential iteration, changes without effect are not stored: */
+	for ( idx = 0; idx < rec->nr_changes; idx++ )
+	{
+		if ( rec->changes[idx].state == expected )
+		{
+			continue;
+		}
+
+		expected = rec->changes[idx].state;
+
+		if ( !InputTrace_NextChange ( &trace, &time, &state ) || ( time != rec->changes[idx].time ) || ( state != expected ) )
+		{
+			errors++;
+		}
+	}
+
+	errors += InputTrace_NextChange ( &trace, &time, &state ) ? 1u : 0u;
+
+	/* random seeks: */
+	for ( idx = 0; idx < 100000u; idx++ )
+	{
+		size_t   lo = 0;
+		size_t   hi = rec->nr_changes;
+		seed = seed * 1103515245u + 12345u;
+		time = ( ( uint64_t ) seed << 16 ) % ( end_time + 1u );
+
+		/* last change at or before time: */
+		while ( lo < hi )
+		{
+			size_t mid = ( lo + hi ) / 2u;
+
+			if ( rec->changes[mid].time <= time )
+			{
+				lo = mid + 1u;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+
+		expected = ( lo == 0 ) ? 0 : rec->changes[lo - 1u].state;
+		errors += ( InputTrace_StateAt ( &trace, time ) != expected ) ? 1u : 0u;
+	}
+
+	InputTrace_Close ( &trace );
+	return errors;
+}
+
+/**
+ * @brief     records a simulator run
+ * @param[in] path of the trace to write
+ * @param[in] presses to simulate
+ * @param[in] seed of the simulation
+ * @returns   0 on success
+ */
+static int FromSim ( const char * path, uint32_t presses, uint32_t seed )
+{
+	SimConfig   config;
+	SimResult   result;
+	Recorder    rec;
+	struct stat info;
+	uint64_t    end_time;
+	uint32_t    errors;
+	size_t      idx;
+	memset ( &rec, 0, sizeof ( rec ) );
+	Sim_DefaultConfig ( &config );
+	config.nr_presses = presses;
+	config.seed = seed;
+	config.input_observer = RecordInput;
+	config.observer_ctx = &rec;
+
+	if ( Sim_Run ( &config, &result ) != 0 )
+	{
+		fprintf ( stderr, "simulation failed\n" );
+		return 1;
+	}
+
+	end_time = result.duration_ns / ( SIM_TICK_US * 1000u );
+	SimResult_Free ( &result );
+
+	if ( ( rec.error != 0 ) || ( InputTraceWriter_Open ( &rec.writer, path, SIM_TICK_US, SIM_FRAME_TICKS ) != 0 ) )
+	{
+		perror ( path );
+		return 1;
+	}
+
+	for ( idx = 0; idx < rec.nr_changes; idx++ )
+	{
+		rec.error |= InputTraceWriter_Add ( &rec.writer, rec.changes[idx].time, rec.changes[idx].state );
+	}
+
+	rec.error |= InputTraceWriter_Close ( &rec.writer, end_time );
+
+	if ( ( rec.error != 0 ) || ( stat ( path, &info ) != 0 ) )
+	{
+		perror ( path );
+		return 1;
+	}
+
+	errors = Verify ( path, &rec, end_time );
+	printf ( "%zu changes over %.1f s in %lld bytes (%.1f kB per hour), %u verification errors\n", rec.nr_changes,
+	         end_time * SIM_TICK_US / 1e6, ( long long ) info.st_size,
+	         ( info.st_size / 1024.0 ) * 3600.0 / ( ( end_time > 0 ) ? ( end_time * SIM_TICK_US / 1e6 ) : 1.0 ), errors );
+	free ( rec.changes );
+	return ( errors == 0 ) ? 0 : 1;
+}
+
+/**
+ * @brief     prints a trace
+ * @param[in, out] trace to print
+ * @param[in] changes true to print all changes
+ */
+static void Dump ( InputTrace * trace, bool changes )
+{
+	uint32_t tick_us, frame_ticks;
+	uint64_t end_time, time;
+	uint16_t state;
+	uint64_t nr_changes = 0;
+	InputTrace_GetInfo ( trace, &tick_us, &frame_ticks, &end_time );
+	InputTrace_Rewind ( trace );
+
+	while ( InputTrace_NextChange ( trace, &time, &state ) )
+	{
+		if ( changes )
+		{
+			printf ( "%llu 0x%04x\n", ( unsigned long long ) time, state );
+		}
+
+		nr_changes++;
+	}
+
+	printf ( "tick %u us, frame %u ticks, duration %llu ticks, %llu changes\n", tick_us, frame_ticks,
+	         ( unsigned long long ) end_time, ( unsigned long long ) nr_changes );
+}
+
+/**
+ * @brief     replays a trace through SNESMapper_Update
+ * @param[in, out] trace to replay
+ * @param[in] loops over the trace
+ * @param[in] autofire_ms of the mapper
+ */
+static void Replay ( InputTrace * trace, uint32_t loops, uint16_t autofire_ms )
+{
+	SimConfig       config;
+	SNESMapper      mapper;
+	struct timespec start, stop;
+	uint32_t        tick_us, frame_ticks;
+	uint64_t        end_time, time;
+	uint64_t        frames = 0;
+	uint64_t        fire_frames = 0;
+	uint32_t        loop;
+	uint16_t        frame_ms;
+	double          seconds;
+	Sim_DefaultConfig ( &config );
+	InputTrace_GetInfo ( trace, &tick_us, &frame_ticks, &end_time );
+	frame_ticks = ( frame_ticks > 0 ) ? frame_ticks : 1u;
+	frame_ms = ( uint16_t ) ( ( frame_ticks * tick_us ) / 1000u );
+	SNESMapper_Init ( &mapper, &config.masks );
+	SNESMapper_SetAutofireDuration ( &mapper, autofire_ms );
+	clock_gettime ( CLOCK_MONOTONIC, &start );
+
+	for ( loop = 0; loop < loops; loop++ )
+	{
+		InputTrace_Rewind ( trace );
+
+		for ( time = 0; time < end_time; time += frame_ticks )
+		{
+			uint8_t db9 = SNESMapper_Update ( &mapper, InputTrace_StateAt ( trace, time ), frame_ms );
+			fire_frames += ( ( db9 & DB9_BTNMASK_Fire ) != 0 ) ? 1u : 0u;
+			frames++;
+		}
+	}
+
+	clock_gettime ( CLOCK_MONOTONIC, &stop );
+	seconds = ( stop.tv_sec - start.tv_sec ) + ( stop.tv_nsec - start.tv_nsec ) / 1e9;
+	printf ( "%llu frames replayed in %.3f s (%.1f Mframes/s), %llu frames with fire\n", ( unsigned long long ) frames, seconds,
+	         ( seconds > 0 ) ? frames / seconds / 1e6 : 0.0, ( unsigned long long ) fire_frames );
+}
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s fromsim TRACE [PRESSES [SEED]]\n", name );
+	printf ( "       %s info TRACE\n", name );
+	printf ( "       %s dump TRACE\n", name );
+	printf ( "       %s at TRACE TICKS\n", name );
+	printf ( "       %s replay TRACE [LOOPS [AUTOFIRE_MS]]\n", name );
+}
+
+/**
+ * @brief main function of the input trace tool
+ * @param argc
+ * @param argv
+ * @return 0 on success
+ */
+int main ( int argc, char **argv )
+{
+	InputTrace trace;
+
+	if ( argc < 3 )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	if ( strcmp ( argv[1], "fromsim" ) == 0 )
+	{
+		return FromSim ( argv[2], ( argc > 3 ) ? ( uint32_t ) strtoul ( argv[3], NULL, 0 ) : 1000u,
+		                 ( argc > 4 ) ? ( uint32_t ) strtoul ( argv[4], NULL, 0 ) : 1u );
+	}
+
+	if ( InputTrace_Open ( &trace, argv[2] ) != 0 )
+	{
+		fprintf ( stderr, "%s: not a valid input trace\n", argv[2] );
+		return 1;
+	}
+
+	if ( strcmp ( argv[1], "info" ) == 0 )
+	{
+		Dump ( &trace, false );
+	}
+	else if ( strcmp ( argv[1], "dump" ) == 0 )
+	{
+		Dump ( &trace, true );
+	}
+	else if ( ( strcmp ( argv[1], "at" ) == 0 ) && ( argc == 4 ) )
+	{
+		printf ( "0x%04x\n", InputTrace_StateAt ( &trace, strtoull ( argv[3], NULL, 0 ) ) );
+	}
+	else if ( strcmp ( argv[1], "replay" ) == 0 )
+	{
+		Replay ( &trace, ( argc > 3 ) ? ( uint32_t ) strtoul ( argv[3], NULL, 0 ) : 1u,
+		         ( argc > 4 ) ? ( uint16_t ) strtoul ( argv[4], NULL, 0 ) : 16u );
+	}
+	else
+	{
+		Usage ( argv[0] );
+		InputTrace_Close ( &trace );
+		return 2;
+	}
+
+	InputTrace_Close ( &trace );
+	return 0;
+}
@@ -0,0 +1,354 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    latency_probe.c
+ * @brief   computes latency histograms from a capture of the latency probe pin
+ * @details The firmware built with SNES2DB9_LATENCY_PROBE outputs each marker as burst of pulses,
+ *          the number of pulses identifies the marker (see SNES2DB9_PROBE_xxx). Pulses closer than
+ *          the maximum gap belong to the same burst, a marker is timestamped with its first rising edge.
+ *
+ *          Reported are the LATCH period, LATCH to completed reading, completed reading to DB9 change,
+ *          LATCH to DB9 change and the resulting worst case press to DB9 pin latency. A press is
+ *          sampled by the LATCH following it, so the worst case adds the preceding LATCH period.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "snes2db9.h"
+#include "snes2db9_sim.h"
+#include "snes2db9_capture.h"
+
+#define HISTOGRAM_BUCKETS    32       /**< number of histogram buckets, the last one collects all larger values */
+#define NR_DISTRIBUTIONS     5u       /**< number of latency distributions */
+
+/**
+ * @brief index of the latency distributions
+ */
+enum Distribution
+{
+	DIST_LATCH_PERIOD,                /**< LATCH to LATCH */
+	DIST_LATCH_UPDATE,                /**< LATCH to completed reading */
+	DIST_UPDATE_OUTPUT,               /**< completed reading to DB9 change */
+	DIST_LATCH_OUTPUT,                /**< LATCH to DB9 change */
+	DIST_PRESS_OUTPUT                 /**< worst case press to DB9 change */
+};
+
+/**
+ * @brief growing array of latency values in µs
+ */
+typedef struct
+{
+	uint32_t * values;                /**< value storage */
+	uint32_t   count;                 /**< number of values */
+	uint32_t   capacity;              /**< allocated values */
+} LatencyArray;
+
+/**
+ * @brief analyzer state
+ */
+typedef struct
+{
+	uint64_t     max_gap_ns;                 /**< pulses closer than this belong to the same burst */
+	bool         in_burst;                   /**< a burst has been started */
+	uint64_t     burst_start_ns;             /**< first rising edge of the current burst */
+	uint64_t     burst_fall_ns;              /**< last falling edge of the current burst */
+	uint32_t     burst_pulses;               /**< pulses of the current burst */
+	bool         have_latch;                 /**< a LATCH marker has been seen */
+	uint64_t     latch_ns;                   /**< last LATCH marker */
+	bool         have_period;                /**< the period before latch_ns is known */
+	uint64_t     period_ns;                  /**< LATCH period before latch_ns */
+	bool         have_update;                /**< an update marker has been seen */
+	uint64_t     update_ns;                  /**< last update marker */
+	bool         update_has_latch;           /**< the LATCH of the last update is known */
+	uint64_t     update_latch_ns;            /**< LATCH of the last update */
+	uint64_t     update_period_ns;           /**< LATCH period before the LATCH of the last update, 0 if unknown */
+	uint64_t     markers[4];                 /**< number of LATCH, update and output markers, index 0 counts unknown bursts */
+	LatencyArray dist[NR_DISTRIBUTIONS];     /**< latency distributions */
+} Analyzer;
+
+static Analyzer A;  /**< the analyzer instance */
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s [options] capture.csv|capture.vcd\n", name );
+	printf ( "  --probe NAME       probe channel name or CSV column index (PROBE)\n" );
+	printf ( "  --samplerate HZ    sample rate of CSV captures without time column\n" );
+	printf ( "  --max-gap-ns N     maximum pause between pulses of a marker in ns (10000)\n" );
+	printf ( "  --bucket-us N      histogram bucket width in us (1000)\n" );
+}
+
+/**
+ * @brief          appends a latency value
+ * @param[in, out] array to extend
+ * @param[in]      value_ns to append, stored in µs
+ */
+static void Append ( LatencyArray * array, uint64_t value_ns )
+{
+	if ( array->count == array->capacity )
+	{
+		uint32_t   capacity = ( array->capacity != 0 ) ? ( array->capacity * 2u ) : 1024u;
+		uint32_t * grown = realloc ( array->values, capacity * sizeof ( uint32_t ) );
+
+		if ( grown == NULL )
+		{
+			return;
+		}
+
+		array->values = grown;
+		array->capacity = capacity;
+	}
+
+	array->values[array->count++] = ( uint32_t ) ( ( value_ns + 500u ) / 1000u );
+}
+
+/**
+ * @brief     evaluates a completed marker
+ * @param[in] time_ns of the marker
+ * @param[in] pulses of the marker
+ */
+static void Marker ( uint64_t time_ns, uint32_t pulses )
+{
+	switch ( pulses )
+	{
+		case SNES2DB9_PROBE_LATCH:
+			A.have_period = A.have_latch;
+
+			if ( A.have_latch == true )
+			{
+				A.period_ns = time_ns - A.latch_ns;
+				Append ( &A.dist[DIST_LATCH_PERIOD], A.period_ns );
+			}
+
+			A.have_latch = true;
+			A.latch_ns = time_ns;
+			break;
+
+		case SNES2DB9_PROBE_UPDATE:
+			A.have_update = true;
+			A.update_ns = time_ns;
+			A.update_has_latch = A.have_latch;
+			A.update_latch_ns = A.latch_ns;
+			A.update_period_ns = ( A.have_period == true ) ? A.period_ns : 0;
+
+			if ( A.have_latch == true )
+			{
+				Append ( &A.dist[DIST_LATCH_UPDATE], time_ns - A.latch_ns );
+			}
+
+			break;
+
+		case SNES2DB9_PROBE_OUTPUT:
+			if ( A.have_update == true )
+			{
+				Append ( &A.dist[DIST_UPDATE_OUTPUT], time_ns - A.update_ns );
+			}
+
+			if ( A.update_has_latch == true )
+			{
+				Append ( &A.dist[DIST_LATCH_OUTPUT], time_ns - A.update_latch_ns );
+
+				if ( A.update_period_ns != 0 )
+				{
+					Append ( &A.dist[DIST_PRESS_OUTPUT], time_ns - A.update_latch_ns + A.update_period_ns );
+				}
+			}
+
+			break;
+
+		default:
+			pulses = 0;
+			break;
+	}
+
+	A.markers[pulses]++;
+}
+
+/**
+ * @brief     processes a sample of the probe channel
+ * @param[in] time_ns of the sample
+ * @param[in] level of the probe channel
+ * @param[in] last_level of the probe channel
+ */
+static void Sample ( uint64_t time_ns, bool level, bool last_level )
+{
+	if ( ( level == true ) && ( last_level == false ) )
+	{
+		if ( ( A.in_burst == true ) && ( ( time_ns - A.burst_fall_ns ) <= A.max_gap_ns ) )
+		{
+			A.burst_pulses++;
+		}
+		else
+		{
+			if ( A.in_burst == true )
+			{
+				Marker ( A.burst_start_ns, A.burst_pulses );
+			}
+
+			A.in_burst = true;
+			A.burst_start_ns = time_ns;
+			A.burst_pulses = 1;
+		}
+	}
+	else if ( ( level == false ) && ( last_level == true ) && ( A.in_burst == true ) )
+	{
+		A.burst_fall_ns = time_ns;
+	}
+}
+
+/**
+ * @brief     prints summary and histogram of a latency distribution
+ * @param[in] title of the distribution
+ * @param[in, out] array of values in µs, sorted in place
+ * @param[in] bucket_us is the width of a histogram bucket
+ */
+static void PrintDistribution ( const char * title, LatencyArray * array, uint32_t bucket_us )
+{
+	SimStats stats;
+	uint32_t histogram[HISTOGRAM_BUCKETS] = { 0 };
+	uint32_t idx, bucket, bar;
+
+	if ( array->count == 0 )
+	{
+		printf ( "%s: no samples\n", title );
+		return;
+	}
+
+	Sim_ComputeStats ( array->values, array->count, &stats );
+	printf ( "%s (%u samples)\n", title, array->count );
+	printf ( "  min %.3f ms  median %.3f ms  mean %.3f ms  p99 %.3f ms  max %.3f ms\n",
+	         stats.min / 1000.0, stats.median / 1000.0, stats.mean / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0 );
+
+	for ( idx = 0; idx < array->count; idx++ )
+	{
+		bucket = array->values[idx] / bucket_us;
+		histogram[ ( bucket < HISTOGRAM_BUCKETS ) ? bucket : ( HISTOGRAM_BUCKETS - 1 ) ]++;
+	}
+
+	for ( idx = 0; idx < HISTOGRAM_BUCKETS; idx++ )
+	{
+		if ( histogram[idx] != 0 )
+		{
+			printf ( "  %7.3f..%7.3f%s ms %6u ", ( idx * bucket_us ) / 1000.0, ( ( idx + 1 ) * bucket_us ) / 1000.0,
+			         ( idx == ( HISTOGRAM_BUCKETS - 1 ) ) ? "+" : " ", histogram[idx] );
+
+			for ( bar = 0; bar < ( ( histogram[idx] * 50u ) / array->count ); bar++ )
+			{
+				putchar ( '#' );
+			}
+
+			putchar ( '\n' );
+		}
+	}
+}
+
+/**
+ * @brief main function of the latency probe analyzer
+ * @param argc
+ * @param argv
+ * @return 0 if markers were decoded, 1 if none or unknown bursts were found, 2 on usage errors
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "probe",       required_argument, NULL, 'p' },
+		{ "samplerate",  required_argument, NULL, 'r' },
+		{ "max-gap-ns",  required_argument, NULL, 'g' },
+		{ "bucket-us",   required_argument, NULL, 'b' },
+		{ "help",        no_argument,       NULL, '?' },
+		{ NULL,          0,                 NULL, 0   }
+	};
+	static const char * const titles[NR_DISTRIBUTIONS] =
+	{
+		"LATCH period",
+		"LATCH to completed reading",
+		"completed reading to DB9 change",
+		"LATCH to DB9 change",
+		"worst case press to DB9 change"
+	};
+	const char * names[CAPTURE_CHANNELS];
+	const char * probe = "PROBE";
+	uint64_t     samplerate_hz = 0;
+	uint64_t     time_ns;
+	uint32_t     bucket_us = 1000u;
+	uint32_t     idx;
+	uint8_t      levels;
+	bool         level;
+	bool         last_level = false;
+	Capture      capture;
+	int          opt;
+	memset ( &A, 0, sizeof ( A ) );
+	A.max_gap_ns = 10000u;
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'p': probe = optarg; break;
+			case 'r': samplerate_hz = strtoull ( optarg, NULL, 0 ); break;
+			case 'g': A.max_gap_ns = strtoull ( optarg, NULL, 0 ); break;
+			case 'b': bucket_us = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+
+			default:
+				Usage ( argv[0] );
+				return 2;
+		}
+	}
+
+	if ( ( optind != ( argc - 1 ) ) || ( bucket_us == 0 ) )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	/* the probe is the only channel of interest, its level is read from the LATCH bit: */
+	for ( idx = 0; idx < CAPTURE_CHANNELS; idx++ )
+	{
+		names[idx] = probe;
+	}
+
+	if ( Capture_Open ( &capture, argv[optind], names, samplerate_hz ) != 0 )
+	{
+		return 2;
+	}
+
+	while ( Capture_Next ( &capture, &time_ns, &levels ) == true )
+	{
+		level = ( ( levels & CAPTURE_LATCH ) != 0 );
+		Sample ( time_ns, level, last_level );
+		last_level = level;
+	}
+
+	Capture_Close ( &capture );
+
+	if ( A.in_burst == true )
+	{
+		Marker ( A.burst_start_ns, A.burst_pulses );
+	}
+
+	printf ( "markers: %llu LATCH, %llu completed reading, %llu DB9 change, %llu unknown\n",
+	         ( unsigned long long ) A.markers[SNES2DB9_PROBE_LATCH], ( unsigned long long ) A.markers[SNES2DB9_PROBE_UPDATE],
+	         ( unsigned long long ) A.markers[SNES2DB9_PROBE_OUTPUT], ( unsigned long long ) A.markers[0] );
+
+	for ( idx = 0; idx < NR_DISTRIBUTIONS; idx++ )
+	{
+		PrintDistribution ( titles[idx], &A.dist[idx], bucket_us );
+		free ( A.dist[idx].values );
+	}
+
+	return ( ( A.markers[0] == 0 ) && ( ( A.markers[SNES2DB9_PROBE_LATCH] + A.markers[SNES2DB9_PROBE_UPDATE] + A.markers[SNES2DB9_PROBE_OUTPUT] ) != 0 ) ) ? 0 : 1;
+}
@@ -0,0 +1,446 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    replay_capture.c
+ * @brief   replays a logic analyzer capture of LATCH/CLK/DATA through SNESReader
+ * @details The LATCH and CLK edges of the capture step the reader state machine, a replay HAL
+ *          serves DATA from the capture at a configurable delay after each edge, just like the
+ *          firmware samples after driving the pins. Reported are the decoded frames,
+ *          timing of the bus and the setup/hold margin of DATA around each sample point.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "snes2db9.h"
+#include "snes2db9_capture.h"
+
+#define READER_ST_UPDATE   32        /**< reader state publishing the result, see snes2db9_reader.c */
+#define TRAILER_MASK       0x000Fu   /**< bits 13..16 of the protocol, always released by a SNES pad */
+#define NR_CLOCK_BINS      18u       /**< clocks per frame histogram, the last bin collects longer frames */
+
+/**
+ * @brief running summary of a timing value
+ */
+typedef struct
+{
+	uint64_t count;  /**< number of values */
+	uint64_t min;    /**< minimum value */
+	uint64_t max;    /**< maximum value */
+	double   sum;    /**< sum of all values */
+} TimingStat;
+
+/**
+ * @brief replay state, a single instance because the HAL has no context
+ */
+typedef struct
+{
+	SNESReader reader;                      /**< reader under replay */
+	uint8_t    levels;                      /**< current capture levels */
+	uint64_t   now_ns;                      /**< time of the current HAL calls */
+	bool       pending;                     /**< a read step is scheduled */
+	uint64_t   pending_ns;                  /**< time of the scheduled read step */
+	uint64_t   last_data_change_ns;         /**< last DATA transition */
+	bool       data_changed;                /**< DATA had a transition */
+	bool       hold_open;                   /**< hold margin of the last sample not yet resolved */
+	uint64_t   last_sample_ns;              /**< time of the last DATA sample */
+	uint64_t   latch_rise_ns;               /**< last rising LATCH edge */
+	uint64_t   clk_edge_ns;                 /**< last CLK edge */
+	bool       in_frame;                    /**< a LATCH pulse has been seen */
+	uint32_t   clocks;                      /**< CLK pulses in the current frame */
+	uint64_t   frames;                      /**< decoded frames */
+	uint64_t   trailer_errors;              /**< frames with pressed trailer bits */
+	uint64_t   short_frames;                /**< frames interrupted by LATCH */
+	uint64_t   pin_mismatches;              /**< CLK/LATCH levels differing from the reader */
+	uint64_t   late_samples;                /**< sample points after the next edge */
+	uint64_t   marginal_samples;            /**< samples with setup or hold below the threshold */
+	uint64_t   clock_bins[NR_CLOCK_BINS];   /**< clocks per frame histogram */
+	TimingStat latch_width;                 /**< LATCH high time */
+	TimingStat clk_low;                     /**< CLK low time */
+	TimingStat clk_high;                    /**< CLK high time within a frame */
+	TimingStat frame_period;                /**< time between LATCH pulses */
+	TimingStat setup;                       /**< DATA stable before the sample point */
+	TimingStat hold;                        /**< DATA stable after the sample point */
+	uint32_t   sample_delay_ns;             /**< delay between edge and DATA sample */
+	uint32_t   min_margin_ns;               /**< threshold for marginal samples */
+	bool       print_frames;                /**< print every frame */
+} Replay;
+
+static Replay R;  /**< the single replay instance */
+
+/**
+ * @brief     adds a value to a timing summary
+ * @param[in, out] stat to update
+ * @param[in] value to add
+ */
+static void StatAdd ( TimingStat * stat, uint64_t value )
+{
+	if ( ( stat->count == 0 ) || ( value < stat->min ) )
+	{
+		stat->min = value;
+	}
+
+	if ( value > stat->max )
+	{
+		stat->max = value;
+	}
+
+	stat->sum += ( double ) value;
+	stat->count++;
+}
+
+/**
+ * @brief     prints a timing summary in us
+ * @param[in] title of the value
+ * @param[in] stat to print
+ */
+static void StatPrint ( const char * title, const TimingStat * stat )
+{
+	if ( stat->count == 0 )
+	{
+		printf ( "  %-22s n/a\n", title );
+	}
+	else
+	{
+		printf ( "  %-22s min %10.3f us  mean %10.3f us  max %10.3f us  (%llu)\n", title, stat->min / 1000.0,
+		         stat->sum / ( double ) stat->count / 1000.0, stat->max / 1000.0, ( unsigned long long ) stat->count );
+	}
+}
+
+/**
+ * @brief     replay HAL to set a pin, compares the reader output with the capture
+ * @param[in] pin to set
+ * @param[in] state to set
+ */
+static void ReplaySetPin ( SNES2DB9_Pin pin, SNES2DB9_Pinstate state )
+{
+	uint8_t bit = ( pin == SNES_LATCH ) ? CAPTURE_LATCH : CAPTURE_CLK;
+
+	if ( ( ( state == SNES2DB9_PIN_HIGH ) != ( ( R.levels & bit ) != 0 ) ) && ( R.in_frame ) )
+	{
+		R.pin_mismatches++;
+	}
+}
+
+/**
+ * @brief     replay HAL to read a pin, serves DATA from the capture
+ * @param[in] pin to read
+ * @returns   captured DATA level
+ */
+static SNES2DB9_Pinstate ReplayReadPin ( SNES2DB9_Pin pin )
+{
+	( void ) pin;
+
+	if ( R.data_changed )
+	{
+		StatAdd ( &R.setup, R.now_ns - R.last_data_change_ns );
+
+		if ( ( R.now_ns - R.last_data_change_ns ) < R.min_margin_ns )
+		{
+			R.marginal_samples++;
+		}
+	}
+
+	R.hold_open = true;
+	R.last_sample_ns = R.now_ns;
+	return ( ( R.levels & CAPTURE_DATA ) != 0 ) ? SNES2DB9_PIN_HIGH : SNES2DB9_PIN_LOW;
+}
+
+/**
+ * @brief     prints a decoded frame
+ * @param[in] time_ns of the frame
+ * @param[in] buttons decoded
+ */
+static void PrintFrame ( uint64_t time_ns, uint16_t buttons )
+{
+	static const char * const names[16] = { "t16", "t15", "t14", "t13", "R", "L", "X", "A",
+	                                        "Right", "Left", "Down", "Up", "Start", "Select", "Y", "B"
+	                                      };
+	uint32_t bit;
+	printf ( "%14.6f s  0x%04x ", time_ns / 1e9, buttons );
+
+	for ( bit = 16; bit > 0; bit-- )
+	{
+		if ( ( buttons & ( 1u << ( bit - 1 ) ) ) != 0 )
+		{
+			printf ( " %s", names[bit - 1] );
+		}
+	}
+
+	putchar ( '\n' );
+}
+
+/**
+ * @brief     runs one reader step, publishes the frame after the last read
+ * @param[in] time_ns of the step
+ */
+static void Step ( uint64_t time_ns )
+{
+	R.now_ns = time_ns;
+	( void ) SNESReader_Update ( &R.reader );
+
+	if ( R.reader.state == READER_ST_UPDATE )
+	{
+		uint16_t buttons = SNESReader_Update ( &R.reader );
+		R.frames++;
+
+		if ( ( buttons & TRAILER_MASK ) != 0 )
+		{
+			R.trailer_errors++;
+		}
+
+		if ( R.print_frames )
+		{
+			PrintFrame ( R.latch_rise_ns, buttons );
+		}
+	}
+}
+
+/**
+ * @brief     processes one capture sample
+ * @param[in] time_ns of the sample
+ * @param[in] levels of the sample
+ */
+static void Process ( uint64_t time_ns, uint8_t levels )
+{
+	uint8_t changed = levels ^ R.levels;
+	uint8_t state = R.reader.state;
+
+	if ( R.pending && ( R.pending_ns < time_ns ) )
+	{
+		R.pending = false;
+		Step ( R.pending_ns );
+	}
+
+	if ( R.pending && ( ( changed & ( CAPTURE_LATCH | CAPTURE_CLK ) ) != 0 ) )
+	{
+		/* sample point not reached before the next edge: */
+		R.late_samples++;
+		R.pending = false;
+		Step ( time_ns );
+	}
+
+	if ( ( changed & CAPTURE_DATA ) != 0 )
+	{
+		if ( R.hold_open )
+		{
+			StatAdd ( &R.hold, time_ns - R.last_sample_ns );
+
+			if ( ( time_ns - R.last_sample_ns ) < R.min_margin_ns )
+			{
+				R.marginal_samples++;
+			}
+
+			R.hold_open = false;
+		}
+
+		R.last_data_change_ns = time_ns;
+		R.data_changed = true;
+	}
+
+	R.levels = levels;
+	state = R.reader.state;
+
+	if ( ( changed & CAPTURE_LATCH ) != 0 )
+	{
+		if ( ( levels & CAPTURE_LATCH ) != 0 )
+		{
+			if ( R.in_frame )
+			{
+				StatAdd ( &R.frame_period, time_ns - R.latch_rise_ns );
+				R.clock_bins[ ( R.clocks < NR_CLOCK_BINS ) ? R.clocks : NR_CLOCK_BINS - 1u]++;
+
+				if ( ( state > 0 ) && ( state < READER_ST_UPDATE ) )
+				{
+					R.short_frames++;
+				}
+			}
+
+			R.in_frame = true;
+			R.clocks = 0;
+			R.latch_rise_ns = time_ns;
+			SNESReader_BeginRead ( &R.reader );
+			Step ( time_ns );
+		}
+		else if ( R.in_frame )
+		{
+			StatAdd ( &R.latch_width, time_ns - R.latch_rise_ns );
+
+			if ( R.reader.state == 1 )
+			{
+				R.pending = true;
+				R.pending_ns = time_ns + R.sample_delay_ns;
+			}
+		}
+	}
+
+	if ( ( ( changed & CAPTURE_CLK ) != 0 ) && R.in_frame && ( ( levels & CAPTURE_LATCH ) == 0 ) )
+	{
+		if ( ( levels & CAPTURE_CLK ) == 0 )
+		{
+			if ( R.clocks > 0 )
+			{
+				StatAdd ( &R.clk_high, time_ns - R.clk_edge_ns );
+			}
+
+			R.clocks++;
+
+			/* clock states are even: */
+			if ( ( R.reader.state > 0 ) && ( R.reader.state < READER_ST_UPDATE ) && ( ( R.reader.state % 2 ) == 0 ) )
+			{
+				Step ( time_ns );
+			}
+		}
+		else
+		{
+			StatAdd ( &R.clk_low, time_ns - R.clk_edge_ns );
+
+			/* read states are odd: */
+			if ( ( R.reader.state < READER_ST_UPDATE ) && ( ( R.reader.state % 2 ) == 1 ) )
+			{
+				R.pending = true;
+				R.pending_ns = time_ns + R.sample_delay_ns;
+			}
+		}
+
+		R.clk_edge_ns = time_ns;
+	}
+
+	if ( R.pending && ( R.pending_ns <= time_ns ) )
+	{
+		R.pending = false;
+		Step ( R.pending_ns );
+	}
+}
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s [options] capture.{csv,vcd}\n", name );
+	printf ( "  --latch NAME         LATCH channel name or CSV column (LATCH)\n" );
+	printf ( "  --clk NAME           CLK channel name or CSV column (CLK)\n" );
+	printf ( "  --data NAME          DATA channel name or CSV column (DATA)\n" );
+	printf ( "  --samplerate HZ      sample rate of CSV captures without time column\n" );
+	printf ( "  --sample-delay-ns N  DATA sample point after LATCH falling/CLK rising edges (2000)\n" );
+	printf ( "  --min-margin-ns N    setup/hold threshold for marginal samples (500)\n" );
+	printf ( "  --frames             print every decoded frame\n" );
+}
+
+/**
+ * @brief main function of the capture replay tool
+ * @param argc
+ * @param argv
+ * @return 0 if the capture decodes without protocol errors, 1 otherwise, 2 on usage errors
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "latch",           required_argument, NULL, 'l' },
+		{ "clk",             required_argument, NULL, 'c' },
+		{ "data",            required_argument, NULL, 'd' },
+		{ "samplerate",      required_argument, NULL, 'r' },
+		{ "sample-delay-ns", required_argument, NULL, 's' },
+		{ "min-margin-ns",   required_argument, NULL, 'm' },
+		{ "frames",          no_argument,       NULL, 'f' },
+		{ "help",            no_argument,       NULL, '?' },
+		{ NULL,              0,                 NULL, 0   }
+	};
+	const char * names[CAPTURE_CHANNELS] = { "LATCH", "CLK", "DATA" };
+	uint64_t     samplerate_hz = 0;
+	uint64_t     samples = 0;
+	uint64_t     time_ns;
+	uint8_t      levels;
+	uint32_t     idx;
+	Capture      capture;
+	int          opt;
+	memset ( &R, 0, sizeof ( R ) );
+	R.sample_delay_ns = 2000;
+	R.min_margin_ns = 500;
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'l': names[0] = optarg; break;
+			case 'c': names[1] = optarg; break;
+			case 'd': names[2] = optarg; break;
+			case 'r': samplerate_hz = strtoull ( optarg, NULL, 0 ); break;
+			case 's': R.sample_delay_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'm': R.min_margin_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'f': R.print_frames = true; break;
+
+			default:
+				Usage ( argv[0] );
+				return 2;
+		}
+	}
+
+	if ( optind != ( argc - 1 ) )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	if ( Capture_Open ( &capture, argv[optind], names, samplerate_hz ) != 0 )
+	{
+		return 2;
+	}
+
+	SNESReader_Init ( &R.reader, ReplaySetPin, ReplayReadPin );
+
+	/* the first sample only establishes the levels: */
+	if ( Capture_Next ( &capture, &time_ns, &levels ) )
+	{
+		R.levels = levels;
+		samples++;
+
+		while ( Capture_Next ( &capture, &time_ns, &levels ) )
+		{
+			Process ( time_ns, levels );
+			samples++;
+		}
+	}
+
+	if ( R.pending )
+	{
+		Step ( R.pending_ns );
+	}
+
+	Capture_Close ( &capture );
+	printf ( "%llu samples, %llu frames decoded\n", ( unsigned long long ) samples, ( unsigned long long ) R.frames );
+	printf ( "mismatches: %llu trailer, %llu short frames, %llu CLK/LATCH, %llu late samples, %llu marginal samples\n",
+	         ( unsigned long long ) R.trailer_errors, ( unsigned long long ) R.short_frames, ( unsigned long long ) R.pin_mismatches,
+	         ( unsigned long long ) R.late_samples, ( unsigned long long ) R.marginal_samples );
+	printf ( "timing:\n" );
+	StatPrint ( "LATCH width", &R.latch_width );
+	StatPrint ( "CLK low", &R.clk_low );
+	StatPrint ( "CLK high", &R.clk_high );
+	StatPrint ( "frame period", &R.frame_period );
+	StatPrint ( "DATA setup margin", &R.setup );
+	StatPrint ( "DATA hold margin", &R.hold );
+	printf ( "clocks per frame:" );
+
+	for ( idx = 0; idx < NR_CLOCK_BINS; idx++ )
+	{
+		if ( R.clock_bins[idx] != 0 )
+		{
+			printf ( " %u%s:%llu", idx, ( idx == ( NR_CLOCK_BINS - 1u ) ) ? "+" : "", ( unsigned long long ) R.clock_bins[idx] );
+		}
+	}
+
+	putchar ( '\n' );
+	return ( ( R.trailer_errors + R.short_frames + R.pin_mismatches + R.late_samples ) == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    sim_pipeline.c
+ * @brief   command line front end of the converter pipeline simulator
+ * @details Reports press to pin and press to host latency distributions and missed inputs
+ *          for a given timing configuration.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "snes2db9.h"
+#include "snes2db9_sim.h"
+#include "snes2db9_trace.h"
+
+#define HISTOGRAM_BUCKET_MS  2   /**< width of a histogram bucket */
+#define HISTOGRAM_BUCKETS    32  /**< number of histogram buckets, the last one collects all larger values */
+#define TRACE_RECORDS        65536u  /**< ring buffer size of the VCD trace */
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s [options]\n", name );
+	printf ( "  --tick-us N        timer tick period in us (200)\n" );
+	printf ( "  --db9-ticks N      ticks between DB9 updates (80)\n" );
+	printf ( "  --host-hz N        host sampling rate in Hz (50)\n" );
+	printf ( "  --hal-ns N         duration of a HAL call in ns (10000)\n" );
+	printf ( "  --overhead-ns N    main loop dispatch overhead in ns (5000)\n" );
+	printf ( "  --jitter-us N      maximum extra main loop busy time in us (0)\n" );
+	printf ( "  --pad-delay-ns N   gamepad DATA propagation delay in ns (300)\n" );
+	printf ( "  --presses N        number of simulated presses (1000)\n" );
+	printf ( "  --press-ms MIN:MAX press duration range in ms (20:200)\n" );
+	printf ( "  --gap-ms MIN:MAX   pause range between presses in ms (50:300)\n" );
+	printf ( "  --autofire-ms N    mapper autofire cycle time in ms (16)\n" );
+	printf ( "  --seed N           random seed (1)\n" );
+	printf ( "  --vcd FILE         write all pin activity as VCD waveform\n" );
+	printf ( "  --probe MASK       emit latency probe markers, sum of 2 (latch), 4 (reading complete), 8 (DB9 change)\n" );
+}
+
+/**
+ * @brief     parses a range argument of the form MIN:MAX
+ * @param[in] arg to parse
+ * @param[out] min of range
+ * @param[out] max of range
+ * @returns   true on success
+ */
+static bool ParseRange ( const char * arg, uint16_t * min, uint16_t * max )
+{
+	unsigned int lo, hi;
+
+	if ( ( sscanf ( arg, "%u:%u", &lo, &hi ) != 2 ) || ( lo > hi ) || ( hi > 0xFFFFu ) )
+	{
+		return false;
+	}
+
+	*min = ( uint16_t ) lo;
+	*max = ( uint16_t ) hi;
+	return true;
+}
+
+/**
+ * @brief     prints summary and histogram of a latency distribution
+ * @param[in] title of the distribution
+ * @param[in, out] values in us, sorted in place
+ * @param[in] nr_values in the array
+ */
+static void PrintDistribution ( const char * title, uint32_t * values, uint32_t nr_values )
+{
+	SimStats stats;
+	uint32_t histogram[HISTOGRAM_BUCKETS] = { 0 };
+	uint32_t idx, bucket, bar;
+	Sim_ComputeStats ( values, nr_values, &stats );
+	printf ( "%s (%u samples)\n", title, nr_values );
+	printf ( "  min %.3f ms  median %.3f ms  mean %.3f ms  p99 %.3f ms  max %.3f ms\n",
+	         stats.min / 1000.0, stats.median / 1000.0, stats.mean / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0 );
+
+	for ( idx = 0; idx < nr_values; idx++ )
+	{
+		bucket = values[idx] / ( HISTOGRAM_BUCKET_MS * 1000u );
+		histogram[ ( bucket < HISTOGRAM_BUCKETS ) ? bucket : ( HISTOGRAM_BUCKETS - 1 ) ]++;
+	}
+
+	for ( idx = 0; idx < HISTOGRAM_BUCKETS; idx++ )
+	{
+		if ( histogram[idx] != 0 )
+		{
+			printf ( "  %3u..%3u%s ms %6u ", idx * HISTOGRAM_BUCKET_MS, ( idx + 1 ) * HISTOGRAM_BUCKET_MS,
+			         ( idx == ( HISTOGRAM_BUCKETS - 1 ) ) ? "+" : " ", histogram[idx] );
+
+			for ( bar = 0; bar < ( ( histogram[idx] * 50u ) / nr_values ); bar++ )
+			{
+				putchar ( '#' );
+			}
+
+			putchar ( '\n' );
+		}
+	}
+}
+
+/**
+ * @brief main function of the simulator front end
+ * @param argc
+ * @param argv
+ * @return 0 on success
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "tick-us",      required_argument, NULL, 't' },
+		{ "db9-ticks",    required_argument, NULL, 'd' },
+		{ "host-hz",      required_argument, NULL, 'h' },
+		{ "hal-ns",       required_argument, NULL, 'c' },
+		{ "overhead-ns",  required_argument, NULL, 'o' },
+		{ "jitter-us",    required_argument, NULL, 'j' },
+		{ "pad-delay-ns", required_argument, NULL, 'p' },
+		{ "presses",      required_argument, NULL, 'n' },
+		{ "press-ms",     required_argument, NULL, 'P' },
+		{ "gap-ms",       required_argument, NULL, 'g' },
+		{ "autofire-ms",  required_argument, NULL, 'a' },
+		{ "seed",         required_argument, NULL, 's' },
+		{ "vcd",          required_argument, NULL, 'v' },
+		{ "probe",        required_argument, NULL, 'm' },
+		{ "help",         no_argument,       NULL, '?' },
+		{ NULL,           0,                 NULL, 0   }
+	};
+	SimConfig config;
+	SimResult result;
+	PinTrace  trace;
+	FILE *    vcd = NULL;
+	int opt;
+	Sim_DefaultConfig ( &config );
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 't': config.tick_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ) * 1000u; break;
+			case 'd': config.db9_update_ticks = ( uint16_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'h': config.host_rate_hz = ( uint16_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'c': config.hal_call_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'o': config.task_overhead_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'j': config.loop_jitter_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ) * 1000u; break;
+			case 'p': config.pad_delay_ns = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'n': config.nr_presses = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'a': config.autofire_ms = ( uint16_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 's': config.seed = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'm': config.probe_markers = ( uint8_t ) strtoul ( optarg, NULL, 0 ); break;
+
+			case 'v':
+				vcd = fopen ( optarg, "w" );
+
+				if ( ( vcd == NULL ) || ( PinTrace_Init ( &trace, TRACE_RECORDS, vcd ) != 0 ) )
+				{
+					perror ( optarg );
+					return 1;
+				}
+
+				config.pin_observer = PinTrace_PinObserver;
+				config.input_observer = PinTrace_InputObserver;
+				config.probe_observer = PinTrace_ProbeObserver;
+				config.observer_ctx = &trace;
+				break;
+
+			case 'P':
+				if ( ParseRange ( optarg, &config.min_press_ms, &config.max_press_ms ) == false )
+				{
+					Usage ( argv[0] );
+					return 1;
+				}
+
+				break;
+
+			case 'g':
+				if ( ParseRange ( optarg, &config.min_gap_ms, &config.max_gap_ms ) == false )
+				{
+					Usage ( argv[0] );
+					return 1;
+				}
+
+				break;
+
+			default:
+				Usage ( argv[0] );
+				return 1;
+		}
+	}
+
+	if ( Sim_Run ( &config, &result ) != 0 )
+	{
+		fprintf ( stderr, "invalid configuration\n" );
+		return 1;
+	}
+
+	if ( vcd != NULL )
+	{
+		PinTrace_Free ( &trace );
+
+		if ( fclose ( vcd ) != 0 )
+		{
+			perror ( "vcd" );
+			return 1;
+		}
+	}
+
+	printf ( "simulated %.1f s, %llu ticks, %llu reads, %llu bad reads\n",
+	         result.duration_ns / 1e9, ( unsigned long long ) result.nr_ticks,
+	         ( unsigned long long ) result.nr_reads, ( unsigned long long ) result.nr_bad_reads );
+	printf ( "scheduler: %u missed ticks%s, max backlog %u ticks, max iteration %u timer counts (%.1f us)\n",
+	         result.timing.missed_ticks, ( result.timing.missed_ticks == UINT16_MAX ) ? " (saturated)" : "",
+	         result.timing.max_backlog, result.timing.max_iteration, result.max_iteration_ns / 1e3 );
+	printf ( "presses %u, missed on DB9 pins %u, missed by host %u\n", result.nr_presses, result.nr_missed_pin, result.nr_missed_host );
+	PrintDistribution ( "press to DB9 pin latency", result.pin_latency_us, result.nr_pin_latency );
+	PrintDistribution ( "press to host sample latency", result.host_latency_us, result.nr_host_latency );
+	SimResult_Free ( &result );
+	return 0;
+}
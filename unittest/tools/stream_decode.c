@@ -0,0 +1,504 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    stream_decode.c
+ * @brief   decodes the diagnostic stream of the SNESReader sketch
+ * @details Reads raw UART bytes from a file, a pty or a serial device. Serial devices are switched to
+ *          raw mode at 1 Mbaud. Frames are located by their sync byte and validated with the CRC, the
+ *          decoder resynchronizes after errors. The 32 bit microsecond timestamps are unwrapped.
+ *          The states are written as binary input trace with 1us ticks and the read period
+ *          statistics bound the sampling latency: a change waits at most one period to be read.
+ *          --selftest decodes a synthetic stream with a corrupted and a dropped frame and checks
+ *          the resulting trace.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "snes2db9.h"
+#include "snes2db9_inputtrace.h"
+
+#define MAX_PERIOD_US       20000u  /**< read periods up to this value are kept in the histogram */
+#define DEFAULT_FRAME_US    16000u  /**< SNES polling period stored in the trace for replay */
+#define SELFTEST_FRAMES     2000u   /**< frames of the synthetic stream */
+#define SELFTEST_PERIOD_US  250u    /**< read period of the synthetic stream */
+
+/**
+ * @brief decoder state
+ */
+typedef struct
+{
+	uint8_t          frame[SNESSTREAM_FRAME_SIZE];  /**< frame under reception */
+	uint8_t          length;                        /**< bytes received of the frame */
+	bool             have_frame;                    /**< a frame has been received */
+	uint8_t          sequence;                      /**< sequence number of the last frame */
+	uint32_t         timestamp;                     /**< raw timestamp of the last frame */
+	uint64_t         time;                          /**< unwrapped time of the last frame since the first frame in us */
+	uint16_t         state;                         /**< SNES state of the last frame */
+	uint64_t         frames;                        /**< valid frames */
+	uint64_t         crc_errors;                    /**< frames with CRC errors */
+	uint64_t         lost_frames;                   /**< frames missing in the sequence */
+	uint64_t         skipped_bytes;                 /**< bytes discarded while searching the sync byte */
+	uint32_t         histogram[MAX_PERIOD_US + 1u]; /**< read periods between consecutive frames, last bin for longer ones */
+	uint64_t         periods;                       /**< number of read periods */
+	uint64_t         period_sum;                    /**< sum of the read periods */
+	uint32_t         period_min;                    /**< shortest read period */
+	uint32_t         period_max;                    /**< longest read period */
+	bool             have_change;                   /**< a state change has been seen */
+	uint64_t         change_time;                   /**< time of the last state change */
+	uint64_t         shortest_press;                /**< shortest time a button was held, 0 if none */
+	uint64_t         shortest_release;              /**< shortest time between two presses, 0 if none */
+	bool             quiet;                         /**< print the summary only */
+	InputTraceWriter trace;                         /**< trace output */
+	bool             tracing;                       /**< the trace output is open */
+} Decoder;
+
+static Decoder D;  /**< the decoder instance */
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s [options] file|pty|tty\n", name );
+	printf ( "       %s --selftest\n", name );
+	printf ( "  --count N          stop after N valid frames\n" );
+	printf ( "  --trace FILE       write the states as binary input trace\n" );
+	printf ( "  --frame-us N       SNES polling period stored in the trace (default %u)\n", DEFAULT_FRAME_US );
+	printf ( "  --quiet            print the summary only\n" );
+}
+
+/**
+ * @brief updates the shortest press and release times at a state change
+ */
+static void TrackChange ( void )
+{
+	uint64_t duration = D.time - D.change_time;
+	bool     pressed = ( D.state & ( uint16_t ) ~SNES_TRAILER_MASK ) != 0;
+
+	if ( D.have_change == true )
+	{
+		/* the previous change started a press if buttons were held since then: */
+		if ( pressed == true )
+		{
+			if ( ( D.shortest_press == 0 ) || ( duration < D.shortest_press ) )
+			{
+				D.shortest_press = duration;
+			}
+		}
+		else if ( ( D.shortest_release == 0 ) || ( duration < D.shortest_release ) )
+		{
+			D.shortest_release = duration;
+		}
+	}
+
+	D.have_change = true;
+	D.change_time = D.time;
+}
+
+/**
+ * @brief     accounts a valid frame
+ * @param[in] frame to account
+ */
+static void Account ( const uint8_t * frame )
+{
+	uint32_t timestamp = ( uint32_t ) frame[2] | ( ( uint32_t ) frame[3] << 8 ) | ( ( uint32_t ) frame[4] << 16 ) | ( ( uint32_t ) frame[5] << 24 );
+	uint16_t state = ( uint16_t ) ( frame[6] | ( frame[7] << 8 ) );
+	uint32_t period;
+	uint8_t  lost;
+
+	if ( D.have_frame == true )
+	{
+		/* unsigned difference survives the wrap of micros() after 71 minutes: */
+		period = timestamp - D.timestamp;
+		D.time += period;
+		lost = ( uint8_t ) ( frame[1] - D.sequence - 1u );
+		D.lost_frames += lost;
+
+		/* a gap spans several periods, it tells nothing about the read rate: */
+		if ( lost == 0 )
+		{
+			D.histogram[( period < MAX_PERIOD_US ) ? period : MAX_PERIOD_US]++;
+			D.periods++;
+			D.period_sum += period;
+
+			if ( ( D.periods == 1 ) || ( period < D.period_min ) )
+			{
+				D.period_min = period;
+			}
+
+			if ( period > D.period_max )
+			{
+				D.period_max = period;
+			}
+		}
+
+		if ( state != D.state )
+		{
+			TrackChange();
+		}
+	}
+
+	if ( ( D.tracing == true ) && ( InputTraceWriter_Add ( &D.trace, D.time, state ) != 0 ) )
+	{
+		fprintf ( stderr, "trace write failed\n" );
+		D.tracing = false;
+	}
+
+	D.have_frame = true;
+	D.sequence = frame[1];
+	D.timestamp = timestamp;
+	D.state = state;
+	D.frames++;
+
+	if ( D.quiet == false )
+	{
+		printf ( "seq %3u  time %12llu us  snes 0x%04X\n", frame[1], ( unsigned long long ) D.time, state );
+	}
+}
+
+/**
+ * @brief     processes a received byte
+ * @param[in] byte received
+ * @returns   true if a valid frame was completed
+ */
+static bool Receive ( uint8_t byte )
+{
+	uint8_t idx;
+
+	if ( ( D.length == 0 ) && ( byte != SNESSTREAM_SYNC ) )
+	{
+		D.skipped_bytes++;
+		return false;
+	}
+
+	D.frame[D.length++] = byte;
+
+	if ( D.length < SNESSTREAM_FRAME_SIZE )
+	{
+		return false;
+	}
+
+	if ( SNESTelemetry_Crc8 ( &D.frame[1], SNESSTREAM_FRAME_SIZE - 1u ) != 0 )
+	{
+		D.crc_errors++;
+
+		/* resynchronize on the next sync byte within the frame: */
+		for ( idx = 1; idx < SNESSTREAM_FRAME_SIZE; idx++ )
+		{
+			if ( D.frame[idx] == SNESSTREAM_SYNC )
+			{
+				break;
+			}
+		}
+
+		D.skipped_bytes += idx;
+		D.length = ( uint8_t ) ( SNESSTREAM_FRAME_SIZE - idx );
+		memmove ( D.frame, &D.frame[idx], D.length );
+		return false;
+	}
+
+	D.length = 0;
+	Account ( D.frame );
+	return true;
+}
+
+/**
+ * @brief     returns a percentile of the read periods
+ * @param[in] percent of the periods that are not longer than the result
+ * @returns   read period in us, MAX_PERIOD_US for longer periods
+ */
+static uint32_t Percentile ( uint32_t percent )
+{
+	uint64_t rank = ( ( D.periods * percent ) + 99u ) / 100u;
+	uint64_t seen = 0;
+	uint32_t period;
+
+	for ( period = 0; period < MAX_PERIOD_US; period++ )
+	{
+		seen += D.histogram[period];
+
+		if ( ( seen >= rank ) && ( seen != 0 ) )
+		{
+			break;
+		}
+	}
+
+	return period;
+}
+
+/**
+ * @brief prints the summary
+ */
+static void PrintSummary ( void )
+{
+	printf ( "%llu frames, %llu CRC errors, %llu lost frames, %llu bytes skipped\n",
+	         ( unsigned long long ) D.frames, ( unsigned long long ) D.crc_errors,
+	         ( unsigned long long ) D.lost_frames, ( unsigned long long ) D.skipped_bytes );
+
+	if ( D.periods != 0 )
+	{
+		printf ( "read period us: min %u  mean %.1f  p50 %u  p99 %u  max %u\n", D.period_min,
+		         ( double ) D.period_sum / ( double ) D.periods, Percentile ( 50 ), Percentile ( 99 ), D.period_max );
+		printf ( "sampling latency us: mean %.1f  max %u\n", ( double ) D.period_sum / ( double ) D.periods / 2.0, D.period_max );
+	}
+
+	printf ( "shortest press %llu us, shortest release %llu us\n",
+	         ( unsigned long long ) D.shortest_press, ( unsigned long long ) D.shortest_release );
+}
+
+/**
+ * @brief      encodes a frame like the SNESReader sketch
+ * @param[out] frame to fill
+ * @param[in]  sequence number
+ * @param[in]  timestamp in us
+ * @param[in]  state bitcoded according to SNES_BTNMASK_xxx
+ */
+static void Encode ( uint8_t * frame, uint8_t sequence, uint32_t timestamp, uint16_t state )
+{
+	frame[0] = SNESSTREAM_SYNC;
+	frame[1] = sequence;
+	frame[2] = ( uint8_t ) timestamp;
+	frame[3] = ( uint8_t ) ( timestamp >> 8 );
+	frame[4] = ( uint8_t ) ( timestamp >> 16 );
+	frame[5] = ( uint8_t ) ( timestamp >> 24 );
+	frame[6] = ( uint8_t ) state;
+	frame[7] = ( uint8_t ) ( state >> 8 );
+	frame[8] = SNESTelemetry_Crc8 ( &frame[1], SNESSTREAM_FRAME_SIZE - 2u );
+}
+
+/**
+ * @brief     state of the synthetic stream
+ * @details   B is held for 40 reads every 100 reads, A for 3 reads every 300 reads, so the
+ *            shortest press lasts 3 reads and the shortest release 57 reads.
+ * @param[in] idx of the frame
+ * @returns   state bitcoded according to SNES_BTNMASK_xxx
+ */
+static uint16_t SelftestState ( uint32_t idx )
+{
+	uint16_t state = 0;
+
+	if ( ( idx % 100u ) >= 60u )
+	{
+		state |= SNES_BTNMASK_B;
+	}
+
+	if ( ( idx % 300u ) < 3u )
+	{
+		state |= SNES_BTNMASK_A;
+	}
+
+	return state;
+}
+
+/**
+ * @brief     decodes a synthetic stream and checks the trace
+ * @details   The timestamps start shortly before the 32 bit wrap. Frame 500 is corrupted, frame 1000
+ *            is not sent, frame 1500 is preceded by garbage.
+ * @param[in] path of the trace file
+ * @returns   0 on success, 1 on failure
+ */
+static int Selftest ( const char * path )
+{
+	const uint32_t start = 0xFFFFFFFFu - ( 100u * SELFTEST_PERIOD_US );
+	uint8_t        frame[SNESSTREAM_FRAME_SIZE];
+	InputTrace     trace;
+	uint64_t       time;
+	uint16_t       state;
+	uint16_t       expected = 0;
+	uint32_t       idx;
+	uint32_t       byte;
+	uint32_t       errors = 0;
+
+	if ( InputTraceWriter_Open ( &D.trace, path, 1, DEFAULT_FRAME_US ) != 0 )
+	{
+		perror ( path );
+		return 1;
+	}
+
+	D.tracing = true;
+
+	for ( idx = 0; idx < SELFTEST_FRAMES; idx++ )
+	{
+		Encode ( frame, ( uint8_t ) idx, start + ( idx * SELFTEST_PERIOD_US ), SelftestState ( idx ) );
+
+		if ( idx == 500u )
+		{
+			frame[6] ^= 0x80u;
+		}
+
+		if ( idx == 1500u )
+		{
+			( void ) Receive ( 0x00 );
+			( void ) Receive ( SNESSTREAM_SYNC );
+		}
+
+		if ( idx != 1000u )
+		{
+			for ( byte = 0; byte < SNESSTREAM_FRAME_SIZE; byte++ )
+			{
+				( void ) Receive ( frame[byte] );
+			}
+		}
+	}
+
+	( void ) InputTraceWriter_Close ( &D.trace, D.time );
+	D.tracing = false;
+	PrintSummary();
+	errors += ( D.frames != ( SELFTEST_FRAMES - 2u ) ) ? 1u : 0u;
+	errors += ( D.crc_errors != 2u ) ? 1u : 0u;
+	errors += ( D.lost_frames != 2u ) ? 1u : 0u;
+	errors += ( ( D.period_min != SELFTEST_PERIOD_US ) || ( D.period_max != SELFTEST_PERIOD_US ) ) ? 1u : 0u;
+	errors += ( D.shortest_press != ( 3u * SELFTEST_PERIOD_US ) ) ? 1u : 0u;
+	errors += ( D.shortest_release != ( 57u * SELFTEST_PERIOD_US ) ) ? 1u : 0u;
+
+	if ( InputTrace_Open ( &trace, path ) != 0 )
+	{
+		fprintf ( stderr, "%s: cannot read trace\n", path );
+		return 1;
+	}
+
+	/* every change of the stream must be in the trace at the time of its frame, except the dropped ones: */
+	for ( idx = 0; idx < SELFTEST_FRAMES; idx++ )
+	{
+		if ( ( idx == 500u ) || ( idx == 1000u ) || ( SelftestState ( idx ) == expected ) )
+		{
+			continue;
+		}
+
+		expected = SelftestState ( idx );
+
+		if ( ( InputTrace_NextChange ( &trace, &time, &state ) == false ) || ( time != ( ( uint64_t ) idx * SELFTEST_PERIOD_US ) ) || ( state != expected ) )
+		{
+			fprintf ( stderr, "trace mismatch at frame %u\n", idx );
+			errors++;
+			break;
+		}
+	}
+
+	InputTrace_Close ( &trace );
+	printf ( "selftest %s\n", ( errors == 0 ) ? "passed" : "FAILED" );
+	return ( errors == 0 ) ? 0 : 1;
+}
+
+/**
+ * @brief main function of the stream decoder
+ * @param argc
+ * @param argv
+ * @return 0 if valid frames were decoded, 1 otherwise, 2 on usage errors
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "count",    required_argument, NULL, 'n' },
+		{ "trace",    required_argument, NULL, 't' },
+		{ "frame-us", required_argument, NULL, 'f' },
+		{ "quiet",    no_argument,       NULL, 'q' },
+		{ "selftest", no_argument,       NULL, 's' },
+		{ "help",     no_argument,       NULL, '?' },
+		{ NULL,       0,                 NULL, 0   }
+	};
+	uint64_t       count = 0;
+	const char *   trace_path = NULL;
+	uint32_t       frame_us = DEFAULT_FRAME_US;
+	bool           selftest = false;
+	uint8_t        buffer[256];
+	ssize_t        nr_read;
+	ssize_t        idx;
+	struct termios tio;
+	int            fd;
+	int            opt;
+	memset ( &D, 0, sizeof ( D ) );
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'n': count = strtoull ( optarg, NULL, 0 ); break;
+			case 't': trace_path = optarg; break;
+			case 'f': frame_us = ( uint32_t ) strtoul ( optarg, NULL, 0 ); break;
+			case 'q': D.quiet = true; break;
+			case 's': selftest = true; break;
+
+			default:
+				Usage ( argv[0] );
+				return 2;
+		}
+	}
+
+	if ( selftest == true )
+	{
+		D.quiet = true;
+		return Selftest ( ( trace_path != NULL ) ? trace_path : "stream_selftest.s2dt" );
+	}
+
+	if ( ( optind != ( argc - 1 ) ) || ( frame_us == 0 ) )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	fd = open ( argv[optind], O_RDONLY | O_NOCTTY );
+
+	if ( fd < 0 )
+	{
+		perror ( argv[optind] );
+		return 2;
+	}
+
+	if ( ( isatty ( fd ) != 0 ) && ( tcgetattr ( fd, &tio ) == 0 ) )
+	{
+		cfmakeraw ( &tio );
+		( void ) cfsetispeed ( &tio, B1000000 );
+		( void ) cfsetospeed ( &tio, B1000000 );
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		( void ) tcsetattr ( fd, TCSANOW, &tio );
+	}
+
+	if ( trace_path != NULL )
+	{
+		if ( InputTraceWriter_Open ( &D.trace, trace_path, 1, frame_us ) != 0 )
+		{
+			perror ( trace_path );
+			close ( fd );
+			return 2;
+		}
+
+		D.tracing = true;
+	}
+
+	while ( ( ( count == 0 ) || ( D.frames < count ) ) && ( ( nr_read = read ( fd, buffer, sizeof ( buffer ) ) ) > 0 ) )
+	{
+		for ( idx = 0; ( idx < nr_read ) && ( ( count == 0 ) || ( D.frames < count ) ); idx++ )
+		{
+			( void ) Receive ( buffer[idx] );
+		}
+
+		fflush ( stdout );
+	}
+
+	close ( fd );
+
+	if ( ( D.tracing == true ) && ( InputTraceWriter_Close ( &D.trace, D.time ) != 0 ) )
+	{
+		fprintf ( stderr, "%s: trace write failed\n", trace_path );
+	}
+
+	PrintSummary();
+	return ( D.frames != 0 ) ? 0 : 1;
+}
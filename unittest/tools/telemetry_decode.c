@@ -0,0 +1,202 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    telemetry_decode.c
+ * @brief   decodes the telemetry stream of the ATtiny84 firmware
+ * @details Reads raw UART bytes from a file, a pty or a serial device. Frames are located by their
+ *          sync byte and validated with the CRC, the decoder resynchronizes after errors.
+ *          Serial devices are switched to raw mode, the baud rate (5000) has to be set beforehand,
+ *          e.g. with stty.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "snes2db9.h"
+
+/**
+ * @brief decoder state
+ */
+typedef struct
+{
+	uint8_t  frame[SNESTELEMETRY_FRAME_SIZE];  /**< frame under reception */
+	uint8_t  length;                           /**< bytes received of the frame */
+	bool     have_sequence;                    /**< a frame has been received */
+	uint8_t  sequence;                         /**< sequence number of the last frame */
+	uint64_t frames;                           /**< valid frames */
+	uint64_t crc_errors;                       /**< frames with CRC errors */
+	uint64_t lost_frames;                      /**< frames missing in the sequence */
+	uint64_t skipped_bytes;                    /**< bytes discarded while searching the sync byte */
+	bool     quiet;                            /**< print the summary only */
+} Decoder;
+
+static Decoder D;  /**< the decoder instance */
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s [options] file|pty|tty\n", name );
+	printf ( "  --count N          stop after N valid frames\n" );
+	printf ( "  --quiet            print the summary only\n" );
+}
+
+/**
+ * @brief     prints a valid frame
+ * @param[in] frame to print
+ */
+static void PrintFrame ( const uint8_t * frame )
+{
+	printf ( "seq %3u  snes 0x%04X  db9 0x%02X  status 0x%02X  missed %5u  backlog %3u  iteration %5u\n",
+	         frame[1], ( unsigned int ) ( frame[2] | ( frame[3] << 8 ) ), frame[4], frame[5],
+	         ( unsigned int ) ( frame[6] | ( frame[7] << 8 ) ), frame[8], ( unsigned int ) ( frame[9] | ( frame[10] << 8 ) ) );
+}
+
+/**
+ * @brief     processes a received byte
+ * @param[in] byte received
+ * @returns   true if a valid frame was completed
+ */
+static bool Receive ( uint8_t byte )
+{
+	uint8_t idx;
+
+	if ( ( D.length == 0 ) && ( byte != SNESTELEMETRY_SYNC ) )
+	{
+		D.skipped_bytes++;
+		return false;
+	}
+
+	D.frame[D.length++] = byte;
+
+	if ( D.length < SNESTELEMETRY_FRAME_SIZE )
+	{
+		return false;
+	}
+
+	if ( SNESTelemetry_Crc8 ( &D.frame[1], SNESTELEMETRY_FRAME_SIZE - 1u ) != 0 )
+	{
+		D.crc_errors++;
+
+		/* resynchronize on the next sync byte within the frame: */
+		for ( idx = 1; idx < SNESTELEMETRY_FRAME_SIZE; idx++ )
+		{
+			if ( D.frame[idx] == SNESTELEMETRY_SYNC )
+			{
+				break;
+			}
+		}
+
+		D.skipped_bytes += idx;
+		D.length = ( uint8_t ) ( SNESTELEMETRY_FRAME_SIZE - idx );
+		memmove ( D.frame, &D.frame[idx], D.length );
+		return false;
+	}
+
+	if ( D.have_sequence == true )
+	{
+		D.lost_frames += ( uint8_t ) ( D.frame[1] - D.sequence - 1u );
+	}
+
+	D.have_sequence = true;
+	D.sequence = D.frame[1];
+	D.frames++;
+	D.length = 0;
+
+	if ( D.quiet == false )
+	{
+		PrintFrame ( D.frame );
+	}
+
+	return true;
+}
+
+/**
+ * @brief main function of the telemetry decoder
+ * @param argc
+ * @param argv
+ * @return 0 if valid frames were decoded, 1 otherwise, 2 on usage errors
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "count", required_argument, NULL, 'n' },
+		{ "quiet", no_argument,       NULL, 'q' },
+		{ "help",  no_argument,       NULL, '?' },
+		{ NULL,    0,                 NULL, 0   }
+	};
+	uint64_t       count = 0;
+	uint8_t        buffer[256];
+	ssize_t        nr_read;
+	ssize_t        idx;
+	struct termios tio;
+	int            fd;
+	int            opt;
+	memset ( &D, 0, sizeof ( D ) );
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'n': count = strtoull ( optarg, NULL, 0 ); break;
+			case 'q': D.quiet = true; break;
+
+			default:
+				Usage ( argv[0] );
+				return 2;
+		}
+	}
+
+	if ( optind != ( argc - 1 ) )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	fd = open ( argv[optind], O_RDONLY | O_NOCTTY );
+
+	if ( fd < 0 )
+	{
+		perror ( argv[optind] );
+		return 2;
+	}
+
+	if ( ( isatty ( fd ) != 0 ) && ( tcgetattr ( fd, &tio ) == 0 ) )
+	{
+		cfmakeraw ( &tio );
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		( void ) tcsetattr ( fd, TCSANOW, &tio );
+	}
+
+	while ( ( ( count == 0 ) || ( D.frames < count ) ) && ( ( nr_read = read ( fd, buffer, sizeof ( buffer ) ) ) > 0 ) )
+	{
+		for ( idx = 0; ( idx < nr_read ) && ( ( count == 0 ) || ( D.frames < count ) ); idx++ )
+		{
+			( void ) Receive ( buffer[idx] );
+		}
+
+		fflush ( stdout );
+	}
+
+	close ( fd );
+	printf ( "%llu frames, %llu CRC errors, %llu lost frames, %llu bytes skipped\n",
+	         ( unsigned long long ) D.frames, ( unsigned long long ) D.crc_errors,
+	         ( unsigned long long ) D.lost_frames, ( unsigned long long ) D.skipped_bytes );
+	return ( D.frames != 0 ) ? 0 : 1;
+}
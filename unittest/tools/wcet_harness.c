@@ -0,0 +1,392 @@
+/**
+ * SNES to DB9 Joystick converter
+ *
+ * (c) 2020 by Matthias Arndt <marndt@asmsoftware.de>
+ * http://www.asmsoftware.de/
+ *
+ * The MIT License applies to this software. See COPYING for details.
+ *
+ * @file    wcet_harness.c
+ * @brief   cycle count and WCET regression harness for the ATtiny84 firmware using simavr
+ * @details The firmware must be built with -DSNES2DB9_WCET_PROBE=ON.
+ *          - interrupt service routines are measured from vector entry to the RETI re-enabling interrupts
+ *          - tasks are measured between the GPIOR0 markers written by the main loop,
+ *            cycles spent in interrupts during a task are excluded
+ *          - delayed reader ticks are counted like the missed_ticks of SNESScheduler: the scheduler queues the ticks
+ *            and replays ReaderTask() back to back, so a run starting more than one tick after the previous run
+ *            delays all ticks but the last one
+ *          - flash and RAM usage are parsed from the avr-size output of the print-size step
+ *          The harness fails if any budget is exceeded.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_io.h>
+#include <avr_ioport.h>
+
+#define GPIOR0_DATA_ADDR     0x33  /**< GPIOR0 in data space of the ATtiny84 */
+#define NR_VECTORS           17    /**< interrupt vectors of the ATtiny84 */
+#define VECTOR_SIZE          2     /**< bytes per vector, RJMP */
+#define VECTOR_TIM0_COMPA    9     /**< timer tick interrupt */
+
+#define WCET_READER_BEGIN    0x20  /**< marker: ReaderTask() starts, see main.c */
+#define WCET_READER_END      0x21  /**< marker: ReaderTask() ends */
+#define WCET_DB9_BEGIN       0x30  /**< marker: DB9UpdateTask() starts */
+#define WCET_DB9_END         0x31  /**< marker: DB9UpdateTask() ends */
+
+/**
+ * @brief worst case statistics of a measured code section
+ */
+typedef struct
+{
+	uint64_t count;   /**< number of executions */
+	uint64_t max;     /**< worst case cycles */
+	uint64_t total;   /**< sum of cycles for the average */
+} Section;
+
+/**
+ * @brief measurement state
+ */
+typedef struct
+{
+	avr_t *  avr;                      /**< simulated controller */
+	Section  isr[NR_VECTORS];          /**< per vector ISR statistics */
+	Section  reader;                   /**< ReaderTask() statistics */
+	Section  db9;                      /**< DB9UpdateTask() statistics */
+	uint64_t tick_load_max;            /**< worst tick ISR plus the following ReaderTask() */
+	uint64_t isr_cycles;               /**< cycles spent in ISRs so far */
+	uint64_t last_tick_isr;            /**< cycles of the most recent tick ISR */
+	int      isr_vector;               /**< vector currently executing, -1 in main context */
+	uint64_t isr_start;                /**< cycle of ISR entry */
+	uint64_t reader_start;             /**< cycle of ReaderTask() entry */
+	uint64_t reader_isr;               /**< ISR cycles at ReaderTask() entry */
+	uint64_t db9_start;                /**< cycle of DB9UpdateTask() entry */
+	uint64_t db9_isr;                  /**< ISR cycles at DB9UpdateTask() entry */
+	uint32_t ticks_since_reader;       /**< tick ISRs since the last ReaderTask() */
+	uint64_t delayed_ticks;            /**< ticks whose ReaderTask() started only after the following tick */
+} Measurement;
+
+static Measurement M;  /**< the single measurement instance */
+
+/**
+ * @brief     records a section execution
+ * @param[in, out] section to update
+ * @param[in] cycles of the execution
+ */
+static void Record ( Section * section, uint64_t cycles )
+{
+	section->count++;
+	section->total += cycles;
+
+	if ( cycles > section->max )
+	{
+		section->max = cycles;
+	}
+}
+
+/**
+ * @brief     simavr write hook of GPIOR0, decodes the task markers of main.c
+ * @param[in] avr simulated controller
+ * @param[in] addr written
+ * @param[in] v value written
+ * @param[in] param unused
+ */
+static void MarkerWrite ( struct avr_t * avr, avr_io_addr_t addr, uint8_t v, void * param )
+{
+	uint64_t net;
+	( void ) addr;
+	( void ) param;
+
+	switch ( v )
+	{
+		case WCET_READER_BEGIN:
+			if ( M.ticks_since_reader > 1 )
+			{
+				M.delayed_ticks += M.ticks_since_reader - 1;
+			}
+
+			M.ticks_since_reader = 0;
+			M.reader_start = avr->cycle;
+			M.reader_isr = M.isr_cycles;
+			break;
+
+		case WCET_READER_END:
+			net = ( avr->cycle - M.reader_start ) - ( M.isr_cycles - M.reader_isr );
+			Record ( &M.reader, net );
+
+			if ( ( M.last_tick_isr + net ) > M.tick_load_max )
+			{
+				M.tick_load_max = M.last_tick_isr + net;
+			}
+
+			break;
+
+		case WCET_DB9_BEGIN:
+			M.db9_start = avr->cycle;
+			M.db9_isr = M.isr_cycles;
+			break;
+
+		case WCET_DB9_END:
+			Record ( &M.db9, ( avr->cycle - M.db9_start ) - ( M.isr_cycles - M.db9_isr ) );
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief      parses the berkeley format output of avr-size
+ * @param[in]  filename of the avr-size output
+ * @param[out] flash used, text plus data
+ * @param[out] ram used, data plus bss
+ * @returns    0 on success
+ */
+static int ParseSize ( const char * filename, unsigned long * flash, unsigned long * ram )
+{
+	char line[256];
+	unsigned long text, data, bss;
+	FILE * f = fopen ( filename, "r" );
+
+	if ( f == NULL )
+	{
+		return -1;
+	}
+
+	while ( fgets ( line, sizeof ( line ), f ) != NULL )
+	{
+		if ( sscanf ( line, " %lu %lu %lu", &text, &data, &bss ) == 3 )
+		{
+			*flash = text + data;
+			*ram = data + bss;
+			fclose ( f );
+			return 0;
+		}
+	}
+
+	fclose ( f );
+	return -1;
+}
+
+/**
+ * @brief     checks a value against its budget and reports it
+ * @param[in] name of the value
+ * @param[in] value measured
+ * @param[in] budget allowed, 0 disables the check
+ * @returns   1 if the budget is exceeded, 0 otherwise
+ */
+static int Check ( const char * name, uint64_t value, uint64_t budget )
+{
+	int failed = ( ( budget != 0 ) && ( value > budget ) ) ? 1 : 0;
+	printf ( "%-28s %10llu", name, ( unsigned long long ) value );
+
+	if ( budget != 0 )
+	{
+		printf ( "  budget %llu %s", ( unsigned long long ) budget, ( failed != 0 ) ? "EXCEEDED" : "ok" );
+	}
+
+	printf ( "\n" );
+	return failed;
+}
+
+/**
+ * @brief     prints usage information
+ * @param[in] name of the program
+ */
+static void Usage ( const char * name )
+{
+	printf ( "usage: %s --elf FILE [options]\n", name );
+	printf ( "  --size FILE          avr-size output for flash/RAM checks\n" );
+	printf ( "  --seconds N          simulated run time in s (5)\n" );
+	printf ( "  --data-high          leave SNES DATA high (no buttons), default is all buttons pressed\n" );
+	printf ( "  --tick-budget N      cycles for tick ISR plus ReaderTask (800)\n" );
+	printf ( "  --isr-budget N       cycles for any ISR (200)\n" );
+	printf ( "  --db9-budget N       cycles for DB9UpdateTask (1600)\n" );
+	printf ( "  --max-delayed N      tolerated delayed reader ticks (0)\n" );
+	printf ( "  --flash-budget N     bytes of flash (8192)\n" );
+	printf ( "  --ram-budget N       bytes of static RAM (384)\n" );
+}
+
+/**
+ * @brief main function of the WCET harness
+ * @param argc
+ * @param argv
+ * @return 0 if all budgets are met
+ */
+int main ( int argc, char **argv )
+{
+	static const struct option options[] =
+	{
+		{ "elf",          required_argument, NULL, 'e' },
+		{ "size",         required_argument, NULL, 'z' },
+		{ "seconds",      required_argument, NULL, 's' },
+		{ "data-high",    no_argument,       NULL, 'H' },
+		{ "tick-budget",  required_argument, NULL, 't' },
+		{ "isr-budget",   required_argument, NULL, 'i' },
+		{ "db9-budget",   required_argument, NULL, 'd' },
+		{ "max-delayed",  required_argument, NULL, 'o' },
+		{ "flash-budget", required_argument, NULL, 'f' },
+		{ "ram-budget",   required_argument, NULL, 'r' },
+		{ NULL,           0,                 NULL, 0   }
+	};
+	const char *   elf_name = NULL;
+	const char *   size_name = NULL;
+	double         seconds = 5.0;
+	int            data_low = 1;
+	uint64_t       tick_budget = 800;
+	uint64_t       isr_budget = 200;
+	uint64_t       db9_budget = 1600;
+	uint64_t       max_delayed = 0;
+	uint64_t       flash_budget = 8192;
+	uint64_t       ram_budget = 384;
+	unsigned long  flash = 0, ram = 0;
+	elf_firmware_t firmware;
+	uint64_t       end_cycle;
+	uint64_t       before;
+	int            state = cpu_Running;
+	int            failed = 0;
+	int            opt;
+	int            vec;
+	char           name[32];
+
+	while ( ( opt = getopt_long ( argc, argv, "", options, NULL ) ) != -1 )
+	{
+		switch ( opt )
+		{
+			case 'e': elf_name = optarg; break;
+			case 'z': size_name = optarg; break;
+			case 's': seconds = strtod ( optarg, NULL ); break;
+			case 'H': data_low = 0; break;
+			case 't': tick_budget = strtoull ( optarg, NULL, 0 ); break;
+			case 'i': isr_budget = strtoull ( optarg, NULL, 0 ); break;
+			case 'd': db9_budget = strtoull ( optarg, NULL, 0 ); break;
+			case 'o': max_delayed = strtoull ( optarg, NULL, 0 ); break;
+			case 'f': flash_budget = strtoull ( optarg, NULL, 0 ); break;
+			case 'r': ram_budget = strtoull ( optarg, NULL, 0 ); break;
+			default: Usage ( argv[0] ); return 2;
+		}
+	}
+
+	if ( elf_name == NULL )
+	{
+		Usage ( argv[0] );
+		return 2;
+	}
+
+	memset ( &firmware, 0, sizeof ( firmware ) );
+
+	if ( elf_read_firmware ( elf_name, &firmware ) != 0 )
+	{
+		fprintf ( stderr, "cannot read %s\n", elf_name );
+		return 2;
+	}
+
+	memset ( &M, 0, sizeof ( M ) );
+	M.isr_vector = -1;
+	M.avr = avr_make_mcu_by_name ( "attiny84" );
+
+	if ( M.avr == NULL )
+	{
+		fprintf ( stderr, "simavr lacks ATtiny84 support\n" );
+		return 2;
+	}
+
+	avr_init ( M.avr );
+	avr_load_firmware ( M.avr, &firmware );
+	/* clock_prescale_set(clock_div_2) in main.c, 800 cycles per 200µs tick: */
+	M.avr->frequency = 4000000;
+	avr_register_io_write ( M.avr, GPIOR0_DATA_ADDR, MarkerWrite, NULL );
+
+	if ( data_low != 0 )
+	{
+		/* every button pressed exercises the longest reader and mapper paths: */
+		avr_raise_irq ( avr_io_getirq ( M.avr, AVR_IOCTL_IOPORT_GETIRQ ( 'B' ), 2 ), 0 );
+	}
+
+	end_cycle = ( uint64_t ) ( seconds * M.avr->frequency );
+
+	while ( ( M.avr->cycle < end_cycle ) && ( state != cpu_Done ) && ( state != cpu_Crashed ) )
+	{
+		before = M.avr->cycle;
+		state = avr_run ( M.avr );
+
+		if ( ( M.isr_vector < 0 ) && ( M.avr->pc != 0 ) && ( M.avr->pc < ( NR_VECTORS * VECTOR_SIZE ) ) )
+		{
+			/* interrupt accepted, conservative by the instruction executed before: */
+			M.isr_vector = ( int ) ( M.avr->pc / VECTOR_SIZE );
+			M.isr_start = before;
+		}
+		else if ( ( M.isr_vector >= 0 ) && ( M.avr->sreg[S_I] != 0 ) )
+		{
+			uint64_t cycles = M.avr->cycle - M.isr_start;
+			Record ( &M.isr[M.isr_vector], cycles );
+			M.isr_cycles += cycles;
+
+			if ( M.isr_vector == VECTOR_TIM0_COMPA )
+			{
+				M.last_tick_isr = cycles;
+				M.ticks_since_reader++;
+			}
+
+			M.isr_vector = -1;
+		}
+	}
+
+	if ( state == cpu_Crashed )
+	{
+		fprintf ( stderr, "firmware crashed at pc 0x%04x\n", ( unsigned int ) M.avr->pc );
+		return 2;
+	}
+
+	printf ( "simulated %.2f s, %llu cycles\n", M.avr->cycle / ( double ) M.avr->frequency, ( unsigned long long ) M.avr->cycle );
+
+	for ( vec = 1; vec < NR_VECTORS; vec++ )
+	{
+		if ( M.isr[vec].count != 0 )
+		{
+			snprintf ( name, sizeof ( name ), "ISR vector %d worst cycles", vec );
+			failed |= Check ( name, M.isr[vec].max, isr_budget );
+		}
+	}
+
+	if ( ( M.reader.count == 0 ) || ( M.db9.count == 0 ) )
+	{
+		fprintf ( stderr, "no task markers seen, build the firmware with -DSNES2DB9_WCET_PROBE=ON\n" );
+		return 2;
+	}
+
+	printf ( "ReaderTask runs %llu, average %llu cycles\n", ( unsigned long long ) M.reader.count, ( unsigned long long ) ( M.reader.total / M.reader.count ) );
+	failed |= Check ( "ReaderTask worst cycles", M.reader.max, 0 );
+	failed |= Check ( "tick ISR + ReaderTask", M.tick_load_max, tick_budget );
+	printf ( "DB9UpdateTask runs %llu, average %llu cycles\n", ( unsigned long long ) M.db9.count, ( unsigned long long ) ( M.db9.total / M.db9.count ) );
+	failed |= Check ( "DB9UpdateTask worst cycles", M.db9.max, db9_budget );
+	failed |= Check ( "delayed reader ticks", M.delayed_ticks, 0 );
+
+	if ( M.delayed_ticks > max_delayed )
+	{
+		printf ( "delayed reader ticks exceed the tolerated %llu\n", ( unsigned long long ) max_delayed );
+		failed = 1;
+	}
+
+	if ( size_name != NULL )
+	{
+		if ( ParseSize ( size_name, &flash, &ram ) != 0 )
+		{
+			fprintf ( stderr, "cannot parse %s\n", size_name );
+			return 2;
+		}
+
+		failed |= Check ( "flash bytes", flash, flash_budget );
+		failed |= Check ( "static RAM bytes", ram, ram_budget );
+	}
+
+	printf ( "%s\n", ( failed != 0 ) ? "WCET budgets EXCEEDED" : "WCET budgets met" );
+	return failed;
+}